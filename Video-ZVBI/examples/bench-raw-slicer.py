@@ -0,0 +1,180 @@
+#!/usr/bin/python3
+#
+#  Copyright (C) 2020 Tom Zoerner
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+#
+
+# Description:
+#
+#   Benchmark comparing the built-in slicer of class Zvbi.RawDec (enabled
+#   via option "fast_slicer") with the slicer of libzvbi. The script
+#   synthesizes raw VBI frames containing Teletext, VPS and WSS with random
+#   payload and slight noise, then measures the number of frames sliced per
+#   second by each implementation. Payload returned by each slicer is
+#   compared with the generated data. Call with option --help for a list
+#   of options.
+
+import argparse
+import random
+import time
+import Zvbi
+
+SAMPLING_RATE = 13500000
+BYTES_PER_LINE = 800
+OFFSET = 64
+BLACK = 60
+WHITE = 180
+
+def bits_lsb(data):
+    return [(byte >> bit) & 1 for byte in data for bit in range(8)]
+
+def bits_msb(data):
+    return [(byte >> (7 - bit)) & 1 for byte in data for bit in range(8)]
+
+def bits_of(value, count):
+    return [(value >> (count - 1 - bit)) & 1 for bit in range(count)]
+
+def render(elements, rate, start_ns, line):
+    # Render a sequence of elements (0 or 1) at the given rate into the line,
+    # with transitions smoothed over half an element.
+    period = SAMPLING_RATE / rate
+    first = start_ns * 1e-9 * SAMPLING_RATE - OFFSET
+    for idx in range(BYTES_PER_LINE):
+        pos = (idx - first) / period
+        elem = int(pos // 1)
+        if 0 <= elem < len(elements):
+            level = elements[elem]
+            frac = pos - elem
+            if frac < 0.25 and elem > 0:
+                level = elements[elem - 1] + (level - elements[elem - 1]) * (frac + 0.25) * 2
+            elif frac > 0.75 and elem + 1 < len(elements):
+                level = level + (elements[elem + 1] - level) * (frac - 0.75) * 2
+            line[idx] = int(BLACK + (WHITE - BLACK) * level)
+
+def noise(line):
+    for idx in range(BYTES_PER_LINE):
+        line[idx] = max(0, min(255, line[idx] + random.randint(-4, 4)))
+
+def gen_ttx():
+    data = bytes(random.randrange(256) for _ in range(42))
+    elements = bits_lsb(b'\x55\x55\x27' + data)
+    return data, elements
+
+def gen_vps():
+    data = bytes(random.randrange(256) for _ in range(13))
+    elements = bits_of(0xAAAA8A99, 32)
+    for bit in bits_msb(data):
+        elements += [bit, 1 - bit]
+    return data, elements
+
+def gen_wss():
+    value = random.randrange(1 << 14)
+    elements = bits_of(0x1F1C71C7, 29) + bits_of(0x1E3C1F, 24)
+    for bit in range(14):
+        bit = (value >> bit) & 1
+        elements += [bit] * 3 + [1 - bit] * 3
+    return bytes([value & 0xFF, value >> 8]), elements
+
+def gen_frame(par):
+    # Frame with teletext on all lines 7..22 and 320..335, except for VPS
+    # on line 16 and WSS on line 23 (which is the last line of the first field)
+    frame = bytearray([BLACK] * (BYTES_PER_LINE * (par.count_a + par.count_b)))
+    expected = {}
+    for row in range(par.count_a + par.count_b):
+        if row < par.count_a:
+            line_no = par.start_a + row
+        else:
+            line_no = par.start_b + row - par.count_a
+        if line_no == 16:
+            data, elements = gen_vps()
+            ident = Zvbi.VBI_SLICED_VPS
+            render(elements, 5000000, 7600, memoryview(frame)[row * BYTES_PER_LINE:])
+        elif line_no == 23:
+            data, elements = gen_wss()
+            ident = Zvbi.VBI_SLICED_WSS_625
+            render(elements, 5000000, 11000, memoryview(frame)[row * BYTES_PER_LINE:])
+        else:
+            data, elements = gen_ttx()
+            ident = Zvbi.VBI_SLICED_TELETEXT_B
+            render(elements, 6937500, 10300, memoryview(frame)[row * BYTES_PER_LINE:])
+        noise(memoryview(frame)[row * BYTES_PER_LINE : (row + 1) * BYTES_PER_LINE])
+        expected[line_no] = (ident, data)
+    return bytes(frame), expected
+
+def check(results, expected_frames):
+    good = 0
+    for sliced_buf, expected in zip(results, expected_frames):
+        for data, ident, line_no in sliced_buf:
+            exp = expected.get(line_no)
+            if exp and (ident & exp[0]) and (data[:len(exp[1])] == exp[1]):
+                good += 1
+    return good
+
+def bench(par, raw_frames, fast, threads):
+    if threads:
+        raw_dec = Zvbi.ParallelRawDec(par, threads=threads, fast_slicer=fast)
+    else:
+        raw_dec = Zvbi.RawDec(par, fast_slicer=fast)
+    raw_dec.add_services(Zvbi.VBI_SLICED_TELETEXT_B | Zvbi.VBI_SLICED_VPS | Zvbi.VBI_SLICED_WSS_625)
+
+    results = raw_dec.decode_many(raw_frames)   # warm-up, also used for checking
+    start = time.perf_counter()
+    for _ in range(opt.loops):
+        raw_dec.decode_many(raw_frames)
+    duration = time.perf_counter() - start
+    return raw_dec.slicer, results, duration
+
+def main_func():
+    par = Zvbi.RawParams()
+    par.scanning = 625
+    par.sampling_format = Zvbi.VBI_PIXFMT_YUV420
+    par.sampling_rate = SAMPLING_RATE
+    par.bytes_per_line = BYTES_PER_LINE
+    par.offset = OFFSET
+    par.start_a = 7
+    par.count_a = 17
+    par.start_b = 320
+    par.count_b = 16
+    par.interlaced = False
+    par.synchronous = True
+
+    random.seed(opt.seed)
+    frames = [gen_frame(par) for _ in range(opt.frames)]
+    raw_frames = b''.join(frame for frame, expected in frames)
+    expected_frames = [expected for frame, expected in frames]
+    total_lines = sum(len(expected) for expected in expected_frames)
+
+    for fast in (False, True):
+        name, results, duration = bench(par, raw_frames, fast, opt.threads)
+        good = check(results, expected_frames)
+        rate = opt.frames * opt.loops / duration
+        print("%-8s %10.0f frames/s  %6.2f us/line  correct lines: %d of %d"
+              % (name, rate, duration * 1e6 / (opt.loops * total_lines), good, total_lines))
+
+def ParseCmdOptions():
+    global opt
+    parser = argparse.ArgumentParser(description='Benchmark of the built-in raw slicer vs. libzvbi')
+    parser.add_argument("--frames", type=int, default=50, help="Number of distinct synthesized frames")
+    parser.add_argument("--loops", type=int, default=100, help="Number of times all frames are sliced")
+    parser.add_argument("--threads", type=int, default=0, help="Use Zvbi.ParallelRawDec with the given number of threads")
+    parser.add_argument("--seed", type=int, default=1, help="Seed for generating random payload")
+    opt = parser.parse_args()
+
+try:
+    ParseCmdOptions()
+    main_func()
+except KeyboardInterrupt:
+    pass
@@ -214,36 +214,11 @@ def decode_sliced(sliced_buf):
 #  Sliced, binary
 #
 
-# hysterical compatibility
-ServiceWidth = {
-        Zvbi.VBI_SLICED_TELETEXT_B:  (42, 0),
-        Zvbi.VBI_SLICED_CAPTION_625: (2, 1),
-        Zvbi.VBI_SLICED_VPS:         (13, 2),
-        Zvbi.VBI_SLICED_WSS_625:     (2, 3),
-        Zvbi.VBI_SLICED_WSS_CPR1204: (3, 4),
-        Zvbi.VBI_SLICED_CAPTION_525: (2, 7),
-}
-
-last_ts = 0.0
+sliced_writer = None
 
 def binary_sliced(sliced_buf):
-    global last_ts
-
-    ts = sliced_buf.timestamp - last_ts if (last_ts > 0.0) else 0.04
-    outfile.write(bytes("%f\n" % ts, 'ascii'))
-
-    outfile.write(bytes([len(sliced_buf)]))
-
-    for data, slc_id, line in sliced_buf:
-        if ServiceWidth.get(slc_id) and (ServiceWidth.get(slc_id)[0] > 0):
-            outfile.write(bytes([ServiceWidth.get(slc_id)[1],
-                                 line & 0xFF,
-                                 line >> 8]))
-            data_len = ServiceWidth.get(slc_id)[0]
-            outfile.write(data[0 : data_len])
-            last_ts = sliced_buf.timestamp
-
-    outfile.flush()
+    # flush after each frame, as output is usually piped into decode.py
+    sliced_writer.write(sliced_buf, flush=True)
 
 
 def binary_ts_pes(packet, user_data=None):
@@ -395,7 +370,10 @@ def main_func():
         mx.set_pes_packet_size (0, 8* 184)
 
     global outfile
+    global sliced_writer
     outfile = open(sys.stdout.fileno(), "wb")
+    if opt.sliced:
+        sliced_writer = Zvbi.SlicedWriter(outfile)
 
     mainloop(cap)
 
@@ -44,91 +44,8 @@ dvb = None
 idl = None
 xds = None
 
-# Reader for old test/capture --sliced output.
 infile = None
 outfile = None
-read_elapsed = False
-
-# ------- slicer.c -----------------------------------------------------------
-#
-# Read one frame's worth of sliced data (written by decode.pl)
-# from a file or pipe (not used in demo mode)
-#
-def read_sliced():
-    global read_elapsed
-
-    # Read timestamp: newline-terminated string
-    buf = ""
-    while True:
-        b = infile.read(1)
-        if len(b) == 0:  # EOF
-            return None
-        c = "%c" % b[0]
-        if c == '\n':
-            break
-        buf += c
-
-    # Time in seconds since last frame.
-    try:
-        dt = float(buf)
-        if (dt < 0.0):
-            dt = -dt
-    except:
-        print("invalid timestamp in input: " % dt, file=sys.stderr)
-        sys.exit(1)
-
-    timestamp = read_elapsed
-    read_elapsed += dt
-
-    # Read number of sliced lines
-    n_lines = infile.read(1)[0]
-    assert(n_lines >= 0) # "invalid line count in input"
-
-    # Read sliced data: each record consists of:
-    # - type ID (0..7)
-    # - line index (LSB)
-    # - line index (MSB)
-    # - data x N: where N is implied by type ID
-    sliced = []
-    for n in range(0, n_lines):
-        index = infile.read(1)[0]
-        assert(index >= 0) # "invalid index"
-
-        line = (infile.read(1)[0]
-                   + 256 * infile.read(1)[0]) & 0xFFF
-
-        if index == 0:
-            slc_id = Zvbi.VBI_SLICED_TELETEXT_B
-            data = infile.read(42)
-
-        elif index == 1:
-            slc_id = Zvbi.VBI_SLICED_CAPTION_625
-            data = infile.read(2)
-
-        elif index == 2:
-            slc_id = Zvbi.VBI_SLICED_VPS
-            data = infile.read(13)
-
-        elif index == 3:
-            slc_id = Zvbi.VBI_SLICED_WSS_625
-            data = infile.read(2)
-
-        elif index == 4:
-            slc_id = Zvbi.VBI_SLICED_WSS_CPR1204
-            data = infile.read(3)
-
-        elif index == 7:
-            slc_id = Zvbi.VBI_SLICED_CAPTION_525
-            data = infile.read(2)
-
-        else:
-            print("Oops! Unknown data type index in sliced VBI file", file=sys.stderr)
-            exit(1)
-
-        sliced.append([data, slc_id, line])
-
-    return (n_lines, timestamp, sliced)
-
 
 def _vbi_pfc_block_dump(pgno, stream, app_id, block, binary):
     print("PFC pgno=%x stream=%u id=%u size=%u" %
@@ -763,16 +680,10 @@ def pes_mainloop():
 
 
 def old_mainloop():
-    # one one frame's worth of sliced data from the input stream or file
-    while True:
-        sl = read_sliced()
-        if sl:
-            (n_lines, timestamp, sliced) = sl
-
-            # pass the full frame's data to the decoder
-            decode_vbi(sliced, n_lines, timestamp, 0)
-        else:
-            break
+    # read one frame's worth of sliced data at a time from the input stream or file
+    for sliced_buf in Zvbi.SlicedReader(infile):
+        # pass the full frame's data to the decoder
+        decode_vbi(sliced_buf, len(sliced_buf), sliced_buf.timestamp, 0)
 
     print("\rEnd of stream", file=sys.stderr)
 
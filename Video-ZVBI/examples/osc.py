@@ -237,12 +237,12 @@ def draw_dec(nchars, sld=None, slid=None, slin=None):
 
 
 def draw_plot():
-    start = src_w * draw_row.get()
+    # the raw buffer is exported as 2-dimensional array of lines x samples
+    line = memoryview(raw1)[draw_row.get()]
 
     Poly = []
     r = src_h + 0 + dst_h
-    for i in range(0, src_w):
-        y = raw1[start + i]
+    for i, y in enumerate(line):
         Poly.append(i)
         Poly.append(r - y * dst_h//256)
 
@@ -21,8 +21,8 @@ import platform
 import shutil
 import re
 
-if sys.version_info[0] != 3:
-    print("This script requires Python 3")
+if sys.version_info < (3, 7):
+    print("This script requires Python 3.7 or later")
     exit()
 
 # ----------------------------------------------------------------------------
@@ -64,6 +64,9 @@ extralibs = []      # extra libraries to link against
 # BSD requires listing libraries that libzvbi depends on
 if re.match(r'bsd$', platform.system(), flags=re.IGNORECASE):
     extralibs += ['pthread', 'png', 'z']
+else:
+    # required by the background capture thread (before glibc 2.34)
+    extralibs += ['pthread']
 
 # ----------------------------------------------------------------------------
 
@@ -91,8 +94,16 @@ ext = Extension('Zvbi',
                                  'src/zvbi_proxy.c',
                                  'src/zvbi_capture.c',
                                  'src/zvbi_capture_buf.c',
+                                 'src/zvbi_compact_sliced_buf.c',
+                                 'src/zvbi_capture_thread.c',
+                                 'src/zvbi_capture_set.c',
+                                 'src/zvbi_capture_replay.c',
+                                 'src/zvbi_sliced_file.c',
+                                 'src/zvbi_async.c',
                                  'src/zvbi_raw_dec.c',
+                                 'src/zvbi_raw_encoder.c',
                                  'src/zvbi_raw_params.c',
+                                 'src/zvbi_raw_slicer.c',
                                  'src/zvbi_service_dec.c',
                                  'src/zvbi_page.c',
                                  'src/zvbi_event_types.c',
@@ -136,5 +147,5 @@ setup(name='Zvbi',
       platforms=['posix'],
       ext_modules=[ext],
       cmdclass={'clean': MyClean},
-      python_requires='>=3.2',
+      python_requires='>=3.7',
      )
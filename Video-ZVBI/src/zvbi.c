@@ -20,7 +20,13 @@
 #include "zvbi_proxy.h"
 #include "zvbi_capture.h"
 #include "zvbi_capture_buf.h"
+#include "zvbi_compact_sliced_buf.h"
+#include "zvbi_capture_thread.h"
+#include "zvbi_capture_set.h"
+#include "zvbi_sliced_file.h"
+#include "zvbi_async.h"
 #include "zvbi_raw_dec.h"
+#include "zvbi_raw_encoder.h"
 #include "zvbi_raw_params.h"
 #include "zvbi_service_dec.h"
 #include "zvbi_page.h"
@@ -55,6 +61,9 @@ static PyObject * ZvbiError;
 
 /*
  * Invoke callback for log messages.
+ *
+ * Note the callback may be invoked from within capture functions, which are
+ * called with the GIL released. Therefore the GIL has to be acquired here.
  */
 static void
 zvbi_xs_log_callback( vbi_log_mask           level,
@@ -64,6 +73,7 @@ zvbi_xs_log_callback( vbi_log_mask           level,
 {
     unsigned cb_idx = PVOID2UINT(vp_cb_idx);
     PyObject * cb_obj;
+    PyGILState_STATE gstate = PyGILState_Ensure();
 
     if ( (cb_idx < ZVBI_MAX_CB_COUNT) &&
          ((cb_obj = ZvbiCallbacks.log[cb_idx].p_cb) != NULL) )
@@ -85,6 +95,7 @@ zvbi_xs_log_callback( vbi_log_mask           level,
             PyErr_Print();
         }
     }
+    PyGILState_Release(gstate);
 }
 
 // ---------------------------------------------------------------------------
@@ -633,8 +644,14 @@ PyInit_Zvbi(void)
 
     if ((PyInit_Capture(module, ZvbiError) < 0) ||
         (PyInit_CaptureBuf(module, ZvbiError) < 0) ||
+        (PyInit_CompactSlicedBuf(module, ZvbiError) < 0) ||
+        (PyInit_CaptureThread(module, ZvbiError) < 0) ||
+        (PyInit_CaptureSet(module, ZvbiError) < 0) ||
+        (PyInit_SlicedFile(module, ZvbiError) < 0) ||
+        (PyInit_Async(module, ZvbiError) < 0) ||
         (PyInit_Proxy(module, ZvbiError) < 0) ||
         (PyInit_RawDec(module, ZvbiError) < 0) ||
+        (PyInit_RawEncoder(module, ZvbiError) < 0) ||
         (PyInit_RawParams(module, ZvbiError) < 0) ||
         (PyInit_ServiceDec(module, ZvbiError) < 0) ||
         (PyInit_EventTypes(module, ZvbiError) < 0) ||
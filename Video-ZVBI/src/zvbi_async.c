@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include "Python.h"
+
+#include <libzvbi.h>
+
+#include "zvbi_async.h"
+
+// ---------------------------------------------------------------------------
+//  Helper functions for integration with the asyncio event loop
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    PyObject_HEAD
+    PyObject * anext_func;
+} ZvbiAsyncIterObj;
+
+// Reference to the "asyncio" module, imported on first use
+static PyObject * ZvbiAsync_Module;
+
+// Dict mapping file descriptors with a registered reader to the waiting future
+static PyObject * ZvbiAsync_ActiveFds;
+
+/*
+ * Indices of elements within the state tuple shared by the callbacks that
+ * are registered at the event loop for waiting on a file descriptor
+ */
+enum {
+    ZVBI_ASYNC_STATE_LOOP,
+    ZVBI_ASYNC_STATE_FD,
+    ZVBI_ASYNC_STATE_FUTURE,
+    ZVBI_ASYNC_STATE_POLL,
+};
+
+// ---------------------------------------------------------------------------
+
+static PyObject *
+ZvbiAsync_GetModule(void)
+{
+    if (ZvbiAsync_Module == NULL) {
+        ZvbiAsync_Module = PyImport_ImportModule("asyncio");
+    }
+    return ZvbiAsync_Module;
+}
+
+/*
+ * Return a new reference to the event loop running in the current thread,
+ * or raise RuntimeError if there is none.
+ */
+PyObject *
+ZvbiAsync_GetRunningLoop(void)
+{
+    PyObject * asyncio = ZvbiAsync_GetModule();
+    if (asyncio == NULL) {
+        return NULL;
+    }
+    return PyObject_CallMethod(asyncio, "get_running_loop", NULL);
+}
+
+/*
+ * Return a new asyncio.Queue with the given maximum size (0 for unlimited)
+ */
+PyObject *
+ZvbiAsync_NewQueue(int maxsize)
+{
+    PyObject * asyncio = ZvbiAsync_GetModule();
+    if (asyncio == NULL) {
+        return NULL;
+    }
+    return PyObject_CallMethod(asyncio, "Queue", "(i)", maxsize);
+}
+
+/*
+ * Complete the given future with the result of a poll function call: the
+ * result is stored unless it is None; an exception raised by the function is
+ * stored in the future instead. Returns TRUE if the future was completed.
+ */
+static int
+ZvbiAsync_PollFuture(PyObject * future, PyObject * poll_func)
+{
+    PyObject * cb_rslt;
+    int done = FALSE;
+
+    PyObject * result = PyObject_CallObject(poll_func, NULL);
+    if (result != NULL) {
+        if (result != Py_None) {
+            cb_rslt = PyObject_CallMethod(future, "set_result", "(O)", result);
+            Py_XDECREF(cb_rslt);
+            done = TRUE;
+        }
+        Py_DECREF(result);
+    }
+    else {
+        PyObject * exc_type, * exc_value, * exc_tb;
+        PyErr_Fetch(&exc_type, &exc_value, &exc_tb);
+        PyErr_NormalizeException(&exc_type, &exc_value, &exc_tb);
+        if (exc_tb != NULL) {
+            PyException_SetTraceback(exc_value, exc_tb);
+        }
+        cb_rslt = PyObject_CallMethod(future, "set_exception", "(O)", exc_value);
+        Py_XDECREF(cb_rslt);
+        Py_XDECREF(exc_type);
+        Py_XDECREF(exc_value);
+        Py_XDECREF(exc_tb);
+        done = TRUE;
+    }
+    return done;
+}
+
+/*
+ * Callback invoked by the event loop when the file descriptor is readable
+ */
+static PyObject *
+ZvbiAsync_OnReadable(PyObject * state, PyObject * unused)
+{
+    PyObject * future = PyTuple_GET_ITEM(state, ZVBI_ASYNC_STATE_FUTURE);
+    PyObject * poll_func = PyTuple_GET_ITEM(state, ZVBI_ASYNC_STATE_POLL);
+
+    // future may have been cancelled while its done-callback is still pending
+    PyObject * done = PyObject_CallMethod(future, "done", NULL);
+    if (done == NULL) {
+        return NULL;
+    }
+    int is_done = PyObject_IsTrue(done);
+    Py_DECREF(done);
+
+    if (is_done == 0) {
+        ZvbiAsync_PollFuture(future, poll_func);
+    }
+    if (PyErr_Occurred() != NULL) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+/*
+ * Callback invoked by the event loop when the future is done or cancelled
+ */
+static PyObject *
+ZvbiAsync_OnDone(PyObject * state, PyObject * future)
+{
+    PyObject * loop = PyTuple_GET_ITEM(state, ZVBI_ASYNC_STATE_LOOP);
+    PyObject * fd = PyTuple_GET_ITEM(state, ZVBI_ASYNC_STATE_FD);
+
+    // the reader may already have been taken over by a following call
+    if (PyDict_GetItemWithError(ZvbiAsync_ActiveFds, fd) != future) {
+        if (PyErr_Occurred() != NULL) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+    if (PyDict_DelItem(ZvbiAsync_ActiveFds, fd) < 0) {
+        return NULL;
+    }
+    return PyObject_CallMethod(loop, "remove_reader", "(O)", fd);
+}
+
+static PyMethodDef ZvbiAsync_OnReadableDef =
+    {"_on_readable", (PyCFunction) ZvbiAsync_OnReadable, METH_NOARGS, NULL };
+static PyMethodDef ZvbiAsync_OnDoneDef =
+    {"_on_done", (PyCFunction) ZvbiAsync_OnDone, METH_O, NULL };
+
+/*
+ * Return a future that completes with the first result of the given poll
+ * function other than None. The function is called once immediately, and
+ * then each time the given file descriptor becomes readable. Only one
+ * such future can be pending per file descriptor, as the event loop
+ * supports only one reader callback per descriptor.
+ */
+PyObject *
+ZvbiAsync_AwaitFd(int fd, PyObject * poll_func)
+{
+    PyObject * loop = ZvbiAsync_GetRunningLoop();
+    if (loop == NULL) {
+        return NULL;
+    }
+    PyObject * future = PyObject_CallMethod(loop, "create_future", NULL);
+    if (future == NULL) {
+        Py_DECREF(loop);
+        return NULL;
+    }
+
+    // a previous future that is done but whose done-callback is still pending
+    // (e.g. after cancellation by a timeout) does not block a new call
+    PyObject * fd_obj = PyLong_FromLong(fd);
+    int is_active = -1;
+
+    if (fd_obj != NULL) {
+        PyObject * prev = PyDict_GetItemWithError(ZvbiAsync_ActiveFds, fd_obj);
+        if (prev != NULL) {
+            PyObject * done = PyObject_CallMethod(prev, "done", NULL);
+            if (done != NULL) {
+                is_active = !PyObject_IsTrue(done);
+                Py_DECREF(done);
+            }
+        }
+        else if (PyErr_Occurred() == NULL) {
+            is_active = 0;
+        }
+    }
+
+    if (is_active > 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Another coroutine is already waiting for data "
+                        "from the same device");
+    }
+    else if ((is_active == 0) && !ZvbiAsync_PollFuture(future, poll_func) && (PyErr_Occurred() == NULL)) {
+        PyObject * on_readable = NULL;
+        PyObject * on_done = NULL;
+        PyObject * cb_rslt = NULL;
+
+        PyObject * state = Py_BuildValue("(OOOO)", loop, fd_obj, future, poll_func);
+        if (state != NULL) {
+            on_readable = PyCFunction_New(&ZvbiAsync_OnReadableDef, state);
+            on_done = PyCFunction_New(&ZvbiAsync_OnDoneDef, state);
+            Py_DECREF(state);
+        }
+        if ((on_readable != NULL) && (on_done != NULL)) {
+            cb_rslt = PyObject_CallMethod(loop, "add_reader", "OO", fd_obj, on_readable);
+            if (cb_rslt != NULL) {
+                Py_DECREF(cb_rslt);
+                if (PyDict_SetItem(ZvbiAsync_ActiveFds, fd_obj, future) == 0) {
+                    cb_rslt = PyObject_CallMethod(future, "add_done_callback", "(O)", on_done);
+                    Py_XDECREF(cb_rslt);
+                }
+            }
+        }
+        Py_XDECREF(on_readable);
+        Py_XDECREF(on_done);
+    }
+    Py_XDECREF(fd_obj);
+    Py_DECREF(loop);
+
+    if (PyErr_Occurred() != NULL) {
+        Py_DECREF(future);
+        future = NULL;
+    }
+    return future;
+}
+
+// ---------------------------------------------------------------------------
+// Generic asynchronous iterator: each step returns the awaitable result of a
+// function call
+
+static void
+ZvbiAsyncIter_dealloc(ZvbiAsyncIterObj *self)
+{
+    Py_XDECREF(self->anext_func);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *
+ZvbiAsyncIter_AIter(ZvbiAsyncIterObj *self)
+{
+    Py_INCREF(self);
+    return (PyObject *) self;
+}
+
+static PyObject *
+ZvbiAsyncIter_ANext(ZvbiAsyncIterObj *self)
+{
+    return PyObject_CallObject(self->anext_func, NULL);
+}
+
+static PyAsyncMethods ZvbiAsyncIterAsyncDef =
+{
+    .am_aiter = (unaryfunc) ZvbiAsyncIter_AIter,
+    .am_anext = (unaryfunc) ZvbiAsyncIter_ANext,
+};
+
+static PyTypeObject ZvbiAsyncIterTypeDef =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "Zvbi.AsyncIter",
+    .tp_doc = PyDoc_STR("Asynchronous iterator over captured data or events"),
+    .tp_basicsize = sizeof(ZvbiAsyncIterObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = NULL,  // instantiated internally only
+    .tp_dealloc = (destructor) ZvbiAsyncIter_dealloc,
+    .tp_as_async = &ZvbiAsyncIterAsyncDef,
+};
+
+PyObject *
+ZvbiAsync_NewIter(PyObject * anext_func)
+{
+    ZvbiAsyncIterObj * self = PyObject_New(ZvbiAsyncIterObj, &ZvbiAsyncIterTypeDef);
+    if (self != NULL) {
+        self->anext_func = anext_func;
+        Py_INCREF(anext_func);
+    }
+    return (PyObject *) self;
+}
+
+int PyInit_Async(PyObject * module, PyObject * error_base)
+{
+    if (PyType_Ready(&ZvbiAsyncIterTypeDef) < 0) {
+        return -1;
+    }
+    ZvbiAsync_ActiveFds = PyDict_New();
+    if (ZvbiAsync_ActiveFds == NULL) {
+        return -1;
+    }
+    return 0;
+}
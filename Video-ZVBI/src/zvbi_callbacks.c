@@ -64,25 +64,6 @@ ZvbiCallbacks_free_by_idx( ZvbiCallacksEntry_t * p_list, unsigned idx )
     p_list[idx].p_obj = NULL;
 }
 
-unsigned
-ZvbiCallbacks_free_by_ptr( ZvbiCallacksEntry_t * p_list, void * p_obj,
-                           PyObject * p_cb, PyObject * p_data, vbi_bool cmp_data )
-{
-    unsigned match_idx = ZVBI_MAX_CB_COUNT;
-
-    for (unsigned idx = 0; idx < ZVBI_MAX_CB_COUNT; idx++) {
-        if ((p_list[idx].p_obj == p_obj) &&
-            (p_list[idx].p_cb == p_cb) &&
-            (!cmp_data || (p_list[idx].p_data == p_data)))
-        {
-            ZvbiCallbacks_free_by_idx(p_list, idx);
-
-            match_idx = idx;
-        }
-    }
-    return match_idx;
-}
-
 void
 ZvbiCallbacks_free_by_obj( ZvbiCallacksEntry_t * p_list, void * p_obj )
 {
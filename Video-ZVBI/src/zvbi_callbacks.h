@@ -35,8 +35,6 @@ typedef struct
 
 typedef struct
 {
-    ZvbiCallacksEntry_t    event[ZVBI_MAX_CB_COUNT];
-    ZvbiCallacksEntry_t    search[ZVBI_MAX_CB_COUNT];
     ZvbiCallacksEntry_t    log[ZVBI_MAX_CB_COUNT];
 } ZvbiCallacks_t;
 
@@ -45,7 +43,6 @@ extern ZvbiCallacks_t ZvbiCallbacks;
 unsigned ZvbiCallbacks_alloc( ZvbiCallacksEntry_t * p_list, PyObject * p_cb, PyObject * p_data, void * p_obj );
 
 void ZvbiCallbacks_free_by_idx( ZvbiCallacksEntry_t * p_list, unsigned idx );
-unsigned ZvbiCallbacks_free_by_ptr( ZvbiCallacksEntry_t * p_list, void * p_obj, PyObject * p_cb, PyObject * p_data, vbi_bool cmp_data );
 void ZvbiCallbacks_free_by_obj( ZvbiCallacksEntry_t * p_list, void * p_obj );
 
 vbi_bool ZvbiCallbacks_CheckObj( PyObject * cb_obj );
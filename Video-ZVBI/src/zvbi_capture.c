@@ -15,6 +15,7 @@
 #define PY_SSIZE_T_CLEAN
 #include "Python.h"
 
+#include <sys/time.h>
 #include <libzvbi.h>
 
 #include "zvbi_capture.h"
@@ -22,47 +23,289 @@
 #include "zvbi_raw_dec.h"
 #include "zvbi_raw_params.h"
 #include "zvbi_capture_buf.h"
+#include "zvbi_async.h"
+#include "zvbi_capture_replay.h"
 
 // ---------------------------------------------------------------------------
 //  VBI Capturing & Slicing
 // ---------------------------------------------------------------------------
 
+/*
+ * Upper limits of the intervals of the delivery delay histogram in seconds;
+ * the last histogram entry counts all delays above the last limit.
+ */
+static const double ZvbiCapture_DelayBins[] = {
+    0.001, 0.002, 0.005, 0.010, 0.020, 0.050, 0.100, 0.200, 0.500, 1.0
+};
+#define DELAY_BIN_CNT (sizeof(ZvbiCapture_DelayBins) / sizeof(ZvbiCapture_DelayBins[0]) + 1)
+
+typedef struct {
+    unsigned long frames;
+    unsigned long timeouts;
+    unsigned long errors;
+    unsigned long missed_frames;
+    unsigned long delay_hist[DELAY_BIN_CNT];
+    double delay_max;
+    double last_timestamp;
+    double frame_period;
+} ZvbiCaptureStats;
+
 typedef struct {
     PyObject_HEAD
     vbi_capture * ctx;
+    ZvbiCaptureReplay * replay;  // replaces "ctx" when replaying from a file
     unsigned services;
+    PyThread_type_lock lock;
+    vbi_bool background;    // TRUE while capturing is done by Zvbi.CaptureThread
+    ZvbiCaptureBufList pull_bufs;  // buffers returned by "pull", see below
+    ZvbiCaptureStats stats;
 } ZvbiCaptureObj;
 
-static PyObject * ZvbiCaptureError;
-static PyObject * ZvbiCaptureTimeout;
+PyObject * ZvbiCaptureError;
+PyObject * ZvbiCaptureTimeout;
+
+#if defined (NAMED_TUPLE_GC_BUG)
+static PyTypeObject ZvbiCaptureStatsTypeBuf;
+static PyTypeObject * const ZvbiCaptureStatsType = &ZvbiCaptureStatsTypeBuf;
+#else
+static PyTypeObject * ZvbiCaptureStatsType = NULL;
+#endif
 
 /*
- * This counter is used for limiting the life-time of capture buffer objects
- * that refer to static storage in the libzvbi library. The object encapsulates
- * a copy of the counter at the time of duration. The counter is incremented
- * for any operation that invalidates the capture buffer content. Access to the
- * object is rejected via exception when the counter no longer matches the
- * object.
+ * Member "pull_bufs" tracks capture buffer objects that refer to static
+ * storage in the libzvbi library. Before any operation that overwrites the
+ * capture buffer content of the respective device, buffer objects that are
+ * still referenced by the application get a private copy of their content.
+ * Buffers of other devices remain unaffected. The list is only modified
+ * while holding the GIL and the lock of the capture object (see below).
  */
-static int ZvbiCapture_PulledBufferSeqNo;
 
 // ---------------------------------------------------------------------------
 
 static PyObject *
 ZvbiCapture_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
-    return type->tp_alloc(type, 0);
+    ZvbiCaptureObj * self = (ZvbiCaptureObj *) type->tp_alloc(type, 0);
+    if (self != NULL) {
+        self->lock = PyThread_allocate_lock();
+        if (self->lock == NULL) {
+            Py_DECREF(self);
+            self = (ZvbiCaptureObj *) PyErr_NoMemory();
+        }
+    }
+    return (PyObject *) self;
 }
 
 static void
 ZvbiCapture_dealloc(ZvbiCaptureObj *self)
 {
+    // views on detached buffers may still refer to storage of the context
+    ZvbiCaptureBufList_Invalidate(&self->pull_bufs);
+
     if (self->ctx) {
         vbi_capture_delete(self->ctx);
     }
+    if (self->replay) {
+        ZvbiCaptureReplay_Delete(self->replay);
+    }
+    if (self->lock) {
+        PyThread_free_lock(self->lock);
+    }
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
+/*
+ * The capture functions of libzvbi block for up to the given timeout, so they
+ * are called with the GIL released, allowing other threads (e.g. capturing
+ * from other devices) to proceed meanwhile. As a consequence, concurrent use
+ * of the same capture context by multiple Python threads has to be serialized
+ * via a lock per capture object. The GIL is also released while waiting for
+ * the lock, so that a thread blocked on the device does not stall the
+ * interpreter. Note the lock is held until buffers returned by "pull"
+ * functions are wrapped into Python objects, so that a concurrent "pull"
+ * cannot overwrite a buffer before the wrapper was registered.
+ */
+static void
+ZvbiCapture_Lock(ZvbiCaptureObj * self)
+{
+    if (PyThread_acquire_lock(self->lock, NOWAIT_LOCK) == 0) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+}
+
+static void
+ZvbiCapture_Unlock(ZvbiCaptureObj * self)
+{
+    PyThread_release_lock(self->lock);
+}
+
+/*
+ * Reject use of capture functions while the device is read by a background
+ * thread, as the thread's "pull" calls would overwrite returned buffers.
+ */
+static int
+ZvbiCapture_CheckIdle(ZvbiCaptureObj * self)
+{
+    if (self->background) {
+        PyErr_SetString(ZvbiCaptureError, "Capture is in use by a CaptureThread");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Wrappers for the capture functions of libzvbi, which forward the call to
+ * the file replay back-end instead when applicable. Buffer pointers may be
+ * NULL for data that is not requested. Called with the GIL released.
+ */
+static int
+ZvbiCapture_DoRead(ZvbiCaptureObj * self, void * raw, vbi_sliced * sliced,
+                   int * p_n_lines, double * p_timestamp, struct timeval * tv)
+{
+    if (self->replay != NULL) {
+        return ZvbiCaptureReplay_Read(self->replay, raw, sliced, p_n_lines, p_timestamp, tv);
+    }
+    else if (sliced == NULL) {
+        return vbi_capture_read_raw(self->ctx, raw, p_timestamp, tv);
+    }
+    else if (raw == NULL) {
+        return vbi_capture_read_sliced(self->ctx, sliced, p_n_lines, p_timestamp, tv);
+    }
+    else {
+        return vbi_capture_read(self->ctx, raw, sliced, p_n_lines, p_timestamp, tv);
+    }
+}
+
+static int
+ZvbiCapture_DoPull(ZvbiCaptureObj * self, vbi_capture_buffer ** raw,
+                   vbi_capture_buffer ** sliced, struct timeval * tv)
+{
+    if (self->replay != NULL) {
+        return ZvbiCaptureReplay_Pull(self->replay, raw, sliced, tv);
+    }
+    else if (sliced == NULL) {
+        return vbi_capture_pull_raw(self->ctx, raw, tv);
+    }
+    else if (raw == NULL) {
+        return vbi_capture_pull_sliced(self->ctx, sliced, tv);
+    }
+    else {
+        return vbi_capture_pull(self->ctx, raw, sliced, tv);
+    }
+}
+
+static vbi_raw_decoder *
+ZvbiCapture_DoParameters(ZvbiCaptureObj * self)
+{
+    if (self->replay != NULL) {
+        return ZvbiCaptureReplay_Parameters(self->replay);
+    }
+    return vbi_capture_parameters(self->ctx);
+}
+
+static int
+ZvbiCapture_DoFd(ZvbiCaptureObj * self)
+{
+    if (self->replay != NULL) {
+        return -1;
+    }
+    return vbi_capture_fd(self->ctx);
+}
+
+/*
+ * Raise an exception for a failed capture function. The end of a replayed
+ * file is reported via EOFError.
+ */
+static void
+ZvbiCapture_RaiseError(ZvbiCaptureObj * self)
+{
+    if ((self->replay != NULL) && ZvbiCaptureReplay_AtEof(self->replay)) {
+        PyErr_SetString(PyExc_EOFError, "end of replay file");
+    }
+    else {
+        PyErr_Format(ZvbiCaptureError, "capture error (%s)", strerror(errno));
+    }
+}
+
+/*
+ * Update statistics with the result of a capture function. Missed frames are
+ * derived from gaps between timestamps of consecutive frames. The function
+ * does not require the GIL, but the caller has to hold the capture lock.
+ */
+static void
+ZvbiCapture_StatsAddResult(ZvbiCaptureObj * self, int st, double timestamp)
+{
+    ZvbiCaptureStats * p_stats = &self->stats;
+
+    if (st > 0) {
+        if (p_stats->frame_period == 0.0) {
+            vbi_raw_decoder * p_par = ZvbiCapture_DoParameters(self);
+            if ((p_par != NULL) && (p_par->scanning == 525)) {
+                p_stats->frame_period = 1001.0 / 30000.0;
+            }
+            else {
+                p_stats->frame_period = 1.0 / 25.0;
+            }
+        }
+        if (p_stats->last_timestamp != 0.0) {
+            double gap = (timestamp - p_stats->last_timestamp) / p_stats->frame_period;
+            if (gap >= 1.5) {
+                p_stats->missed_frames += (unsigned long)(gap + 0.5) - 1;
+            }
+        }
+        p_stats->last_timestamp = timestamp;
+        p_stats->frames += 1;
+    }
+    else if (st == 0) {
+        p_stats->timeouts += 1;
+    }
+    else {
+        p_stats->errors += 1;
+    }
+}
+
+/*
+ * Update the histogram of delays between capturing and delivery of a frame to
+ * the application. Called while holding the GIL.
+ */
+static void
+ZvbiCapture_StatsAddDelay(ZvbiCaptureObj * self, double timestamp)
+{
+    ZvbiCaptureStats * p_stats = &self->stats;
+    struct timeval now;
+    unsigned idx;
+
+    gettimeofday(&now, NULL);
+    double delay = (now.tv_sec + now.tv_usec / 1E6) - timestamp;
+
+    for (idx = 0; idx < DELAY_BIN_CNT - 1; ++idx) {
+        if (delay <= ZvbiCapture_DelayBins[idx]) {
+            break;
+        }
+    }
+    p_stats->delay_hist[idx] += 1;
+    if (delay > p_stats->delay_max) {
+        p_stats->delay_max = delay;
+    }
+}
+
+static void
+ZvbiCapture_StatsUpdate(ZvbiCaptureObj * self, int st, double timestamp)
+{
+    int errno_saved = errno;
+
+    if ((st < 0) && (self->replay != NULL) && ZvbiCaptureReplay_AtEof(self->replay)) {
+        return;  // end of replayed file is not an error
+    }
+    ZvbiCapture_StatsAddResult(self, st, timestamp);
+    if (st > 0) {
+        ZvbiCapture_StatsAddDelay(self, timestamp);
+    }
+    errno = errno_saved;
+}
+
 static void
 ZvbiCapture_AppendErrorStr(char ** errorstr, const char * src, char * new_error)
 {
@@ -210,6 +453,45 @@ ZvbiCapture_NewAnalog(PyObject *null_self, PyObject *args, PyObject *kwds)
     return RETVAL;
 }
 
+/*
+ * Factory for capture objects reading recorded data from a file instead of a
+ * device, e.g. for testing or benchmarking without capture hardware
+ */
+static PyObject *
+ZvbiCapture_NewReplay(PyObject *null_self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"path", "fmt", "realtime", "raw_params", "services", "dvb_pid", NULL};
+    PyObject * path_obj = NULL;
+    char * fmt = "sliced";
+    int realtime = FALSE;
+    PyObject * par_obj = NULL;
+    unsigned services = 0;
+    unsigned dvb_pid = 0;
+    PyObject * RETVAL = NULL;
+
+    if (PyArg_ParseTupleAndKeywords(args, kwds, "O&|s$pO!II", kwlist,
+                                    PyUnicode_FSConverter, &path_obj, &fmt, &realtime,
+                                    &ZvbiRawParamsTypeDef, &par_obj, &services, &dvb_pid))
+    {
+        vbi_raw_decoder * p_par = (par_obj != NULL) ? ZvbiRawParamsGetStruct(par_obj) : NULL;
+
+        ZvbiCaptureReplay * replay = ZvbiCaptureReplay_New(PyBytes_AS_STRING(path_obj), fmt, realtime,
+                                                           p_par, &services, dvb_pid);
+        if (replay != NULL) {
+            RETVAL = ZvbiCapture_new(&ZvbiCaptureTypeDef, NULL, NULL);
+            if (RETVAL != NULL) {
+                ((ZvbiCaptureObj*)RETVAL)->replay = replay;
+                ((ZvbiCaptureObj*)RETVAL)->services = services;
+            }
+            else {
+                ZvbiCaptureReplay_Delete(replay);
+            }
+        }
+        Py_DECREF(path_obj);
+    }
+    return RETVAL;
+}
+
 static PyObject *
 ZvbiCapture_dvb_filter(ZvbiCaptureObj *self, PyObject *args)
 {
@@ -218,7 +500,17 @@ ZvbiCapture_dvb_filter(ZvbiCaptureObj *self, PyObject *args)
     if (!PyArg_ParseTuple(args, "I", &pid)) {
         return NULL;
     }
-    if (vbi_capture_dvb_filter(self->ctx, pid) < 0) {
+    ZvbiCapture_Lock(self);
+    int st;
+    if (self->replay != NULL) {
+        st = ZvbiCaptureReplay_SetPid(self->replay, pid);
+    }
+    else {
+        st = vbi_capture_dvb_filter(self->ctx, pid);
+    }
+    ZvbiCapture_Unlock(self);
+
+    if (st < 0) {
         PyErr_Format(ZvbiCaptureError, "Failed to set PID:%d (%s)", strerror(errno));
         return NULL;
     }
@@ -228,7 +520,13 @@ ZvbiCapture_dvb_filter(ZvbiCaptureObj *self, PyObject *args)
 static PyObject *
 ZvbiCapture_dvb_last_pts(ZvbiCaptureObj *self, PyObject *args)
 {
-    int64_t RETVAL = vbi_capture_dvb_last_pts(self->ctx);
+    int64_t RETVAL;
+    if (self->replay != NULL) {
+        RETVAL = ZvbiCaptureReplay_LastPts(self->replay);
+    }
+    else {
+        RETVAL = vbi_capture_dvb_last_pts(self->ctx);
+    }
     return PyLong_FromLongLong(RETVAL);
 }
 
@@ -238,34 +536,40 @@ ZvbiCapture_read_raw(ZvbiCaptureObj *self, PyObject *args)
     int timeout_ms = 0;
     PyObject * RETVAL = NULL;
 
-    if (PyArg_ParseTuple(args, "i", &timeout_ms)) {
-        vbi_raw_decoder * p_par = vbi_capture_parameters(self->ctx);
+    if (PyArg_ParseTuple(args, "i", &timeout_ms) && ZvbiCapture_CheckIdle(self)) {
+        ZvbiCapture_Lock(self);
+        vbi_raw_decoder * p_par = ZvbiCapture_DoParameters(self);
         if (p_par != NULL) {
             size_t size_raw = (p_par->count[0] + p_par->count[1]) * p_par->bytes_per_line;
-            void * raw_buffer = PyMem_Malloc(size_raw);
+            void * raw_buffer = PyMem_RawMalloc(size_raw);
 
             double timestamp = 0;
             struct timeval tv;
             tv.tv_sec  = timeout_ms / 1000;
             tv.tv_usec = (timeout_ms % 1000) * 1000;
 
-            int st = vbi_capture_read_raw(self->ctx, raw_buffer, &timestamp, &tv);
+            int st;
+            Py_BEGIN_ALLOW_THREADS
+            st = ZvbiCapture_DoRead(self, raw_buffer, NULL, NULL, &timestamp, &tv);
+            Py_END_ALLOW_THREADS
+            ZvbiCapture_StatsUpdate(self, st, timestamp);
             if (st > 0) {
-                RETVAL = ZvbiCaptureRawBuf_FromData(raw_buffer, size_raw, timestamp);
+                RETVAL = ZvbiCaptureRawBuf_FromData(raw_buffer, size_raw, timestamp, p_par);
             }
             else {
                 if (st < 0) {
-                    PyErr_Format(ZvbiCaptureError, "capture error (%s)", strerror(errno));
+                    ZvbiCapture_RaiseError(self);
                 }
                 else {
                     PyErr_SetNone(ZvbiCaptureTimeout);
                 }
-                PyMem_Free(raw_buffer);
+                PyMem_RawFree(raw_buffer);
             }
         }
         else {
             PyErr_Format(ZvbiCaptureError, "internal error: failed to query decoder parameters");
         }
+        ZvbiCapture_Unlock(self);
     }
     return RETVAL;
 }
@@ -276,11 +580,11 @@ ZvbiCapture_read_sliced(ZvbiCaptureObj *self, PyObject *args)
     int timeout_ms = 0;
     PyObject * RETVAL = NULL;
 
-    if (PyArg_ParseTuple(args, "i", &timeout_ms)) {
-        vbi_raw_decoder * p_par = vbi_capture_parameters(self->ctx);
+    if (PyArg_ParseTuple(args, "i", &timeout_ms) && ZvbiCapture_CheckIdle(self)) {
+        ZvbiCapture_Lock(self);
+        vbi_raw_decoder * p_par = ZvbiCapture_DoParameters(self);
         if (p_par != NULL) {
-            size_t size_sliced = (p_par->count[0] + p_par->count[1]) * sizeof(vbi_sliced);
-            vbi_sliced * p_sliced = (vbi_sliced*) PyMem_Malloc(size_sliced);
+            vbi_sliced * p_sliced = ZvbiCaptureSlicedBuf_AllocLines(p_par->count[0] + p_par->count[1]);
 
             int n_lines = 0;
             double timestamp = 0;
@@ -288,23 +592,28 @@ ZvbiCapture_read_sliced(ZvbiCaptureObj *self, PyObject *args)
             tv.tv_sec  = timeout_ms / 1000;
             tv.tv_usec = (timeout_ms % 1000) * 1000;
 
-            int st = vbi_capture_read_sliced(self->ctx, p_sliced, &n_lines, &timestamp, &tv);
+            int st;
+            Py_BEGIN_ALLOW_THREADS
+            st = ZvbiCapture_DoRead(self, NULL, p_sliced, &n_lines, &timestamp, &tv);
+            Py_END_ALLOW_THREADS
+            ZvbiCapture_StatsUpdate(self, st, timestamp);
             if (st > 0) {
                 RETVAL = ZvbiCaptureSlicedBuf_FromData(p_sliced, n_lines, timestamp);
             }
             else {
                 if (st < 0) {
-                    PyErr_Format(ZvbiCaptureError, "capture error (%s)", strerror(errno));
+                    ZvbiCapture_RaiseError(self);
                 }
                 else {
                     PyErr_SetNone(ZvbiCaptureTimeout);
                 }
-                PyMem_Free(p_sliced);
+                ZvbiCaptureSlicedBuf_FreeLines(p_sliced);
             }
         }
         else {
             PyErr_Format(ZvbiCaptureError, "internal error: failed to query decoder parameters");
         }
+        ZvbiCapture_Unlock(self);
     }
     return RETVAL;
 }
@@ -315,13 +624,13 @@ ZvbiCapture_read(ZvbiCaptureObj *self, PyObject *args)
     int timeout_ms = 0;
     PyObject * RETVAL = NULL;
 
-    if (PyArg_ParseTuple(args, "i", &timeout_ms)) {
-        vbi_raw_decoder * p_par = vbi_capture_parameters(self->ctx);
+    if (PyArg_ParseTuple(args, "i", &timeout_ms) && ZvbiCapture_CheckIdle(self)) {
+        ZvbiCapture_Lock(self);
+        vbi_raw_decoder * p_par = ZvbiCapture_DoParameters(self);
         if (p_par != NULL) {
-            size_t size_sliced = (p_par->count[0] + p_par->count[1]) * sizeof(vbi_sliced);
             size_t size_raw = (p_par->count[0] + p_par->count[1]) * p_par->bytes_per_line;
-            void * raw_buffer = PyMem_Malloc(size_raw);
-            vbi_sliced * p_sliced = (vbi_sliced*) PyMem_Malloc(size_sliced);
+            void * raw_buffer = PyMem_RawMalloc(size_raw);
+            vbi_sliced * p_sliced = ZvbiCaptureSlicedBuf_AllocLines(p_par->count[0] + p_par->count[1]);
 
             int n_lines = 0;
             double timestamp = 0;
@@ -329,32 +638,143 @@ ZvbiCapture_read(ZvbiCaptureObj *self, PyObject *args)
             tv.tv_sec  = timeout_ms / 1000;
             tv.tv_usec = (timeout_ms % 1000) * 1000;
 
-            int st = vbi_capture_read(self->ctx, raw_buffer, p_sliced, &n_lines, &timestamp, &tv);
+            int st;
+            Py_BEGIN_ALLOW_THREADS
+            st = ZvbiCapture_DoRead(self, raw_buffer, p_sliced, &n_lines, &timestamp, &tv);
+            Py_END_ALLOW_THREADS
+            ZvbiCapture_StatsUpdate(self, st, timestamp);
             if (st > 0) {
                 RETVAL = PyTuple_New(2);
                 if (RETVAL) {
-                    PyTuple_SetItem(RETVAL, 0, ZvbiCaptureRawBuf_FromData(raw_buffer, size_raw, timestamp));
+                    PyTuple_SetItem(RETVAL, 0, ZvbiCaptureRawBuf_FromData(raw_buffer, size_raw, timestamp, p_par));
                     PyTuple_SetItem(RETVAL, 1, ZvbiCaptureSlicedBuf_FromData(p_sliced, n_lines, timestamp));
                 }
                 else {
-                    PyMem_Free(raw_buffer);
-                    PyMem_Free(p_sliced);
+                    PyMem_RawFree(raw_buffer);
+                    ZvbiCaptureSlicedBuf_FreeLines(p_sliced);
                 }
             }
             else {
                 if (st < 0) {
-                    PyErr_Format(ZvbiCaptureError, "capture error (%s)", strerror(errno));
+                    ZvbiCapture_RaiseError(self);
                 }
                 else {
                     PyErr_SetNone(ZvbiCaptureTimeout);
                 }
-                PyMem_Free(raw_buffer);
-                PyMem_Free(p_sliced);
+                PyMem_RawFree(raw_buffer);
+                ZvbiCaptureSlicedBuf_FreeLines(p_sliced);
             }
         }
         else {
             PyErr_Format(ZvbiCaptureError, "internal error: failed to query decoder parameters");
         }
+        ZvbiCapture_Unlock(self);
+    }
+    return RETVAL;
+}
+
+/*
+ * Variant of the read functions that stores captured data into buffers
+ * provided by the caller, so that repeated capturing does not require any
+ * memory allocation. Returns the number of sliced lines and the timestamp.
+ */
+static PyObject *
+ZvbiCapture_read_into(ZvbiCaptureObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"timeout_ms", "raw", "sliced", NULL};
+    int timeout_ms = 0;
+    PyObject * raw_obj = Py_None;
+    PyObject * sliced_obj = Py_None;
+    Py_buffer raw_view;
+    Py_buffer sliced_view;
+    vbi_capture_buffer * sliced_buf = NULL;
+    unsigned max_lines = 0;
+    PyObject * RETVAL = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "i|OO", kwlist,
+                                     &timeout_ms, &raw_obj, &sliced_obj))
+    {
+        return NULL;
+    }
+    if (!ZvbiCapture_CheckIdle(self)) {
+        return NULL;
+    }
+    if ((raw_obj == Py_None) && (sliced_obj == Py_None)) {
+        PyErr_SetString(PyExc_TypeError, "At least one of parameters raw and sliced is required");
+        return NULL;
+    }
+    if (sliced_obj != Py_None) {
+        sliced_buf = ZvbiCaptureSlicedBuf_GetFillable(sliced_obj, &max_lines);
+        // keep an export on the sliced buffer until it is filled, so that it
+        // cannot be exported or refilled by other threads while the GIL is released
+        if ((sliced_buf == NULL) || (PyObject_GetBuffer(sliced_obj, &sliced_view, PyBUF_SIMPLE) != 0)) {
+            return NULL;
+        }
+    }
+    raw_view.buf = NULL;
+    if ((raw_obj != Py_None) &&
+        (PyObject_GetBuffer(raw_obj, &raw_view, PyBUF_SIMPLE | PyBUF_WRITABLE) != 0))
+    {
+        if (sliced_buf != NULL) {
+            PyBuffer_Release(&sliced_view);
+        }
+        return NULL;
+    }
+
+    ZvbiCapture_Lock(self);
+    vbi_raw_decoder * p_par = ZvbiCapture_DoParameters(self);
+    if (p_par != NULL) {
+        unsigned line_count = p_par->count[0] + p_par->count[1];
+        size_t size_raw = line_count * p_par->bytes_per_line;
+
+        if ((raw_view.buf != NULL) && ((size_t)raw_view.len < size_raw)) {
+            PyErr_Format(PyExc_ValueError, "Raw buffer too small: %zd, need %zd bytes",
+                         raw_view.len, (Py_ssize_t)size_raw);
+        }
+        else if ((sliced_buf != NULL) && (max_lines < line_count)) {
+            PyErr_Format(PyExc_ValueError, "Sliced buffer too small: %u, need %u lines",
+                         max_lines, line_count);
+        }
+        else {
+            int n_lines = 0;
+            double timestamp = 0;
+            struct timeval tv;
+            tv.tv_sec  = timeout_ms / 1000;
+            tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+            int st;
+            Py_BEGIN_ALLOW_THREADS
+            st = ZvbiCapture_DoRead(self, raw_view.buf, ((sliced_buf != NULL) ? sliced_buf->data : NULL),
+                                    &n_lines, &timestamp, &tv);
+            Py_END_ALLOW_THREADS
+            ZvbiCapture_StatsUpdate(self, st, timestamp);
+            if (st > 0) {
+                if (sliced_buf != NULL) {
+                    sliced_buf->size = n_lines * sizeof(vbi_sliced);
+                    sliced_buf->timestamp = timestamp;
+                }
+                RETVAL = Py_BuildValue("id", n_lines, timestamp);
+            }
+            else {
+                if (st < 0) {
+                    ZvbiCapture_RaiseError(self);
+                }
+                else {
+                    PyErr_SetNone(ZvbiCaptureTimeout);
+                }
+            }
+        }
+    }
+    else {
+        PyErr_Format(ZvbiCaptureError, "internal error: failed to query decoder parameters");
+    }
+    ZvbiCapture_Unlock(self);
+
+    if (raw_view.buf != NULL) {
+        PyBuffer_Release(&raw_view);
+    }
+    if (sliced_buf != NULL) {
+        PyBuffer_Release(&sliced_view);
     }
     return RETVAL;
 }
@@ -365,28 +785,36 @@ ZvbiCapture_pull_raw(ZvbiCaptureObj *self, PyObject *args)
     int timeout_ms = 0;
     PyObject * RETVAL = NULL;
 
-    if (PyArg_ParseTuple(args, "i", &timeout_ms)) {
+    if (PyArg_ParseTuple(args, "i", &timeout_ms) && ZvbiCapture_CheckIdle(self)) {
         vbi_capture_buffer * raw_buffer = NULL;
 
-        // invalidate previously returned capture buffer wrapper objects
-        ZvbiCapture_PulledBufferSeqNo++;
+        ZvbiCapture_Lock(self);
+
+        // detach previously returned capture buffer wrapper objects
+        ZvbiCaptureBufList_Invalidate(&self->pull_bufs);
 
         struct timeval tv;
         tv.tv_sec  = timeout_ms / 1000;
         tv.tv_usec = (timeout_ms % 1000) * 1000;
 
-        int st = vbi_capture_pull_raw(self->ctx, &raw_buffer, &tv);
+        int st;
+        Py_BEGIN_ALLOW_THREADS
+        st = ZvbiCapture_DoPull(self, &raw_buffer, NULL, &tv);
+        Py_END_ALLOW_THREADS
+        ZvbiCapture_StatsUpdate(self, st, ((st > 0) ? raw_buffer->timestamp : 0.0));
         if (st > 0) {
-            RETVAL = ZvbiCaptureRawBuf_FromPtr(raw_buffer, &ZvbiCapture_PulledBufferSeqNo);
+            RETVAL = ZvbiCaptureRawBuf_FromPtr(raw_buffer, (PyObject *) self, &self->pull_bufs,
+                                               ZvbiCapture_DoParameters(self));
         }
         else {
             if (st < 0) {
-                PyErr_Format(ZvbiCaptureError, "capture error (%s)", strerror(errno));
+                ZvbiCapture_RaiseError(self);
             }
             else {
                 PyErr_SetNone(ZvbiCaptureTimeout);
             }
         }
+        ZvbiCapture_Unlock(self);
     }
     return RETVAL;
 }
@@ -397,28 +825,35 @@ ZvbiCapture_pull_sliced(ZvbiCaptureObj *self, PyObject *args)
     int timeout_ms = 0;
     PyObject * RETVAL = NULL;
 
-    if (PyArg_ParseTuple(args, "i", &timeout_ms)) {
+    if (PyArg_ParseTuple(args, "i", &timeout_ms) && ZvbiCapture_CheckIdle(self)) {
         vbi_capture_buffer * sliced_buffer = NULL;
 
-        // invalidate previously returned capture buffer wrapper objects
-        ZvbiCapture_PulledBufferSeqNo++;
+        ZvbiCapture_Lock(self);
+
+        // detach previously returned capture buffer wrapper objects
+        ZvbiCaptureBufList_Invalidate(&self->pull_bufs);
 
         struct timeval tv;
         tv.tv_sec  = timeout_ms / 1000;
         tv.tv_usec = (timeout_ms % 1000) * 1000;
 
-        int st = vbi_capture_pull_sliced(self->ctx, &sliced_buffer, &tv);
+        int st;
+        Py_BEGIN_ALLOW_THREADS
+        st = ZvbiCapture_DoPull(self, NULL, &sliced_buffer, &tv);
+        Py_END_ALLOW_THREADS
+        ZvbiCapture_StatsUpdate(self, st, ((st > 0) ? sliced_buffer->timestamp : 0.0));
         if (st > 0) {
-            RETVAL = ZvbiCaptureSlicedBuf_FromPtr(sliced_buffer, &ZvbiCapture_PulledBufferSeqNo);
+            RETVAL = ZvbiCaptureSlicedBuf_FromPtr(sliced_buffer, (PyObject *) self, &self->pull_bufs);
         }
         else {
             if (st < 0) {
-                PyErr_Format(ZvbiCaptureError, "capture error (%s)", strerror(errno));
+                ZvbiCapture_RaiseError(self);
             }
             else {
                 PyErr_SetNone(ZvbiCaptureTimeout);
             }
         }
+        ZvbiCapture_Unlock(self);
     }
     return RETVAL;
 }
@@ -429,39 +864,152 @@ ZvbiCapture_pull(ZvbiCaptureObj *self, PyObject *args)
     int timeout_ms = 0;
     PyObject * RETVAL = NULL;
 
-    if (PyArg_ParseTuple(args, "i", &timeout_ms)) {
+    if (PyArg_ParseTuple(args, "i", &timeout_ms) && ZvbiCapture_CheckIdle(self)) {
         vbi_capture_buffer * raw_buffer = NULL;
         vbi_capture_buffer * sliced_buffer = NULL;
 
-        // invalidate previously returned capture buffer wrapper objects
-        ZvbiCapture_PulledBufferSeqNo++;
+        ZvbiCapture_Lock(self);
+
+        // detach previously returned capture buffer wrapper objects
+        ZvbiCaptureBufList_Invalidate(&self->pull_bufs);
 
         struct timeval tv;
         tv.tv_sec  = timeout_ms / 1000;
         tv.tv_usec = (timeout_ms % 1000) * 1000;
 
-        int st = vbi_capture_pull(self->ctx, &raw_buffer, &sliced_buffer, &tv);
+        int st;
+        Py_BEGIN_ALLOW_THREADS
+        st = ZvbiCapture_DoPull(self, &raw_buffer, &sliced_buffer, &tv);
+        Py_END_ALLOW_THREADS
+        ZvbiCapture_StatsUpdate(self, st, ((st > 0) ? sliced_buffer->timestamp : 0.0));
         if (st > 0) {
             RETVAL = PyTuple_New(2);
             if (RETVAL) {
                 if (raw_buffer != NULL) {  // DVB devices may not return raw data
-                    PyTuple_SetItem(RETVAL, 0, ZvbiCaptureRawBuf_FromPtr(raw_buffer, &ZvbiCapture_PulledBufferSeqNo));
+                    PyTuple_SetItem(RETVAL, 0, ZvbiCaptureRawBuf_FromPtr(raw_buffer, (PyObject *) self, &self->pull_bufs,
+                                                                         ZvbiCapture_DoParameters(self)));
                 }
                 else {
                     PyTuple_SetItem(RETVAL, 0, Py_None);
                     Py_INCREF(Py_None);
                 }
-                PyTuple_SetItem(RETVAL, 1, ZvbiCaptureSlicedBuf_FromPtr(sliced_buffer, &ZvbiCapture_PulledBufferSeqNo));
+                PyTuple_SetItem(RETVAL, 1, ZvbiCaptureSlicedBuf_FromPtr(sliced_buffer, (PyObject *) self, &self->pull_bufs));
             }
         }
         else {
             if (st < 0) {
-                PyErr_Format(ZvbiCaptureError, "capture error (%s)", strerror(errno));
+                ZvbiCapture_RaiseError(self);
             }
             else {
                 PyErr_SetNone(ZvbiCaptureTimeout);
             }
         }
+        ZvbiCapture_Unlock(self);
+    }
+    return RETVAL;
+}
+
+/*
+ * Pull a frame without waiting, for use by asynchronous capturing and
+ * Zvbi.CaptureSet. Returns the same result as "pull", or None if no data is
+ * available yet.
+ */
+PyObject *
+ZvbiCapture_PullNoWait(PyObject * obj)
+{
+    ZvbiCaptureObj * self = (ZvbiCaptureObj *) obj;
+    vbi_capture_buffer * raw_buffer = NULL;
+    vbi_capture_buffer * sliced_buffer = NULL;
+    PyObject * RETVAL = NULL;
+
+    if (ZvbiCapture_CheckIdle(self)) {
+        ZvbiCapture_Lock(self);
+
+        // detach previously returned capture buffer wrapper objects
+        ZvbiCaptureBufList_Invalidate(&self->pull_bufs);
+
+        struct timeval tv;
+        tv.tv_sec  = 0;
+        tv.tv_usec = 0;
+
+        int st;
+        Py_BEGIN_ALLOW_THREADS
+        st = ZvbiCapture_DoPull(self, &raw_buffer, &sliced_buffer, &tv);
+        Py_END_ALLOW_THREADS
+        if (st > 0) {
+            ZvbiCapture_StatsUpdate(self, st, sliced_buffer->timestamp);
+            RETVAL = PyTuple_New(2);
+            if (RETVAL) {
+                if (raw_buffer != NULL) {  // DVB devices may not return raw data
+                    PyTuple_SetItem(RETVAL, 0, ZvbiCaptureRawBuf_FromPtr(raw_buffer, (PyObject *) self, &self->pull_bufs,
+                                                                         ZvbiCapture_DoParameters(self)));
+                }
+                else {
+                    PyTuple_SetItem(RETVAL, 0, Py_None);
+                    Py_INCREF(Py_None);
+                }
+                PyTuple_SetItem(RETVAL, 1, ZvbiCaptureSlicedBuf_FromPtr(sliced_buffer, (PyObject *) self, &self->pull_bufs));
+            }
+        }
+        else if ((st == 0) || (errno == EAGAIN) || (errno == EINTR)) {
+            // no data yet (or only a partial frame, or a proxy message)
+            RETVAL = Py_None;
+            Py_INCREF(Py_None);
+        }
+        else {
+            ZvbiCapture_StatsUpdate(self, st, 0.0);
+            ZvbiCapture_RaiseError(self);
+        }
+        ZvbiCapture_Unlock(self);
+    }
+    return RETVAL;
+}
+
+/*
+ * Poll function for asynchronous capturing, called by the event loop
+ */
+static PyObject *
+ZvbiCapture_PollAsync(ZvbiCaptureObj *self, PyObject *unused)
+{
+    return ZvbiCapture_PullNoWait((PyObject *) self);
+}
+
+static PyMethodDef ZvbiCapture_PollAsyncDef =
+    {"_poll_async", (PyCFunction) ZvbiCapture_PollAsync, METH_NOARGS, NULL };
+
+static PyObject *
+ZvbiCapture_aread(ZvbiCaptureObj *self, PyObject *args)
+{
+    PyObject * RETVAL = NULL;
+
+    if (ZvbiCapture_CheckIdle(self)) {
+        int fd = ZvbiCapture_DoFd(self);
+        if (fd != -1) {
+            PyObject * poll_func = PyCFunction_New(&ZvbiCapture_PollAsyncDef, (PyObject*)self);
+            if (poll_func != NULL) {
+                RETVAL = ZvbiAsync_AwaitFd(fd, poll_func);
+                Py_DECREF(poll_func);
+            }
+        }
+        else {
+            PyErr_SetString(ZvbiCaptureError, "device does not support asynchronous capturing");
+        }
+    }
+    return RETVAL;
+}
+
+static PyMethodDef ZvbiCapture_AReadDef =
+    {"aread", (PyCFunction) ZvbiCapture_aread, METH_NOARGS, NULL };
+
+static PyObject *
+ZvbiCapture_aiter(ZvbiCaptureObj *self, PyObject *args)
+{
+    PyObject * RETVAL = NULL;
+
+    PyObject * anext_func = PyCFunction_New(&ZvbiCapture_AReadDef, (PyObject*)self);
+    if (anext_func != NULL) {
+        RETVAL = ZvbiAsync_NewIter(anext_func);
+        Py_DECREF(anext_func);
     }
     return RETVAL;
 }
@@ -471,20 +1019,22 @@ ZvbiCapture_parameters(ZvbiCaptureObj *self, PyObject *args)
 {
     PyObject * RETVAL = NULL;
 
-    vbi_raw_decoder * p_rd = vbi_capture_parameters(self->ctx);
+    ZvbiCapture_Lock(self);
+    vbi_raw_decoder * p_rd = ZvbiCapture_DoParameters(self);
     if (p_rd != NULL) {
         RETVAL = ZvbiRawParamsFromStruct(p_rd);
     }
     else {
         PyErr_SetString(ZvbiCaptureError, "failed to retrieve parameters");
     }
+    ZvbiCapture_Unlock(self);
     return RETVAL;
 }
 
 static PyObject *
 ZvbiCapture_get_fd(ZvbiCaptureObj *self, PyObject *args)
 {
-    int RETVAL = vbi_capture_fd(self->ctx);
+    int RETVAL = ZvbiCapture_DoFd(self);
     return PyLong_FromLong(RETVAL);
 }
 
@@ -502,7 +1052,18 @@ ZvbiCapture_update_services(ZvbiCaptureObj *self, PyObject *args, PyObject *kwds
     if (PyArg_ParseTupleAndKeywords(args, kwds, "I|$ppI", kwlist,
                                           &services, &reset, &commit, &strict))
     {
-        services = vbi_capture_update_services(self->ctx, reset, commit, services, strict, &errorstr);
+        // may block for re-negotiation of parameters with the device
+        ZvbiCapture_Lock(self);
+        Py_BEGIN_ALLOW_THREADS
+        if (self->replay != NULL) {
+            services = ZvbiCaptureReplay_UpdateServices(self->replay, reset, services, strict);
+        }
+        else {
+            services = vbi_capture_update_services(self->ctx, reset, commit, services, strict, &errorstr);
+        }
+        Py_END_ALLOW_THREADS
+        ZvbiCapture_Unlock(self);
+
         if (services != 0) {
             RETVAL = PyLong_FromLong(services);
         }
@@ -520,31 +1081,104 @@ ZvbiCapture_update_services(ZvbiCaptureObj *self, PyObject *args, PyObject *kwds
 static PyObject *
 ZvbiCapture_get_scanning(ZvbiCaptureObj *self, PyObject *args)
 {
-    int RETVAL = vbi_capture_get_scanning(self->ctx);
+    int RETVAL;
+    if (self->replay != NULL) {
+        RETVAL = ZvbiCaptureReplay_Parameters(self->replay)->scanning;
+    }
+    else {
+        RETVAL = vbi_capture_get_scanning(self->ctx);
+    }
     return PyLong_FromLong(RETVAL);
 }
 
 static PyObject *
 ZvbiCapture_flush(ZvbiCaptureObj *self, PyObject *args)
 {
-    vbi_capture_flush(self->ctx);
+    ZvbiCapture_Lock(self);
+    if (self->replay != NULL) {
+        ZvbiCaptureReplay_Flush(self->replay);
+    }
+    else {
+        vbi_capture_flush(self->ctx);
+    }
+    ZvbiCapture_Unlock(self);
     Py_RETURN_NONE;
 }
 
 static PyObject *
 ZvbiCapture_get_fd_flags(ZvbiCaptureObj *self, PyObject *args)
 {
-    VBI_CAPTURE_FD_FLAGS RETVAL = vbi_capture_get_fd_flags(self->ctx);
+    VBI_CAPTURE_FD_FLAGS RETVAL = 0;
+    if (self->replay == NULL) {
+        RETVAL = vbi_capture_get_fd_flags(self->ctx);
+    }
     return PyLong_FromLong(RETVAL);
 }
 
 // ---------------------------------------------------------------------------
 
+/*
+ * Return a snapshot of the capture statistics and optionally reset them
+ */
+static PyObject *
+ZvbiCapture_stats(ZvbiCaptureObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"reset", NULL};
+    int reset = FALSE;
+    ZvbiCaptureStats stats;
+    PyObject * RETVAL = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|$p", kwlist, &reset)) {
+        return NULL;
+    }
+
+    // lock is required as counters are also updated by Zvbi.CaptureThread
+    ZvbiCapture_Lock(self);
+    stats = self->stats;
+    if (reset) {
+        memset(&self->stats, 0, sizeof(self->stats));
+        self->stats.last_timestamp = stats.last_timestamp;
+        self->stats.frame_period = stats.frame_period;
+    }
+    ZvbiCapture_Unlock(self);
+
+    PyObject * hist = PyTuple_New(DELAY_BIN_CNT);
+    PyObject * bins = PyTuple_New(DELAY_BIN_CNT - 1);
+    if ((hist != NULL) && (bins != NULL)) {
+        for (unsigned idx = 0; idx < DELAY_BIN_CNT; ++idx) {
+            PyTuple_SetItem(hist, idx, PyLong_FromUnsignedLong(stats.delay_hist[idx]));
+        }
+        for (unsigned idx = 0; idx < DELAY_BIN_CNT - 1; ++idx) {
+            PyTuple_SetItem(bins, idx, PyFloat_FromDouble(ZvbiCapture_DelayBins[idx]));
+        }
+        RETVAL = PyStructSequence_New(ZvbiCaptureStatsType);
+        if (RETVAL != NULL) {
+            PyStructSequence_SetItem(RETVAL, 0, PyLong_FromUnsignedLong(stats.frames));
+            PyStructSequence_SetItem(RETVAL, 1, PyLong_FromUnsignedLong(stats.timeouts));
+            PyStructSequence_SetItem(RETVAL, 2, PyLong_FromUnsignedLong(stats.errors));
+            PyStructSequence_SetItem(RETVAL, 3, PyLong_FromUnsignedLong(stats.missed_frames));
+            PyStructSequence_SetItem(RETVAL, 4, hist);
+            PyStructSequence_SetItem(RETVAL, 5, bins);
+            PyStructSequence_SetItem(RETVAL, 6, PyFloat_FromDouble(stats.delay_max));
+
+            if (PyErr_Occurred()) {
+                Py_DECREF(RETVAL);
+                RETVAL = NULL;
+            }
+            return RETVAL;
+        }
+    }
+    Py_XDECREF(hist);
+    Py_XDECREF(bins);
+    return NULL;
+}
+
 static PyMethodDef ZvbiCapture_MethodsDef[] =
 {
     // static factory methods
     {"Dvb",             (PyCFunction) ZvbiCapture_NewDvb,          METH_VARARGS | METH_KEYWORDS | METH_STATIC, NULL },
     {"Analog",          (PyCFunction) ZvbiCapture_NewAnalog,       METH_VARARGS | METH_KEYWORDS | METH_STATIC, NULL },
+    {"Replay",          (PyCFunction) ZvbiCapture_NewReplay,       METH_VARARGS | METH_KEYWORDS | METH_STATIC, NULL },
 
     {"dvb_filter",      (PyCFunction) ZvbiCapture_dvb_filter,      METH_VARARGS, NULL },
     {"dvb_last_pts",    (PyCFunction) ZvbiCapture_dvb_last_pts,    METH_NOARGS,  NULL },
@@ -552,17 +1186,22 @@ static PyMethodDef ZvbiCapture_MethodsDef[] =
     {"read_raw",        (PyCFunction) ZvbiCapture_read_raw,        METH_VARARGS, NULL },
     {"read_sliced",     (PyCFunction) ZvbiCapture_read_sliced,     METH_VARARGS, NULL },
     {"read",            (PyCFunction) ZvbiCapture_read,            METH_VARARGS, NULL },
+    {"read_into",       (PyCFunction) ZvbiCapture_read_into,       METH_VARARGS | METH_KEYWORDS, NULL },
 
     {"pull_raw",        (PyCFunction) ZvbiCapture_pull_raw,        METH_VARARGS, NULL },
     {"pull_sliced",     (PyCFunction) ZvbiCapture_pull_sliced,     METH_VARARGS, NULL },
     {"pull",            (PyCFunction) ZvbiCapture_pull,            METH_VARARGS, NULL },
 
+    {"aread",           (PyCFunction) ZvbiCapture_aread,           METH_NOARGS,  NULL },
+    {"aiter",           (PyCFunction) ZvbiCapture_aiter,           METH_NOARGS,  NULL },
+
     {"parameters",      (PyCFunction) ZvbiCapture_parameters,      METH_NOARGS,  NULL },
     {"get_fd",          (PyCFunction) ZvbiCapture_get_fd,          METH_NOARGS,  NULL },
     {"update_services", (PyCFunction) ZvbiCapture_update_services, METH_VARARGS | METH_KEYWORDS, NULL },
     {"get_scanning",    (PyCFunction) ZvbiCapture_get_scanning,    METH_NOARGS,  NULL },
     {"flush",           (PyCFunction) ZvbiCapture_flush,           METH_NOARGS,  NULL },
     {"get_fd_flags",    (PyCFunction) ZvbiCapture_get_fd_flags,    METH_NOARGS,  NULL },
+    {"stats",           (PyCFunction) ZvbiCapture_stats,           METH_VARARGS | METH_KEYWORDS, NULL },
 
     {NULL}  /* Sentinel */
 };
@@ -583,12 +1222,105 @@ PyTypeObject ZvbiCaptureTypeDef =
     //.tp_members = ZvbiCapture_Members,
 };
 
-vbi_capture *
-ZvbiCapture_GetCtx(PyObject * self)
+/*
+ * Interfaces for capturing by other modules, e.g. Zvbi.CaptureThread. The
+ * pull function does not require the GIL, but the caller has to hold the
+ * capture lock.
+ */
+vbi_raw_decoder *
+ZvbiCapture_GetParameters(PyObject * self)
+{
+    return ZvbiCapture_DoParameters((ZvbiCaptureObj*)self);
+}
+
+int
+ZvbiCapture_GetFd(PyObject * self)
+{
+    return ZvbiCapture_DoFd((ZvbiCaptureObj*)self);
+}
+
+int
+ZvbiCapture_Pull(PyObject * self, vbi_capture_buffer ** raw,
+                 vbi_capture_buffer ** sliced, struct timeval * tv)
+{
+    return ZvbiCapture_DoPull((ZvbiCaptureObj*)self, raw, sliced, tv);
+}
+
+vbi_bool
+ZvbiCapture_AtEof(PyObject * self)
 {
-    return ((ZvbiCaptureObj*)self)->ctx;
+    ZvbiCaptureObj * cap = (ZvbiCaptureObj*)self;
+    return (cap->replay != NULL) && ZvbiCaptureReplay_AtEof(cap->replay);
 }
 
+/*
+ * Interfaces for Zvbi.CaptureThread: the thread acquires the lock of the
+ * capture object around each capture call (without holding the GIL), while
+ * Python-level capture functions are rejected until the thread is stopped.
+ */
+PyThread_type_lock
+ZvbiCapture_GetLock(PyObject * self)
+{
+    return ((ZvbiCaptureObj*)self)->lock;
+}
+
+int
+ZvbiCapture_SetBackground(PyObject * obj, vbi_bool enable)
+{
+    ZvbiCaptureObj * self = (ZvbiCaptureObj*) obj;
+
+    if (enable && !ZvbiCapture_CheckIdle(self)) {
+        return -1;
+    }
+    if (enable) {
+        // buffers returned by "pull" are going to be overwritten by the thread
+        ZvbiCaptureBufList_Invalidate(&self->pull_bufs);
+    }
+    self->background = enable;
+    return 0;
+}
+
+/*
+ * Update statistics of the given capture object for a frame captured by
+ * Zvbi.CaptureThread. This function does not require the GIL, but the caller
+ * has to hold the capture lock.
+ */
+void
+ZvbiCapture_CountFrame(PyObject * obj, int st, double timestamp)
+{
+    ZvbiCapture_StatsAddResult((ZvbiCaptureObj*) obj, st, timestamp);
+}
+
+/*
+ * Update the delay statistics for a frame captured by Zvbi.CaptureThread
+ * when it is delivered to the application. Called while holding the GIL.
+ */
+void
+ZvbiCapture_CountDelivery(PyObject * obj, double timestamp)
+{
+    ZvbiCapture_StatsAddDelay((ZvbiCaptureObj*) obj, timestamp);
+}
+
+static PyStructSequence_Field ZvbiCaptureStatsDefMembers[] =
+{
+    { "frames", PyDoc_STR("Number of frames delivered by the device") },
+    { "timeouts", PyDoc_STR("Number of capture calls that returned due to expiry of the timeout") },
+    { "errors", PyDoc_STR("Number of capture calls that failed with an error") },
+    { "missed_frames", PyDoc_STR("Number of frames missing between delivered frames, derived from gaps between their timestamps") },
+    { "delay_hist", PyDoc_STR("Histogram of delays between capturing a frame and its delivery to the application, as tuple of counters for the intervals given by delay_bins") },
+    { "delay_bins", PyDoc_STR("Upper limits of the delay histogram intervals in seconds; the last histogram entry counts all delays above the last limit") },
+    { "delay_max", PyDoc_STR("Maximum of delays between capturing and delivery in seconds") },
+    { NULL, NULL }
+};
+
+static PyStructSequence_Desc ZvbiCaptureStatsDef =
+{
+    "Zvbi.CaptureStats",
+    PyDoc_STR("Named tuple type containing capture statistics"),
+    ZvbiCaptureStatsDefMembers,
+    7
+};
+
 int PyInit_Capture(PyObject * module, PyObject * error_base)
 {
     if (PyType_Ready(&ZvbiCaptureTypeDef) < 0) {
@@ -627,5 +1359,21 @@ int PyInit_Capture(PyObject * module, PyObject * error_base)
         return -1;
     }
 
+    // create statistics container class type object
+#if defined (NAMED_TUPLE_GC_BUG)
+    if (PyStructSequence_InitType2(&ZvbiCaptureStatsTypeBuf, &ZvbiCaptureStatsDef) != 0)
+#else
+    ZvbiCaptureStatsType = PyStructSequence_NewType(&ZvbiCaptureStatsDef);
+    if (ZvbiCaptureStatsType == NULL)
+#endif
+    {
+        Py_DECREF(&ZvbiCaptureTypeDef);
+        Py_XDECREF(ZvbiCaptureTimeout);
+        Py_CLEAR(ZvbiCaptureTimeout);
+        Py_XDECREF(ZvbiCaptureError);
+        Py_CLEAR(ZvbiCaptureError);
+        return -1;
+    }
+
     return 0;
 }
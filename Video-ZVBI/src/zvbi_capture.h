@@ -15,7 +15,19 @@
 #define _PY_ZVBI_CAPTURE_H
 
 extern PyTypeObject ZvbiCaptureTypeDef;
-vbi_capture * ZvbiCapture_GetCtx(PyObject * self);
+extern PyObject * ZvbiCaptureError;
+extern PyObject * ZvbiCaptureTimeout;
+
+vbi_raw_decoder * ZvbiCapture_GetParameters(PyObject * self);
+int ZvbiCapture_GetFd(PyObject * self);
+int ZvbiCapture_Pull(PyObject * self, vbi_capture_buffer ** raw,
+                     vbi_capture_buffer ** sliced, struct timeval * tv);
+vbi_bool ZvbiCapture_AtEof(PyObject * self);
+PyObject * ZvbiCapture_PullNoWait(PyObject * self);
+PyThread_type_lock ZvbiCapture_GetLock(PyObject * self);
+void ZvbiCapture_CountFrame(PyObject * obj, int st, double timestamp);
+void ZvbiCapture_CountDelivery(PyObject * obj, double timestamp);
+int ZvbiCapture_SetBackground(PyObject * self, vbi_bool enable);
 
 int PyInit_Capture(PyObject * module, PyObject * error_base);
 
@@ -21,13 +21,25 @@
 
 // ---------------------------------------------------------------------------
 
-typedef struct {
+typedef struct ZvbiCaptureBufObj_s {
     PyObject_HEAD
-    vbi_capture_buffer * buf;
-    vbi_bool             need_free;
+    vbi_capture_buffer * buf;           // NULL when invalidated
+    vbi_bool             need_free;     // data is owned by the object
+    vbi_bool             is_view;       // data is owned by another buffer object
     int                  iter_idx;
-    const int *          p_validity_src;
-    int                  validity_id;
+    PyObject *           owner;         // object owning the storage, or NULL
+    ZvbiCaptureBufList * p_list;        // list of owner with buffers to detach, or NULL
+    struct ZvbiCaptureBufObj_s * prev;  // chaining within the list
+    struct ZvbiCaptureBufObj_s * next;
+    unsigned             max_lines;     // allocated capacity, when instantiated via constructor
+    int                  exports;       // number of active Py_buffer exports and views
+    vbi_capture_buffer   hdr;           // used unless buffer is owned by libzvbi
+    // geometry of raw data; bytes_per_line is 0 when unknown
+    int                  bytes_per_line;
+    int                  field_count[2];  // 0 for views not covering a complete frame
+    vbi_bool             interlaced;
+    Py_ssize_t           shape[2];        // number of lines, bytes per line
+    Py_ssize_t           strides[2];      // distance of lines in memory, 1
 } ZvbiCaptureBufObj;
 
 #if defined (NAMED_TUPLE_GC_BUG)
@@ -37,33 +49,241 @@ static PyTypeObject * const ZvbiCaptureSlicedLineType = &ZvbiCaptureSlicedLineTy
 static PyTypeObject * ZvbiCaptureSlicedLineType = NULL;
 #endif
 
+// ---------------------------------------------------------------------------
+//  Free lists
+// ---------------------------------------------------------------------------
+
+/*
+ * Buffer objects are created for every captured frame. To avoid allocator
+ * churn, released objects of the exact raw and sliced buffer types are kept
+ * in free lists for reuse. Likewise arrays of sliced lines are recycled in
+ * size classes of 16, 32, ... 1024 lines. Access is protected by the GIL.
+ */
+#define ZVBI_CAPTURE_BUF_FREELIST_MAX   64
+#define ZVBI_SLICED_POOL_CLASSES        7
+#define ZVBI_SLICED_POOL_MIN_LINES      16
+#define ZVBI_SLICED_POOL_MAX            16
+
+static ZvbiCaptureBufObj * ZvbiCaptureRawBuf_FreeList[ZVBI_CAPTURE_BUF_FREELIST_MAX];
+static ZvbiCaptureBufObj * ZvbiCaptureSlicedBuf_FreeList[ZVBI_CAPTURE_BUF_FREELIST_MAX];
+static int ZvbiCaptureRawBuf_FreeCount;
+static int ZvbiCaptureSlicedBuf_FreeCount;
+
+// header preceding each array of sliced lines, keeping the allocated capacity
+typedef union {
+    unsigned    capacity;
+    void *      next;
+    double      align;
+} ZvbiSlicedPoolHdr;
+
+static ZvbiSlicedPoolHdr * ZvbiSlicedPool[ZVBI_SLICED_POOL_CLASSES];
+static int ZvbiSlicedPoolCount[ZVBI_SLICED_POOL_CLASSES];
+
+/*
+ * Allocate an array for the given number of sliced lines, which can be
+ * passed to ZvbiCaptureSlicedBuf_FromData(). The caller must hold the GIL.
+ */
+vbi_sliced *
+ZvbiCaptureSlicedBuf_AllocLines(unsigned n_lines)
+{
+    unsigned capacity = ZVBI_SLICED_POOL_MIN_LINES;
+    int cls = 0;
+
+    while ((capacity < n_lines) && (cls < ZVBI_SLICED_POOL_CLASSES)) {
+        capacity *= 2;
+        cls += 1;
+    }
+    ZvbiSlicedPoolHdr * hdr;
+    if (cls < ZVBI_SLICED_POOL_CLASSES) {
+        if (ZvbiSlicedPool[cls] != NULL) {
+            hdr = ZvbiSlicedPool[cls];
+            ZvbiSlicedPool[cls] = hdr->next;
+            ZvbiSlicedPoolCount[cls] -= 1;
+            hdr->capacity = capacity;
+            return (vbi_sliced*) (hdr + 1);
+        }
+    }
+    else {
+        capacity = n_lines;  // too large for pooling
+    }
+    hdr = PyMem_RawMalloc(sizeof(ZvbiSlicedPoolHdr) + capacity * sizeof(vbi_sliced));
+    if (hdr == NULL) {
+        return NULL;
+    }
+    hdr->capacity = capacity;
+    return (vbi_sliced*) (hdr + 1);
+}
+
+/*
+ * Release an array allocated via ZvbiCaptureSlicedBuf_AllocLines().
+ */
+void
+ZvbiCaptureSlicedBuf_FreeLines(vbi_sliced * p_sliced)
+{
+    if (p_sliced != NULL) {
+        ZvbiSlicedPoolHdr * hdr = ((ZvbiSlicedPoolHdr *) p_sliced) - 1;
+        unsigned capacity = ZVBI_SLICED_POOL_MIN_LINES;
+        int cls = 0;
+
+        while ((capacity < hdr->capacity) && (cls < ZVBI_SLICED_POOL_CLASSES)) {
+            capacity *= 2;
+            cls += 1;
+        }
+        if ((cls < ZVBI_SLICED_POOL_CLASSES) && (capacity == hdr->capacity) &&
+            (ZvbiSlicedPoolCount[cls] < ZVBI_SLICED_POOL_MAX))
+        {
+            hdr->next = ZvbiSlicedPool[cls];
+            ZvbiSlicedPool[cls] = hdr;
+            ZvbiSlicedPoolCount[cls] += 1;
+        }
+        else {
+            PyMem_RawFree(hdr);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+//  Lists of buffers referring to storage of the owner
+// ---------------------------------------------------------------------------
+
+/*
+ * Buffers returned by "pull" functions of Zvbi.Capture and passed to the
+ * callback of Zvbi.DvbDemux refer to storage inside of libzvbi, which is
+ * overwritten by the next pull, or after the callback returns respectively.
+ * Such buffers are kept in a list by the owner. Before the storage is
+ * reused, the owner detaches all buffers still in the list by copying their
+ * content into storage owned by the buffer object. As buffers usually are
+ * released before the next pull, no copy is needed in the common case.
+ */
+static void
+ZvbiCaptureBuf_Link(ZvbiCaptureBufObj * self, ZvbiCaptureBufList * list)
+{
+    self->p_list = list;
+    self->prev = NULL;
+    self->next = list->head;
+    if (list->head != NULL) {
+        list->head->prev = self;
+    }
+    list->head = self;
+}
+
+static void
+ZvbiCaptureBuf_Unlink(ZvbiCaptureBufObj * self)
+{
+    if (self->p_list != NULL) {
+        if (self->prev != NULL) {
+            self->prev->next = self->next;
+        }
+        else {
+            self->p_list->head = self->next;
+        }
+        if (self->next != NULL) {
+            self->next->prev = self->prev;
+        }
+        self->p_list = NULL;
+        self->prev = NULL;
+        self->next = NULL;
+    }
+}
+
 // ---------------------------------------------------------------------------
 
 static PyObject *
 ZvbiCaptureBuf_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
+    ZvbiCaptureBufObj * self = NULL;
+
+    if ((type == &ZvbiCaptureRawBufTypeDef) && (ZvbiCaptureRawBuf_FreeCount > 0)) {
+        self = ZvbiCaptureRawBuf_FreeList[--ZvbiCaptureRawBuf_FreeCount];
+    }
+    else if ((type == &ZvbiCaptureSlicedBufTypeDef) && (ZvbiCaptureSlicedBuf_FreeCount > 0)) {
+        self = ZvbiCaptureSlicedBuf_FreeList[--ZvbiCaptureSlicedBuf_FreeCount];
+    }
+    if (self != NULL) {
+        memset((char*)self + sizeof(PyObject), 0, sizeof(*self) - sizeof(PyObject));
+        PyObject_Init((PyObject*) self, type);
+        return (PyObject*) self;
+    }
     return type->tp_alloc(type, 0);
 }
 
+/*
+ * Constructor for sliced buffers that are to be filled by the application
+ * via Zvbi.Capture.read_into(). The buffer can be reused for any number of
+ * capture calls, so that no allocation is needed per frame.
+ */
+static PyObject *
+ZvbiCaptureSlicedBuf_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"max_lines", NULL};
+    unsigned max_lines = 0;
+    ZvbiCaptureBufObj * self = NULL;
+
+    if (PyArg_ParseTupleAndKeywords(args, kwds, "I", kwlist, &max_lines)) {
+        if ((max_lines > 0) && (max_lines <= 0x10000)) {
+            self = (ZvbiCaptureBufObj *) ZvbiCaptureBuf_new(type, NULL, NULL);
+            if (self != NULL) {
+                self->buf = &self->hdr;
+                self->buf->data = ZvbiCaptureSlicedBuf_AllocLines(max_lines);
+                self->buf->size = 0;
+                self->buf->timestamp = 0.0;
+                self->need_free = TRUE;
+                self->max_lines = max_lines;
+
+                if (self->buf->data == NULL) {
+                    Py_DECREF(self);
+                    self = (ZvbiCaptureBufObj *) PyErr_NoMemory();
+                }
+            }
+        }
+        else {
+            PyErr_Format(PyExc_ValueError, "Invalid number of lines: %u", max_lines);
+        }
+    }
+    return (PyObject *) self;
+}
+
 static void
 ZvbiCaptureBuf_dealloc(ZvbiCaptureBufObj *self)
 {
+    PyTypeObject * type = Py_TYPE(self);
+
     // when originating from "pull", self->buf is owned by libzvbi
-    if (self->buf && self->need_free) {
-        if (self->buf->data) {
+    if (self->buf && self->need_free && self->buf->data) {
+        if (PyObject_TypeCheck(self, &ZvbiCaptureSlicedBufTypeDef)) {
+            ZvbiCaptureSlicedBuf_FreeLines(self->buf->data);
+        }
+        else {
             PyMem_RawFree(self->buf->data);
         }
-        PyMem_RawFree(self->buf);
     }
-    Py_TYPE(self)->tp_free((PyObject *) self);
+    ZvbiCaptureBuf_Unlink(self);
+
+    // views reference data of the owner, which is another buffer object
+    if (self->is_view) {
+        ((ZvbiCaptureBufObj*) self->owner)->exports -= 1;
+    }
+    Py_XDECREF(self->owner);
+
+    if ((type == &ZvbiCaptureRawBufTypeDef) &&
+        (ZvbiCaptureRawBuf_FreeCount < ZVBI_CAPTURE_BUF_FREELIST_MAX))
+    {
+        ZvbiCaptureRawBuf_FreeList[ZvbiCaptureRawBuf_FreeCount++] = self;
+    }
+    else if ((type == &ZvbiCaptureSlicedBufTypeDef) &&
+             (ZvbiCaptureSlicedBuf_FreeCount < ZVBI_CAPTURE_BUF_FREELIST_MAX))
+    {
+        ZvbiCaptureSlicedBuf_FreeList[ZvbiCaptureSlicedBuf_FreeCount++] = self;
+    }
+    else {
+        type->tp_free((PyObject *) self);
+    }
 }
 
 static int
 ZvbiCaptureBuf_CheckValid(ZvbiCaptureBufObj * self)
 {
-    if ((self->buf == NULL) || (self->buf->data == NULL) ||
-        ((self->p_validity_src != NULL) && (*self->p_validity_src != self->validity_id)))
-    {
+    if ((self->buf == NULL) || (self->buf->data == NULL)) {
         PyErr_SetString(PyExc_ValueError, "Capture buffer is no longer valid");
         return FALSE;
     }
@@ -81,6 +301,183 @@ ZvbiCaptureBufGetTimestamp(ZvbiCaptureBufObj * self, void * closure)
     return RETVAL;
 }
 
+/*
+ * Create a view on a range of the data of the given buffer. The view shares
+ * the storage of the parent; it keeps a reference to the buffer object
+ * owning the storage, which cannot be refilled while views exist. When the
+ * storage is owned by libzvbi, the view is detached independently of the
+ * parent.
+ */
+static PyObject *
+ZvbiCaptureBuf_NewView(ZvbiCaptureBufObj * parent, PyTypeObject * type, size_t offset, size_t size)
+{
+    ZvbiCaptureBufObj * root = parent->is_view ? (ZvbiCaptureBufObj*) parent->owner : parent;
+
+    ZvbiCaptureBufObj * self = (ZvbiCaptureBufObj*) ZvbiCaptureBuf_new(type, NULL, NULL);
+    if (self != NULL) {
+        self->hdr.data = (uint8_t*)parent->buf->data + offset;
+        self->hdr.size = size;
+        self->hdr.timestamp = parent->buf->timestamp;
+        self->buf = &self->hdr;
+        self->need_free = FALSE;
+        self->is_view = TRUE;
+
+        self->owner = (PyObject*) root;
+        Py_INCREF(root);
+        root->exports += 1;
+
+        if (root->p_list != NULL) {
+            ZvbiCaptureBuf_Link(self, root->p_list);
+        }
+    }
+    return (PyObject*) self;
+}
+
+/*
+ * Store the geometry of a raw frame as given by the sampling parameters,
+ * if consistent with the buffer size.
+ */
+static void
+ZvbiCaptureRawBuf_SetGeometry(ZvbiCaptureBufObj * self, const vbi_raw_decoder * par)
+{
+    if ((par != NULL) && (par->bytes_per_line > 0) &&
+        ((par->count[0] + par->count[1]) * par->bytes_per_line <= self->buf->size))
+    {
+        self->bytes_per_line = par->bytes_per_line;
+        self->field_count[0] = par->count[0];
+        self->field_count[1] = par->count[1];
+        self->interlaced = par->interlaced;
+        self->shape[0] = par->count[0] + par->count[1];
+        self->shape[1] = par->bytes_per_line;
+        self->strides[0] = par->bytes_per_line;
+        self->strides[1] = 1;
+    }
+}
+
+/*
+ * Returns the number of data bytes in a raw buffer. For field views of
+ * interlaced frames, this excludes lines of the other field.
+ */
+static Py_ssize_t
+ZvbiCaptureRawBuf_Length(ZvbiCaptureBufObj * self)
+{
+    if ((self->bytes_per_line > 0) && (self->strides[0] != self->bytes_per_line)) {
+        return self->shape[0] * self->bytes_per_line;
+    }
+    return self->buf->size;
+}
+
+/*
+ * Determine the range of elements selected by a slice key. Returns FALSE
+ * and raises an exception for slices with step other than 1, as these
+ * cannot be represented by a view.
+ */
+static vbi_bool
+ZvbiCaptureBuf_GetSliceRange(PyObject * key, Py_ssize_t length,
+                             Py_ssize_t * p_start, Py_ssize_t * p_count)
+{
+    Py_ssize_t start, stop, step;
+
+    if (PySlice_Unpack(key, &start, &stop, &step) < 0) {
+        return FALSE;
+    }
+    *p_count = PySlice_AdjustIndices(length, &start, &stop, step);
+    if ((step != 1) && (*p_count > 1)) {
+        PyErr_SetString(PyExc_ValueError, "Slices with step other than 1 are not supported");
+        return FALSE;
+    }
+    *p_start = (*p_count > 0) ? start : 0;
+    return TRUE;
+}
+
+/*
+ * Copy the content of a buffer referring to storage of its owner into
+ * storage owned by the object and release the owner. Lines of field views
+ * are compacted. Returns FALSE without raising an exception if memory
+ * could not be allocated; the buffer is unchanged in that case.
+ */
+static vbi_bool
+ZvbiCaptureBuf_CopyData(ZvbiCaptureBufObj * self)
+{
+    void * data;
+    size_t size;
+
+    if (PyObject_TypeCheck(self, &ZvbiCaptureSlicedBufTypeDef)) {
+        unsigned n_lines = self->buf->size / sizeof(vbi_sliced);
+        size = n_lines * sizeof(vbi_sliced);
+        data = ZvbiCaptureSlicedBuf_AllocLines(n_lines);
+        if (data == NULL) {
+            return FALSE;
+        }
+        memcpy(data, self->buf->data, size);
+    }
+    else {
+        size = ZvbiCaptureRawBuf_Length(self);
+        data = PyMem_RawMalloc((size > 0) ? size : 1);
+        if (data == NULL) {
+            return FALSE;
+        }
+        if (size != (size_t)self->buf->size) {
+            for (Py_ssize_t row = 0; row < self->shape[0]; ++row) {
+                memcpy((uint8_t*)data + row * self->bytes_per_line,
+                       (uint8_t*)self->buf->data + row * self->strides[0],
+                       self->bytes_per_line);
+            }
+            self->strides[0] = self->bytes_per_line;
+        }
+        else {
+            memcpy(data, self->buf->data, size);
+        }
+    }
+    self->hdr.timestamp = self->buf->timestamp;
+    self->hdr.data = data;
+    self->hdr.size = size;
+    self->buf = &self->hdr;
+    self->need_free = TRUE;
+
+    if (self->is_view) {
+        ((ZvbiCaptureBufObj*) self->owner)->exports -= 1;
+        self->is_view = FALSE;
+    }
+    Py_CLEAR(self->owner);
+    return TRUE;
+}
+
+/*
+ * Detach all buffers in the given list from the storage of the owner. This
+ * has to be called while holding the GIL, before the storage is reused.
+ * Buffers that cannot be copied for lack of memory become invalid.
+ */
+void
+ZvbiCaptureBufList_Invalidate(ZvbiCaptureBufList * list)
+{
+    ZvbiCaptureBufObj * self;
+
+    // note releasing the owner may deallocate other buffers in the list
+    while ((self = list->head) != NULL) {
+        ZvbiCaptureBuf_Unlink(self);
+
+        if (ZvbiCaptureBuf_CopyData(self) == FALSE) {
+            self->buf = NULL;
+        }
+    }
+}
+
+/*
+ * Copy the content of a buffer returned by "pull" or passed to a callback
+ * into storage owned by the object, so that it remains valid indefinitely.
+ * Buffers that already own their storage are not copied.
+ */
+static PyObject *
+ZvbiCaptureBuf_detach(ZvbiCaptureBufObj *self, PyObject *args)
+{
+    if (!ZvbiCaptureBuf_Detach((PyObject*) self)) {
+        return NULL;
+    }
+    Py_INCREF(self);
+    return (PyObject*) self;
+}
+
 // ---------------------------------------------------------------------------
 // Raw buffer interfaces
 
@@ -89,26 +486,45 @@ ZvbiCaptureRawBuf_GetBuffer(ZvbiCaptureBufObj * self, Py_buffer * view, int flag
 {
     int result = -1;
 
-    if (ZvbiCaptureBuf_CheckValid(self)) {
-        if ((flags & PyBUF_WRITABLE) == 0) {
+    // exported storage must outlive the owner, so pulled buffers are detached first
+    if ((self->p_list != NULL) && !ZvbiCaptureBuf_Detach((PyObject*) self)) {
+        view->obj = NULL;
+    }
+    else if (ZvbiCaptureBuf_CheckValid(self)) {
+        vbi_bool contiguous = ((self->bytes_per_line == 0) || (self->shape[0] <= 1) ||
+                               (self->strides[0] == self->bytes_per_line));
+        if (flags & PyBUF_WRITABLE) {
+            PyErr_SetString(PyExc_BufferError, "CaptureBuf object is read-only");
+            view->obj = NULL;
+        }
+        else if (!contiguous && ((flags & PyBUF_STRIDES) != PyBUF_STRIDES)) {
+            PyErr_SetString(PyExc_BufferError, "Field of interlaced frame is not contiguous");
+            view->obj = NULL;
+        }
+        else {
             view->obj = (PyObject*) self;
             view->buf = self->buf->data;
-            view->len = self->buf->size;
+            view->len = ZvbiCaptureRawBuf_Length(self);
             view->itemsize = 1;
-            view->ndim = 1;
-            view->shape = &view->len;
-            view->strides = &view->itemsize;
             view->suboffsets = NULL;
             view->format = NULL;
             view->readonly = TRUE;
 
+            if ((self->bytes_per_line > 0) && ((flags & PyBUF_ND) == PyBUF_ND)) {
+                // export as 2-dimensional array of lines x bytes
+                view->ndim = 2;
+                view->shape = self->shape;
+                view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? self->strides : NULL;
+            }
+            else {
+                view->ndim = 1;
+                view->shape = &view->len;
+                view->strides = &view->itemsize;
+            }
+
             Py_INCREF(self);
             result = 0;
         }
-        else {
-            PyErr_SetString(PyExc_BufferError, "CaptureBuf object is read-only");
-            view->obj = NULL;
-        }
     }
     else {
         view->obj = NULL;
@@ -123,7 +539,7 @@ Py_ssize_t
 ZvbiCaptureRawBuf_MappingLength(ZvbiCaptureBufObj * self)
 {
     if (ZvbiCaptureBuf_CheckValid(self)) {
-        return self->buf->size;
+        return ZvbiCaptureRawBuf_Length(self);
     }
     return -1;
 }
@@ -137,24 +553,163 @@ ZvbiCaptureRawBuf_MappingSubscript(ZvbiCaptureBufObj * self, PyObject * key)
     PyObject * RETVAL = NULL;
 
     if (ZvbiCaptureBuf_CheckValid(self)) {
-        // FIXME support argement of type slice
-        long idx = PyLong_AsLong(key);
-        if (idx >= 0) {
-            if ((self->buf != NULL) && (idx < self->buf->size)) {
-                uint8_t * item = (uint8_t*)self->buf->data + idx;
-                RETVAL = PyLong_FromLong((unsigned long)*item);
+        Py_ssize_t length = ZvbiCaptureRawBuf_Length(self);
+
+        if (PySlice_Check(key)) {
+            Py_ssize_t start, count;
+            if (length != self->buf->size) {
+                PyErr_SetString(PyExc_ValueError, "Slices of field views are not supported");
             }
-            else {
-                PyErr_SetNone(PyExc_IndexError);
+            else if (ZvbiCaptureBuf_GetSliceRange(key, length, &start, &count)) {
+                RETVAL = ZvbiCaptureBuf_NewView(self, &ZvbiCaptureRawBufTypeDef, start, count);
+                int bpl = self->bytes_per_line;
+                if ((RETVAL != NULL) && (bpl > 0) && (start % bpl == 0) && (count % bpl == 0)) {
+                    // keep 2-dimensional export for ranges of complete lines
+                    ZvbiCaptureBufObj * view = (ZvbiCaptureBufObj*) RETVAL;
+                    view->bytes_per_line = bpl;
+                    view->shape[0] = count / bpl;
+                    view->shape[1] = bpl;
+                    view->strides[0] = bpl;
+                    view->strides[1] = 1;
+                }
             }
         }
+        else {
+            Py_ssize_t idx = PyNumber_AsSsize_t(key, PyExc_IndexError);
+            if ((idx != -1) || !PyErr_Occurred()) {
+                if (idx < 0) {
+                    idx += length;
+                }
+                if ((idx >= 0) && (idx < length)) {
+                    if (length != self->buf->size) {
+                        idx = (idx / self->bytes_per_line) * self->strides[0] + (idx % self->bytes_per_line);
+                    }
+                    uint8_t * item = (uint8_t*)self->buf->data + idx;
+                    RETVAL = PyLong_FromLong((unsigned long)*item);
+                }
+                else {
+                    PyErr_SetNone(PyExc_IndexError);
+                }
+            }
+        }
+    }
+    return RETVAL;
+}
+
+/*
+ * Return a 2-dimensional memoryview on the lines of one field of the frame.
+ * Pulled frames are detached first, as the memoryview has to remain valid
+ * after the storage of the capture context is reused or freed.
+ */
+static PyObject *
+ZvbiCaptureRawBuf_field(ZvbiCaptureBufObj * self, PyObject * args)
+{
+    int field = 0;
+
+    if (!PyArg_ParseTuple(args, "i", &field) || !ZvbiCaptureBuf_CheckValid(self)) {
+        return NULL;
+    }
+    if ((field != 0) && (field != 1)) {
+        PyErr_Format(PyExc_ValueError, "Invalid field index %d (must be 0 or 1)", field);
+        return NULL;
+    }
+    if ((self->bytes_per_line == 0) || (self->field_count[0] + self->field_count[1] == 0)) {
+        PyErr_SetString(PyExc_ValueError, "Buffer does not contain a complete frame with known geometry");
+        return NULL;
+    }
+    int bpl = self->bytes_per_line;
+    int count = self->field_count[field];
+    size_t offset;
+    size_t stride;
+
+    if (self->interlaced) {
+        // lines of both fields alternate, starting with the first field
+        offset = field * bpl;
+        stride = 2 * bpl;
+        if ((count > 0) && (offset + (count - 1) * stride + bpl > (size_t)self->buf->size)) {
+            PyErr_SetString(PyExc_ValueError, "Field line counts are inconsistent with interlaced frame");
+            return NULL;
+        }
     }
+    else {
+        offset = field * self->field_count[0] * bpl;
+        stride = bpl;
+    }
+    size_t size = (count > 0) ? ((count - 1) * stride + bpl) : 0;
+
+    if (!ZvbiCaptureBuf_Detach((PyObject*) self)) {
+        return NULL;
+    }
+    ZvbiCaptureBufObj * view = (ZvbiCaptureBufObj*)
+        ZvbiCaptureBuf_NewView(self, &ZvbiCaptureRawBufTypeDef, offset, size);
+    if (view == NULL) {
+        return NULL;
+    }
+    view->bytes_per_line = bpl;
+    view->shape[0] = count;
+    view->shape[1] = bpl;
+    view->strides[0] = stride;
+    view->strides[1] = 1;
+
+    PyObject * RETVAL = PyMemoryView_FromObject((PyObject*) view);
+    Py_DECREF(view);
     return RETVAL;
 }
 
 // ---------------------------------------------------------------------------
 // Sliced buffer interfaces
 
+// Most recently returned line tuple, for reuse once released by the caller
+static PyObject * ZvbiCaptureSlicedLine_Cache = NULL;
+
+/*
+ * Create a named tuple with the content of one sliced line. When the tuple
+ * returned by the previous call is no longer referenced by the caller (as
+ * is the case when unpacking it within a loop), it is reused instead of
+ * allocating a new one.
+ */
+PyObject *
+ZvbiCaptureSlicedLine_FromSliced(const vbi_sliced * p_sliced)
+{
+    PyObject * items[3];
+    PyObject * RETVAL;
+
+    items[0] = PyBytes_FromStringAndSize((char*)p_sliced->data, sizeof(p_sliced->data));
+    items[1] = PyLong_FromLong(p_sliced->id);
+    items[2] = PyLong_FromLong(p_sliced->line);
+    if ((items[0] == NULL) || (items[1] == NULL) || (items[2] == NULL)) {
+        Py_XDECREF(items[0]);
+        Py_XDECREF(items[1]);
+        Py_XDECREF(items[2]);
+        return NULL;
+    }
+
+    if ((ZvbiCaptureSlicedLine_Cache != NULL) && (Py_REFCNT(ZvbiCaptureSlicedLine_Cache) == 1)) {
+        RETVAL = ZvbiCaptureSlicedLine_Cache;
+        Py_INCREF(RETVAL);
+        for (int idx = 0; idx < 3; ++idx) {
+            PyObject * old = PyStructSequence_GetItem(RETVAL, idx);
+            PyStructSequence_SetItem(RETVAL, idx, items[idx]);
+            Py_XDECREF(old);
+        }
+    }
+    else {
+        RETVAL = PyStructSequence_New(ZvbiCaptureSlicedLineType);
+        if (RETVAL == NULL) {
+            Py_DECREF(items[0]);
+            Py_DECREF(items[1]);
+            Py_DECREF(items[2]);
+            return NULL;
+        }
+        for (int idx = 0; idx < 3; ++idx) {
+            PyStructSequence_SetItem(RETVAL, idx, items[idx]);
+        }
+        Py_INCREF(RETVAL);
+        Py_XSETREF(ZvbiCaptureSlicedLine_Cache, RETVAL);
+    }
+    return RETVAL;
+}
+
 /*
  * Implementation of the standard "__iter__" function
  */
@@ -190,13 +745,8 @@ ZvbiCaptureSlicedBuf_IterNext(ZvbiCaptureBufObj *self)
         if ((p_sliced != NULL) && (self->iter_idx < max_lines)) {
             p_sliced += self->iter_idx;
 
-            RETVAL = PyStructSequence_New(ZvbiCaptureSlicedLineType);
+            RETVAL = ZvbiCaptureSlicedLine_FromSliced(p_sliced);
             if (RETVAL != NULL) {
-                PyStructSequence_SetItem(RETVAL, 0, PyBytes_FromStringAndSize((char*)p_sliced->data,
-                                                                              sizeof(p_sliced->data)));
-                PyStructSequence_SetItem(RETVAL, 1, PyLong_FromLong(p_sliced->id));
-                PyStructSequence_SetItem(RETVAL, 2, PyLong_FromLong(p_sliced->line));
-
                 self->iter_idx += 1;
             }
         }
@@ -208,6 +758,64 @@ ZvbiCaptureSlicedBuf_IterNext(ZvbiCaptureBufObj *self)
     return RETVAL;
 }
 
+/*
+ * Implementation of the "buffer protocol" for sliced data: the buffer is
+ * exported as a one-dimensional array of structures, each corresponding to
+ * one vbi_sliced element. This allows e.g. numpy to access the data as a
+ * record array without copying. Buffers referring to storage of a capture
+ * context are detached before exporting, as the lazy detaching upon the next
+ * pull cannot redirect memoryviews that were already handed out.
+ */
+static int
+ZvbiCaptureSlicedBuf_GetBuffer(ZvbiCaptureBufObj * self, Py_buffer * view, int flags)
+{
+    // must match the layout of struct vbi_sliced
+    static char format[] = "T{I:ident:I:line_no:56s:data:}";
+    int result = -1;
+
+    view->obj = NULL;
+    if (ZvbiCaptureBuf_CheckValid(self)) {
+        if (flags & PyBUF_WRITABLE) {
+            PyErr_SetString(PyExc_BufferError, "CaptureBuf object is read-only");
+        }
+        // exported storage must outlive the owner, so pulled buffers are detached first
+        else if ((self->p_list == NULL) || ZvbiCaptureBuf_Detach((PyObject*) self)) {
+            // shape is stored per view, as the line count of the object may change
+            Py_ssize_t * p_shape = PyMem_Malloc(sizeof(Py_ssize_t));
+            if (p_shape != NULL) {
+                *p_shape = self->buf->size / sizeof(vbi_sliced);
+
+                view->obj = (PyObject*) self;
+                view->buf = self->buf->data;
+                view->len = *p_shape * sizeof(vbi_sliced);
+                view->itemsize = sizeof(vbi_sliced);
+                view->ndim = 1;
+                view->format = (flags & PyBUF_FORMAT) ? format : NULL;
+                view->shape = (flags & PyBUF_ND) ? p_shape : NULL;
+                view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? &view->itemsize : NULL;
+                view->suboffsets = NULL;
+                view->readonly = TRUE;
+                view->internal = p_shape;
+
+                self->exports += 1;
+                Py_INCREF(self);
+                result = 0;
+            }
+            else {
+                PyErr_NoMemory();
+            }
+        }
+    }
+    return result;
+}
+
+static void
+ZvbiCaptureSlicedBuf_ReleaseBuffer(ZvbiCaptureBufObj * self, Py_buffer * view)
+{
+    PyMem_Free(view->internal);
+    self->exports -= 1;
+}
+
 /*
  * Implmentation of the len() operator
  */
@@ -237,32 +845,127 @@ PyObject * ZvbiCaptureSlicedBuf_MappingSubscript(ZvbiCaptureBufObj * self, PyObj
     PyObject * RETVAL = NULL;
 
     if (ZvbiCaptureBuf_CheckValid(self)) {
-        // FIXME support argement of type slice
-        long idx = PyLong_AsLong(key);
-        if (idx >= 0) {
-            vbi_capture_buffer * p_sliced_buf = self->buf;
-            if (p_sliced_buf != NULL) {
-                // note "size" element was calculated from "n_lines" slicer result
-                // (i.e. not the allocated buffer size, which may be larger)
-                max_lines = p_sliced_buf->size / sizeof(vbi_sliced);
-                p_sliced = p_sliced_buf->data;
+        // note "size" element was calculated from "n_lines" slicer result
+        // (i.e. not the allocated buffer size, which may be larger)
+        max_lines = self->buf->size / sizeof(vbi_sliced);
+        p_sliced = self->buf->data;
+
+        if (PySlice_Check(key)) {
+            Py_ssize_t start, count;
+            if (ZvbiCaptureBuf_GetSliceRange(key, max_lines, &start, &count)) {
+                RETVAL = ZvbiCaptureBuf_NewView(self, &ZvbiCaptureSlicedBufTypeDef,
+                                                start * sizeof(vbi_sliced),
+                                                count * sizeof(vbi_sliced));
             }
-            if ((p_sliced != NULL) && (idx < max_lines)) {
-                p_sliced += idx;
-
-                RETVAL = PyStructSequence_New(ZvbiCaptureSlicedLineType);
-                if (RETVAL != NULL) {
-                    PyStructSequence_SetItem(RETVAL, 0, PyBytes_FromStringAndSize((char*)p_sliced->data,
-                                                                                  sizeof(p_sliced->data)));
-                    PyStructSequence_SetItem(RETVAL, 1, PyLong_FromLong(p_sliced->id));
-                    PyStructSequence_SetItem(RETVAL, 2, PyLong_FromLong(p_sliced->line));
+        }
+        else {
+            Py_ssize_t idx = PyNumber_AsSsize_t(key, PyExc_IndexError);
+            if ((idx != -1) || !PyErr_Occurred()) {
+                if (idx < 0) {
+                    idx += max_lines;
+                }
+                if ((idx >= 0) && (idx < max_lines)) {
+                    p_sliced += idx;
+
+                    RETVAL = ZvbiCaptureSlicedLine_FromSliced(p_sliced);
+                }
+                else {
+                    PyErr_SetNone(PyExc_IndexError);
                 }
             }
-            else {
-                PyErr_SetNone(PyExc_IndexError);
+        }
+    }
+    return RETVAL;
+}
+
+/*
+ * Create a new sliced buffer object containing copies of all lines of the
+ * given buffer which match the given service mask.
+ */
+static PyObject *
+ZvbiCaptureSlicedBuf_Select(vbi_capture_buffer * src, unsigned mask)
+{
+    const vbi_sliced * p_src = src->data;
+    unsigned src_lines = src->size / sizeof(vbi_sliced);
+    unsigned n_lines = 0;
+
+    for (unsigned idx = 0; idx < src_lines; ++idx) {
+        if (p_src[idx].id & mask) {
+            n_lines += 1;
+        }
+    }
+    vbi_sliced * data = ZvbiCaptureSlicedBuf_AllocLines(n_lines);
+    if (data == NULL) {
+        return PyErr_NoMemory();
+    }
+    vbi_sliced * p_dst = data;
+    for (unsigned idx = 0; idx < src_lines; ++idx) {
+        if (p_src[idx].id & mask) {
+            *(p_dst++) = p_src[idx];
+        }
+    }
+    PyObject * RETVAL = ZvbiCaptureSlicedBuf_FromData(data, n_lines, src->timestamp);
+    if (RETVAL == NULL) {
+        ZvbiCaptureSlicedBuf_FreeLines(data);
+    }
+    return RETVAL;
+}
+
+static PyObject *
+ZvbiCaptureSlicedBuf_select(ZvbiCaptureBufObj *self, PyObject *args)
+{
+    unsigned mask = 0;
+
+    if (!PyArg_ParseTuple(args, "I", &mask) || !ZvbiCaptureBuf_CheckValid(self)) {
+        return NULL;
+    }
+    return ZvbiCaptureSlicedBuf_Select(self->buf, mask);
+}
+
+static PyObject *
+ZvbiCaptureSlicedBuf_partition(ZvbiCaptureBufObj *self, PyObject *args)
+{
+    // default groups: teletext, VPS, WSS, closed caption
+    static const unsigned default_masks[] = {
+        VBI_SLICED_TELETEXT_B | VBI_SLICED_TELETEXT_B_525,
+        VBI_SLICED_VPS | VBI_SLICED_VPS_F2,
+        VBI_SLICED_WSS_625 | VBI_SLICED_WSS_CPR1204,
+        VBI_SLICED_CAPTION_625 | VBI_SLICED_CAPTION_525 | VBI_SLICED_2xCAPTION_525,
+    };
+    Py_ssize_t mask_cnt = PyTuple_GET_SIZE(args);
+    unsigned masks[32];
+
+    if (mask_cnt == 0) {
+        mask_cnt = sizeof(default_masks) / sizeof(default_masks[0]);
+        memcpy(masks, default_masks, sizeof(default_masks));
+    }
+    else if (mask_cnt <= 32) {
+        for (Py_ssize_t idx = 0; idx < mask_cnt; ++idx) {
+            masks[idx] = PyLong_AsUnsignedLong(PyTuple_GET_ITEM(args, idx));
+            if (PyErr_Occurred()) {
+                return NULL;
             }
         }
     }
+    else {
+        PyErr_SetString(PyExc_ValueError, "Too many service masks (max. 32)");
+        return NULL;
+    }
+    if (!ZvbiCaptureBuf_CheckValid(self)) {
+        return NULL;
+    }
+
+    PyObject * RETVAL = PyTuple_New(mask_cnt);
+    if (RETVAL != NULL) {
+        for (Py_ssize_t idx = 0; idx < mask_cnt; ++idx) {
+            PyObject * part = ZvbiCaptureSlicedBuf_Select(self->buf, masks[idx]);
+            if (part == NULL) {
+                Py_DECREF(RETVAL);
+                return NULL;
+            }
+            PyTuple_SET_ITEM(RETVAL, idx, part);
+        }
+    }
     return RETVAL;
 }
 
@@ -293,6 +996,14 @@ static PyGetSetDef ZvbiCaptureBufGetSetDef[] =
     {NULL}
 };
 
+static PyMethodDef ZvbiCaptureRawBuf_MethodsDef[] =
+{
+    {"field",  (PyCFunction) ZvbiCaptureRawBuf_field, METH_VARARGS, NULL },
+    {"detach", (PyCFunction) ZvbiCaptureBuf_detach,   METH_NOARGS, NULL },
+
+    {NULL}  /* Sentinel */
+};
+
 // Implementing the "buffer protocol", i.e. access to encapsulated data via Py_buffer
 static PyBufferProcs ZvbiCaptureRawBufAsBufferDef =
 {
@@ -320,10 +1031,27 @@ PyTypeObject ZvbiCaptureRawBufTypeDef =
     .tp_dealloc = (destructor) ZvbiCaptureBuf_dealloc,
     .tp_base = &ZvbiCaptureBufTypeDef,
     .tp_getset = ZvbiCaptureBufGetSetDef,
+    .tp_methods = ZvbiCaptureRawBuf_MethodsDef,
     .tp_as_buffer = &ZvbiCaptureRawBufAsBufferDef,
     .tp_as_mapping = &ZvbiCaptureRawBufMappingDef,
 };
 
+static PyMethodDef ZvbiCaptureSlicedBuf_MethodsDef[] =
+{
+    {"select",    (PyCFunction) ZvbiCaptureSlicedBuf_select,    METH_VARARGS, NULL },
+    {"partition", (PyCFunction) ZvbiCaptureSlicedBuf_partition, METH_VARARGS, NULL },
+    {"detach",    (PyCFunction) ZvbiCaptureBuf_detach,          METH_NOARGS, NULL },
+
+    {NULL}  /* Sentinel */
+};
+
+// Implementing the "buffer protocol", i.e. access to encapsulated data via Py_buffer
+static PyBufferProcs ZvbiCaptureSlicedBufAsBufferDef =
+{
+    .bf_getbuffer = (getbufferproc) ZvbiCaptureSlicedBuf_GetBuffer,
+    .bf_releasebuffer = (releasebufferproc) ZvbiCaptureSlicedBuf_ReleaseBuffer
+};
+
 // Implementing the "mapping protocol", i.e. access via array sub-script
 static PyMappingMethods ZvbiCaptureSlicedBufMappingDef =
 {
@@ -340,12 +1068,14 @@ PyTypeObject ZvbiCaptureSlicedBufTypeDef =
     .tp_basicsize = sizeof(ZvbiCaptureBufObj),
     .tp_itemsize = 0,
     .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
-    .tp_new = ZvbiCaptureBuf_new,
+    .tp_new = ZvbiCaptureSlicedBuf_new,
     .tp_dealloc = (destructor) ZvbiCaptureBuf_dealloc,
     .tp_base = &ZvbiCaptureBufTypeDef,
     .tp_getset = ZvbiCaptureBufGetSetDef,
+    .tp_methods = ZvbiCaptureSlicedBuf_MethodsDef,
     .tp_iter = (getiterfunc) ZvbiCaptureSlicedBuf_Iter,
     .tp_iternext = (iternextfunc) ZvbiCaptureSlicedBuf_IterNext,
+    .tp_as_buffer = &ZvbiCaptureSlicedBufAsBufferDef,
     .tp_as_mapping = &ZvbiCaptureSlicedBufMappingDef,
 };
 
@@ -380,44 +1110,109 @@ ZvbiCaptureBuf_GetBuf(PyObject * obj)
     return self->buf;
 }
 
+/*
+ * Detach the given buffer object from storage that is going to be reused
+ * by its owner, same as method detach(). This is required before the
+ * content is accessed with the GIL released, as the capture context may
+ * refill its storage meanwhile in another thread. Returns FALSE and raises
+ * an exception upon error.
+ */
+vbi_bool
+ZvbiCaptureBuf_Detach(PyObject * obj)
+{
+    assert(PyObject_IsInstance(obj, (PyObject*)&ZvbiCaptureBufTypeDef) == 1);
+    ZvbiCaptureBufObj * self = (ZvbiCaptureBufObj*) obj;
+
+    if (!ZvbiCaptureBuf_CheckValid(self)) {
+        return FALSE;
+    }
+    if (self->p_list != NULL) {
+        // unlink first, as releasing the owner may invalidate its list
+        ZvbiCaptureBufList * list = self->p_list;
+        ZvbiCaptureBuf_Unlink(self);
+
+        if (ZvbiCaptureBuf_CopyData(self) == FALSE) {
+            ZvbiCaptureBuf_Link(self, list);
+            PyErr_NoMemory();
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * Returns the buffer of a sliced buffer object instantiated by the
+ * application, for filling it in-place. Returns NULL and raises an exception
+ * for buffers created by capture functions, as these are owned by libzvbi or
+ * sized for a single frame.
+ */
+vbi_capture_buffer *
+ZvbiCaptureSlicedBuf_GetFillable(PyObject * obj, unsigned * p_max_lines)
+{
+    if (PyObject_IsInstance(obj, (PyObject*)&ZvbiCaptureSlicedBufTypeDef) != 1) {
+        PyErr_Format(PyExc_TypeError, "Expected object of type Zvbi.CaptureSlicedBuf, got %s",
+                     Py_TYPE(obj)->tp_name);
+        return NULL;
+    }
+    ZvbiCaptureBufObj * self = (ZvbiCaptureBufObj*) obj;
+    if ((self->max_lines == 0) || (self->buf == NULL) || (self->buf->data == NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Sliced buffer was not created via constructor");
+        return NULL;
+    }
+    if (self->exports > 0) {
+        // content must not change while referenced e.g. by a memoryview
+        PyErr_SetString(PyExc_BufferError, "Sliced buffer cannot be filled while it is exported");
+        return NULL;
+    }
+    *p_max_lines = self->max_lines;
+    return self->buf;
+}
+
 PyObject *
-ZvbiCaptureRawBuf_FromPtr(vbi_capture_buffer * ptr, const int * validity_src)
+ZvbiCaptureRawBuf_FromPtr(vbi_capture_buffer * ptr, PyObject * owner, ZvbiCaptureBufList * list,
+                          const vbi_raw_decoder * par)
 {
     ZvbiCaptureBufObj * self = (ZvbiCaptureBufObj*) ZvbiCaptureBuf_new(&ZvbiCaptureRawBufTypeDef, NULL, NULL);
     if (self != NULL) {
         self->buf = ptr;
         self->need_free = FALSE;
 
-        self->p_validity_src = validity_src;
-        self->validity_id = *validity_src;
+        self->owner = owner;
+        Py_INCREF(owner);
+        ZvbiCaptureBuf_Link(self, list);
+
+        ZvbiCaptureRawBuf_SetGeometry(self, par);
     }
     return (PyObject*) self;
 }
 
 PyObject *
-ZvbiCaptureRawBuf_FromData(char * data, int size, double timestamp)
+ZvbiCaptureRawBuf_FromData(char * data, int size, double timestamp, const vbi_raw_decoder * par)
 {
     ZvbiCaptureBufObj * self = (ZvbiCaptureBufObj*) ZvbiCaptureBuf_new(&ZvbiCaptureRawBufTypeDef, NULL, NULL);
     if (self != NULL) {
-        self->buf = PyMem_RawMalloc(sizeof(vbi_capture_buffer));
+        self->buf = &self->hdr;
         self->buf->data = data;
         self->buf->size = size;
         self->buf->timestamp = timestamp;
         self->need_free = TRUE;
+
+        ZvbiCaptureRawBuf_SetGeometry(self, par);
     }
     return (PyObject*) self;
 }
 
 PyObject *
-ZvbiCaptureSlicedBuf_FromPtr(vbi_capture_buffer * ptr, const int * validity_src)
+ZvbiCaptureSlicedBuf_FromPtr(vbi_capture_buffer * ptr, PyObject * owner, ZvbiCaptureBufList * list)
 {
     ZvbiCaptureBufObj * self = (ZvbiCaptureBufObj*) ZvbiCaptureBuf_new(&ZvbiCaptureSlicedBufTypeDef, NULL, NULL);
     if (self != NULL) {
         self->buf = ptr;
         self->need_free = FALSE;
 
-        self->p_validity_src = validity_src;
-        self->validity_id = *validity_src;
+        self->owner = owner;
+        Py_INCREF(owner);
+        ZvbiCaptureBuf_Link(self, list);
     }
     return (PyObject*) self;
 }
@@ -427,7 +1222,7 @@ ZvbiCaptureSlicedBuf_FromData(vbi_sliced * data, int n_lines, double timestamp)
 {
     ZvbiCaptureBufObj * self = (ZvbiCaptureBufObj*) ZvbiCaptureBuf_new(&ZvbiCaptureSlicedBufTypeDef, NULL, NULL);
     if (self != NULL) {
-        self->buf = PyMem_RawMalloc(sizeof(vbi_capture_buffer));
+        self->buf = &self->hdr;
         self->buf->data = data;
         self->buf->size = n_lines * sizeof(vbi_sliced);
         self->buf->timestamp = timestamp;
@@ -436,6 +1231,22 @@ ZvbiCaptureSlicedBuf_FromData(vbi_sliced * data, int n_lines, double timestamp)
     return (PyObject*) self;
 }
 
+/*
+ * Create a view on a range of lines of the given sliced buffer, with its own
+ * timestamp. This is used for returning multiple frames stored in one block.
+ */
+PyObject *
+ZvbiCaptureSlicedBuf_NewView(PyObject * parent, unsigned start, unsigned n_lines, double timestamp)
+{
+    ZvbiCaptureBufObj * self = (ZvbiCaptureBufObj*)
+        ZvbiCaptureBuf_NewView((ZvbiCaptureBufObj*) parent, &ZvbiCaptureSlicedBufTypeDef,
+                               start * sizeof(vbi_sliced), n_lines * sizeof(vbi_sliced));
+    if (self != NULL) {
+        self->hdr.timestamp = timestamp;
+    }
+    return (PyObject*) self;
+}
+
 int PyInit_CaptureBuf(PyObject * module, PyObject * error_base)
 {
     if ((PyType_Ready(&ZvbiCaptureBufTypeDef) < 0) ||
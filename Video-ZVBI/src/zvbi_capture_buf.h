@@ -14,12 +14,31 @@
 #if !defined (_PY_ZVBI_RAWBUF_H)
 #define _PY_ZVBI_RAWBUF_H
 
+/*
+ * List of buffer objects referring to storage that is going to be reused by
+ * the owner, i.e. the capture context or de-multiplexer. The owner has to
+ * call ZvbiCaptureBufList_Invalidate() before reusing the storage.
+ */
+typedef struct {
+    struct ZvbiCaptureBufObj_s * head;
+} ZvbiCaptureBufList;
+
+void ZvbiCaptureBufList_Invalidate(ZvbiCaptureBufList * list);
+
 vbi_capture_buffer * ZvbiCaptureBuf_GetBuf(PyObject * obj);
+vbi_bool ZvbiCaptureBuf_Detach(PyObject * obj);
+vbi_capture_buffer * ZvbiCaptureSlicedBuf_GetFillable(PyObject * obj, unsigned * p_max_lines);
 
-PyObject * ZvbiCaptureRawBuf_FromPtr(vbi_capture_buffer * ptr, const int * validity_src);
-PyObject * ZvbiCaptureRawBuf_FromData(char * data, int size, double timestamp);
-PyObject * ZvbiCaptureSlicedBuf_FromPtr(vbi_capture_buffer * ptr, const int * validity_src);
+PyObject * ZvbiCaptureRawBuf_FromPtr(vbi_capture_buffer * ptr, PyObject * owner, ZvbiCaptureBufList * list,
+                                     const vbi_raw_decoder * par);
+PyObject * ZvbiCaptureRawBuf_FromData(char * data, int size, double timestamp, const vbi_raw_decoder * par);
+PyObject * ZvbiCaptureSlicedBuf_FromPtr(vbi_capture_buffer * ptr, PyObject * owner, ZvbiCaptureBufList * list);
 PyObject * ZvbiCaptureSlicedBuf_FromData(vbi_sliced * data, int n_lines, double timestamp);
+PyObject * ZvbiCaptureSlicedBuf_NewView(PyObject * parent, unsigned start, unsigned n_lines, double timestamp);
+
+vbi_sliced * ZvbiCaptureSlicedBuf_AllocLines(unsigned n_lines);
+void ZvbiCaptureSlicedBuf_FreeLines(vbi_sliced * p_sliced);
+PyObject * ZvbiCaptureSlicedLine_FromSliced(const vbi_sliced * p_sliced);
 
 extern PyTypeObject ZvbiCaptureRawBufTypeDef;
 extern PyTypeObject ZvbiCaptureSlicedBufTypeDef;
@@ -0,0 +1,624 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include "Python.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <libzvbi.h>
+
+#include "zvbi_capture.h"
+#include "zvbi_capture_replay.h"
+#include "zvbi_sliced_file.h"
+
+// ---------------------------------------------------------------------------
+//  Capture back-end replaying recorded data from a file
+// ---------------------------------------------------------------------------
+
+/*
+ * The functions below (except for creation and deletion) are called with the
+ * GIL released, so they must not use any Python interfaces. Serialization is
+ * done by the caller via the capture object's lock.
+ */
+
+typedef enum {
+    ZVBI_REPLAY_FMT_RAW,
+    ZVBI_REPLAY_FMT_SLICED,
+    ZVBI_REPLAY_FMT_PES,
+    ZVBI_REPLAY_FMT_TS,
+} ZvbiCaptureReplayFormat;
+
+#define IO_BUF_SIZE     (188 * 1024)
+#define TS_PACKET_SIZE  188
+
+#if !defined (ENODATA)
+#define ENODATA ENOENT
+#endif
+
+struct ZvbiCaptureReplay_s {
+    FILE *                  fp;
+    ZvbiCaptureReplayFormat fmt;
+    vbi_bool                realtime;
+    vbi_bool                eof;
+
+    vbi_raw_decoder         par;        // parameters; also used for decoding raw data
+    size_t                  raw_size;
+    unsigned                max_lines;
+    double                  frame_period;
+
+    // input buffer for formats parsed in chunks
+    uint8_t *               io_buf;
+    size_t                  io_start;
+    size_t                  io_end;
+
+    // DVB de-multiplexer for PES and TS formats
+    vbi_dvb_demux *         dvb_demux;
+    uint8_t *               pes_buf;
+    const uint8_t *         feed_ptr;
+    unsigned                feed_left;
+    unsigned                ts_pid;
+    int64_t                 last_pts;
+
+    // content and time of the current frame
+    vbi_bool                frame_valid;
+    uint8_t *               raw_data;
+    vbi_sliced *            sliced_data;
+    unsigned                n_lines;
+    double                  frame_time;     // seconds since start of the recording
+    unsigned long           frame_cnt;
+    vbi_capture_buffer      raw_cb;
+    vbi_capture_buffer      sliced_cb;
+
+    // reference points for pacing and timestamps
+    vbi_bool                started;
+    double                  first_frame_time;
+    struct timespec         start_mono;
+    double                  start_wall;
+};
+
+// ---------------------------------------------------------------------------
+
+static void
+ZvbiCaptureReplay_AddTime(struct timespec * ts, double sec)
+{
+    time_t whole = (time_t) sec;
+    ts->tv_sec += whole;
+    ts->tv_nsec += (long)((sec - whole) * 1E9);
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec += 1;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static vbi_bool
+ZvbiCaptureReplay_IsBefore(const struct timespec * a, const struct timespec * b)
+{
+    return (a->tv_sec < b->tv_sec) ||
+           ((a->tv_sec == b->tv_sec) && (a->tv_nsec < b->tv_nsec));
+}
+
+static void
+ZvbiCaptureReplay_SleepUntil(const struct timespec * due)
+{
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, due, NULL) == EINTR) {
+    }
+}
+
+/*
+ * Read more data into the input buffer, after moving unprocessed data to the
+ * start of the buffer. Returns the number of bytes read, or 0 at the end of
+ * the file or upon error (errno is set).
+ */
+static size_t
+ZvbiCaptureReplay_FillBuffer(ZvbiCaptureReplay * r)
+{
+    if (r->io_start > 0) {
+        memmove(r->io_buf, r->io_buf + r->io_start, r->io_end - r->io_start);
+        r->io_end -= r->io_start;
+        r->io_start = 0;
+    }
+    size_t len = fread(r->io_buf + r->io_end, 1, IO_BUF_SIZE - r->io_end, r->fp);
+    if (len == 0) {
+        if (ferror(r->fp)) {
+            if (errno == 0) {
+                errno = EIO;
+            }
+        }
+        else {
+            r->eof = TRUE;
+            errno = ENODATA;
+        }
+    }
+    r->io_end += len;
+    return len;
+}
+
+/*
+ * Check if the TS packet payload at the given offset starts a PES packet
+ * carrying VBI data: private_stream_1 is used also for AC-3 audio and DVB
+ * subtitles, so the data_identifier following the PES header has to be
+ * checked (EN 300 472: 0x10..0x1F; EN 301 775: 0x99..0x9B).
+ */
+static vbi_bool
+ZvbiCaptureReplay_TsIsVbiPes(const uint8_t * p, unsigned off)
+{
+    if ((off + 9 <= TS_PACKET_SIZE) &&
+        (p[off] == 0) && (p[off + 1] == 0) && (p[off + 2] == 1) && (p[off + 3] == 0xBD) &&
+        ((p[off + 6] & 0xC0) == 0x80))
+    {
+        unsigned data_off = off + 9 + p[off + 8];
+        if (data_off < TS_PACKET_SIZE) {
+            uint8_t data_id = p[data_off];
+            return ((data_id >= 0x10) && (data_id <= 0x1F)) ||
+                   ((data_id >= 0x99) && (data_id <= 0x9B));
+        }
+    }
+    return FALSE;
+}
+
+/*
+ * Copy the payload of TS packets carrying the VBI stream from the input
+ * buffer into the PES buffer. Unless configured, the PID is determined from
+ * the first packet starting a PES packet with VBI data.
+ */
+static size_t
+ZvbiCaptureReplay_TsExtract(ZvbiCaptureReplay * r)
+{
+    size_t out = 0;
+
+    while (r->io_end - r->io_start >= TS_PACKET_SIZE) {
+        const uint8_t * p = r->io_buf + r->io_start;
+        if (p[0] != 0x47) {
+            // lost sync: search for the next sync byte
+            r->io_start += 1;
+            continue;
+        }
+        r->io_start += TS_PACKET_SIZE;
+
+        unsigned pid = ((p[1] & 0x1F) << 8) | p[2];
+        unsigned adaptation = (p[3] >> 4) & 3;
+        unsigned off = 4;
+
+        if ((p[1] & 0x80) || !(adaptation & 1)) {
+            continue;  // transport error or no payload
+        }
+        if (adaptation & 2) {
+            off += 1 + p[4];
+            if (off >= TS_PACKET_SIZE) {
+                continue;
+            }
+        }
+        if (r->ts_pid == 0) {
+            if ((p[1] & 0x40) && ZvbiCaptureReplay_TsIsVbiPes(p, off)) {
+                r->ts_pid = pid;
+            }
+            else {
+                continue;
+            }
+        }
+        if (pid == r->ts_pid) {
+            memcpy(r->pes_buf + out, p + off, TS_PACKET_SIZE - off);
+            out += TS_PACKET_SIZE - off;
+        }
+    }
+    return out;
+}
+
+static int
+ZvbiCaptureReplay_LoadRaw(ZvbiCaptureReplay * r)
+{
+    size_t len = fread(r->raw_data, 1, r->raw_size, r->fp);
+    if (len != r->raw_size) {
+        if (ferror(r->fp)) {
+            if (errno == 0) {
+                errno = EIO;
+            }
+        }
+        else {
+            // a trailing partial frame is ignored
+            r->eof = TRUE;
+            errno = ENODATA;
+        }
+        return -1;
+    }
+    r->n_lines = vbi_raw_decode(&r->par, r->raw_data, r->sliced_data);
+    r->frame_time = r->frame_cnt * r->frame_period;
+    return 1;
+}
+
+static int
+ZvbiCaptureReplay_LoadSliced(ZvbiCaptureReplay * r)
+{
+    for (;;) {
+        unsigned n_lines = 0;
+        double delta = 0.0;
+        size_t used = 0;
+        int st = ZvbiSlicedFile_ParseFrame(r->io_buf + r->io_start, r->io_end - r->io_start,
+                                           r->sliced_data, r->max_lines,
+                                           &n_lines, &delta, &used);
+        if (st > 0) {
+            r->io_start += used;
+            r->n_lines = n_lines;
+            // time stored in the file is relative to the preceding frame
+            r->frame_time += delta;
+            return 1;
+        }
+        if (st < 0) {
+            errno = EBADMSG;
+            return -1;
+        }
+        // incomplete frame: read more data; a trailing partial frame is ignored
+        if (ZvbiCaptureReplay_FillBuffer(r) == 0) {
+            return -1;
+        }
+    }
+}
+
+static int
+ZvbiCaptureReplay_LoadDvb(ZvbiCaptureReplay * r)
+{
+    for (;;) {
+        if (r->feed_left > 0) {
+            int64_t pts = 0;
+            unsigned n_lines = vbi_dvb_demux_cor(r->dvb_demux, r->sliced_data, r->max_lines,
+                                                 &pts, &r->feed_ptr, &r->feed_left);
+            if (n_lines > 0) {
+                r->n_lines = n_lines;
+                r->last_pts = pts;
+                r->frame_time = pts / 90000.0;
+                return 1;
+            }
+        }
+        if (ZvbiCaptureReplay_FillBuffer(r) == 0) {
+            return -1;
+        }
+        if (r->fmt == ZVBI_REPLAY_FMT_TS) {
+            r->feed_ptr = r->pes_buf;
+            r->feed_left = ZvbiCaptureReplay_TsExtract(r);
+        }
+        else {
+            r->feed_ptr = r->io_buf;
+            r->feed_left = r->io_end;
+            r->io_start = r->io_end;
+        }
+    }
+}
+
+/*
+ * Make the next frame available, if not done yet, and wait until it is due
+ * for delivery when replaying in real-time. Returns 1 if the frame is due,
+ * 0 upon timeout, or -1 upon error or end of file (errno is set).
+ */
+static int
+ZvbiCaptureReplay_Next(ZvbiCaptureReplay * r, const struct timeval * timeout)
+{
+    if (!r->frame_valid) {
+        int st;
+
+        if (r->eof) {
+            errno = ENODATA;
+            return -1;
+        }
+        switch (r->fmt) {
+            case ZVBI_REPLAY_FMT_RAW:
+                st = ZvbiCaptureReplay_LoadRaw(r);
+                break;
+            case ZVBI_REPLAY_FMT_SLICED:
+                st = ZvbiCaptureReplay_LoadSliced(r);
+                break;
+            default:
+                st = ZvbiCaptureReplay_LoadDvb(r);
+                break;
+        }
+        if (st < 0) {
+            return -1;
+        }
+        r->frame_valid = TRUE;
+        r->frame_cnt += 1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (!r->started) {
+        struct timeval tv_wall;
+        gettimeofday(&tv_wall, NULL);
+
+        r->started = TRUE;
+        r->start_mono = now;
+        r->start_wall = tv_wall.tv_sec + tv_wall.tv_usec / 1E6;
+        r->first_frame_time = r->frame_time;
+    }
+
+    if (r->realtime && (r->frame_time > r->first_frame_time)) {
+        struct timespec due = r->start_mono;
+        struct timespec limit = now;
+
+        ZvbiCaptureReplay_AddTime(&due, r->frame_time - r->first_frame_time);
+        ZvbiCaptureReplay_AddTime(&limit, timeout->tv_sec + timeout->tv_usec / 1E6);
+
+        if (ZvbiCaptureReplay_IsBefore(&limit, &due)) {
+            ZvbiCaptureReplay_SleepUntil(&limit);
+            return 0;
+        }
+        if (ZvbiCaptureReplay_IsBefore(&now, &due)) {
+            ZvbiCaptureReplay_SleepUntil(&due);
+        }
+    }
+    return 1;
+}
+
+/*
+ * Timestamp of the current frame: time of the recording, relative to the
+ * start of the replay.
+ */
+static double
+ZvbiCaptureReplay_Timestamp(ZvbiCaptureReplay * r)
+{
+    return r->start_wall + (r->frame_time - r->first_frame_time);
+}
+
+int
+ZvbiCaptureReplay_Read(ZvbiCaptureReplay * r, void * raw, vbi_sliced * sliced,
+                       int * p_n_lines, double * p_timestamp, const struct timeval * timeout)
+{
+    if ((raw != NULL) && (sliced == NULL) && (r->raw_data == NULL)) {
+        errno = EINVAL;  // format does not contain raw data
+        return -1;
+    }
+    int st = ZvbiCaptureReplay_Next(r, timeout);
+    if (st > 0) {
+        if ((raw != NULL) && (r->raw_data != NULL)) {
+            memcpy(raw, r->raw_data, r->raw_size);
+        }
+        if (sliced != NULL) {
+            memcpy(sliced, r->sliced_data, r->n_lines * sizeof(vbi_sliced));
+            *p_n_lines = r->n_lines;
+        }
+        *p_timestamp = ZvbiCaptureReplay_Timestamp(r);
+        r->frame_valid = FALSE;
+    }
+    return st;
+}
+
+int
+ZvbiCaptureReplay_Pull(ZvbiCaptureReplay * r, vbi_capture_buffer ** raw,
+                       vbi_capture_buffer ** sliced, const struct timeval * timeout)
+{
+    if ((raw != NULL) && (sliced == NULL) && (r->raw_data == NULL)) {
+        errno = EINVAL;  // format does not contain raw data
+        return -1;
+    }
+    int st = ZvbiCaptureReplay_Next(r, timeout);
+    if (st > 0) {
+        double timestamp = ZvbiCaptureReplay_Timestamp(r);
+
+        if (raw != NULL) {
+            if (r->raw_data != NULL) {
+                r->raw_cb.data = r->raw_data;
+                r->raw_cb.size = r->raw_size;
+                r->raw_cb.timestamp = timestamp;
+                *raw = &r->raw_cb;
+            }
+            else {
+                *raw = NULL;
+            }
+        }
+        if (sliced != NULL) {
+            r->sliced_cb.data = r->sliced_data;
+            r->sliced_cb.size = r->n_lines * sizeof(vbi_sliced);
+            r->sliced_cb.timestamp = timestamp;
+            *sliced = &r->sliced_cb;
+        }
+        r->frame_valid = FALSE;
+    }
+    return st;
+}
+
+vbi_bool
+ZvbiCaptureReplay_AtEof(ZvbiCaptureReplay * r)
+{
+    return r->eof && !r->frame_valid;
+}
+
+vbi_raw_decoder *
+ZvbiCaptureReplay_Parameters(ZvbiCaptureReplay * r)
+{
+    return &r->par;
+}
+
+/*
+ * Change the services decoded from raw data. For formats containing sliced
+ * data only, all requested services are accepted.
+ */
+unsigned
+ZvbiCaptureReplay_UpdateServices(ZvbiCaptureReplay * r, vbi_bool reset,
+                                 unsigned services, int strict)
+{
+    if (r->raw_data != NULL) {
+        if (reset) {
+            vbi_raw_decoder_reset(&r->par);
+        }
+        services = vbi_raw_decoder_add_services(&r->par, services, strict);
+    }
+    return services;
+}
+
+int
+ZvbiCaptureReplay_SetPid(ZvbiCaptureReplay * r, unsigned pid)
+{
+    if (r->fmt != ZVBI_REPLAY_FMT_TS) {
+        errno = EINVAL;
+        return -1;
+    }
+    r->ts_pid = pid;
+    return 0;
+}
+
+int64_t
+ZvbiCaptureReplay_LastPts(ZvbiCaptureReplay * r)
+{
+    return r->last_pts;
+}
+
+/*
+ * Restart pacing, so that a real-time replay continues at the current time
+ * instead of catching up with frames that were not retrieved in time.
+ */
+void
+ZvbiCaptureReplay_Flush(ZvbiCaptureReplay * r)
+{
+    r->started = FALSE;
+}
+
+void
+ZvbiCaptureReplay_Delete(ZvbiCaptureReplay * r)
+{
+    if (r != NULL) {
+        if (r->fp != NULL) {
+            fclose(r->fp);
+        }
+        if (r->dvb_demux != NULL) {
+            vbi_dvb_demux_delete(r->dvb_demux);
+        }
+        vbi_raw_decoder_destroy(&r->par);
+        PyMem_RawFree(r->io_buf);
+        PyMem_RawFree(r->pes_buf);
+        PyMem_RawFree(r->raw_data);
+        PyMem_RawFree(r->sliced_data);
+        PyMem_RawFree(r);
+    }
+}
+
+/*
+ * Open the given file for replay. Parameters describing the recorded raw
+ * data are mandatory for the raw format. Upon error an exception is raised
+ * and NULL is returned.
+ */
+ZvbiCaptureReplay *
+ZvbiCaptureReplay_New(const char * path, const char * fmt, vbi_bool realtime,
+                      const vbi_raw_decoder * p_par, unsigned * p_services,
+                      unsigned dvb_pid)
+{
+    ZvbiCaptureReplay * r = PyMem_RawCalloc(1, sizeof(ZvbiCaptureReplay));
+    if (r == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    vbi_raw_decoder_init(&r->par);
+    r->realtime = realtime;
+
+    if (strcmp(fmt, "raw") == 0) {
+        r->fmt = ZVBI_REPLAY_FMT_RAW;
+    }
+    else if (strcmp(fmt, "sliced") == 0) {
+        r->fmt = ZVBI_REPLAY_FMT_SLICED;
+    }
+    else if (strcmp(fmt, "pes") == 0) {
+        r->fmt = ZVBI_REPLAY_FMT_PES;
+    }
+    else if (strcmp(fmt, "ts") == 0) {
+        r->fmt = ZVBI_REPLAY_FMT_TS;
+    }
+    else {
+        PyErr_Format(PyExc_ValueError, "Unknown format \"%s\": expecting raw, sliced, pes or ts", fmt);
+        ZvbiCaptureReplay_Delete(r);
+        return NULL;
+    }
+
+    if (p_par != NULL) {
+        // do not overwrite "private" elements in the raw decoder context
+        r->par.scanning = p_par->scanning;
+        r->par.sampling_format = p_par->sampling_format;
+        r->par.sampling_rate = p_par->sampling_rate;
+        r->par.bytes_per_line = p_par->bytes_per_line;
+        r->par.offset = p_par->offset;
+        r->par.start[0] = p_par->start[0];
+        r->par.start[1] = p_par->start[1];
+        r->par.count[0] = p_par->count[0];
+        r->par.count[1] = p_par->count[1];
+        r->par.interlaced = p_par->interlaced;
+        r->par.synchronous = p_par->synchronous;
+    }
+    else if (r->fmt == ZVBI_REPLAY_FMT_RAW) {
+        PyErr_SetString(PyExc_TypeError, "Parameter raw_params is required for format raw");
+        ZvbiCaptureReplay_Delete(r);
+        return NULL;
+    }
+    else {
+        r->par.scanning = 625;
+        r->par.start[0] = 6;
+        r->par.start[1] = 318;
+        r->par.interlaced = FALSE;
+        r->par.synchronous = TRUE;
+    }
+    r->frame_period = (r->par.scanning == 525) ? (1001.0 / 30000.0) : (1.0 / 25.0);
+    r->max_lines = r->par.count[0] + r->par.count[1];
+
+    if (r->fmt == ZVBI_REPLAY_FMT_RAW) {
+        r->raw_size = r->max_lines * r->par.bytes_per_line;
+        if (r->raw_size == 0) {
+            PyErr_SetString(ZvbiCaptureError, "Raw parameters do not describe any line data");
+            ZvbiCaptureReplay_Delete(r);
+            return NULL;
+        }
+        *p_services = vbi_raw_decoder_add_services(&r->par, *p_services ? *p_services : ~0U, 0);
+        r->raw_data = PyMem_RawMalloc(r->raw_size);
+    }
+    else {
+        // no raw data available: indicate this via zero line length; line
+        // counts only determine the size of sliced buffers, so that these
+        // are made large enough for any frame instead of dropping lines
+        r->par.bytes_per_line = 0;
+        r->par.sampling_rate = 0;
+        r->par.count[0] = (ZVBI_SLICED_FILE_MAX_LINES + 1) / 2;
+        r->par.count[1] = ZVBI_SLICED_FILE_MAX_LINES / 2;
+        r->max_lines = ZVBI_SLICED_FILE_MAX_LINES;
+        r->io_buf = PyMem_RawMalloc(IO_BUF_SIZE);
+    }
+    r->sliced_data = PyMem_RawMalloc(((r->max_lines > 0) ? r->max_lines : 1) * sizeof(vbi_sliced));
+
+    if (((r->fmt == ZVBI_REPLAY_FMT_RAW) ? (r->raw_data == NULL) : (r->io_buf == NULL)) ||
+        (r->sliced_data == NULL))
+    {
+        PyErr_NoMemory();
+        ZvbiCaptureReplay_Delete(r);
+        return NULL;
+    }
+
+    if ((r->fmt == ZVBI_REPLAY_FMT_PES) || (r->fmt == ZVBI_REPLAY_FMT_TS)) {
+        r->ts_pid = dvb_pid;
+        r->dvb_demux = vbi_dvb_pes_demux_new(NULL, NULL);
+        if (r->fmt == ZVBI_REPLAY_FMT_TS) {
+            r->pes_buf = PyMem_RawMalloc(IO_BUF_SIZE);
+        }
+        if ((r->dvb_demux == NULL) || ((r->fmt == ZVBI_REPLAY_FMT_TS) && (r->pes_buf == NULL))) {
+            PyErr_SetString(ZvbiCaptureError, "Failed to create DVB PES de-multiplexer");
+            ZvbiCaptureReplay_Delete(r);
+            return NULL;
+        }
+    }
+
+    r->fp = fopen(path, "rb");
+    if (r->fp == NULL) {
+        PyErr_Format(ZvbiCaptureError, "Failed to open %s: %s", path, strerror(errno));
+        ZvbiCaptureReplay_Delete(r);
+        return NULL;
+    }
+    return r;
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#if !defined (_PY_ZVBI_CAPTURE_REPLAY_H)
+#define _PY_ZVBI_CAPTURE_REPLAY_H
+
+typedef struct ZvbiCaptureReplay_s ZvbiCaptureReplay;
+
+ZvbiCaptureReplay * ZvbiCaptureReplay_New(const char * path, const char * fmt, vbi_bool realtime,
+                                          const vbi_raw_decoder * p_par, unsigned * p_services,
+                                          unsigned dvb_pid);
+void ZvbiCaptureReplay_Delete(ZvbiCaptureReplay * r);
+
+int ZvbiCaptureReplay_Read(ZvbiCaptureReplay * r, void * raw, vbi_sliced * sliced,
+                           int * p_n_lines, double * p_timestamp, const struct timeval * timeout);
+int ZvbiCaptureReplay_Pull(ZvbiCaptureReplay * r, vbi_capture_buffer ** raw,
+                           vbi_capture_buffer ** sliced, const struct timeval * timeout);
+vbi_bool ZvbiCaptureReplay_AtEof(ZvbiCaptureReplay * r);
+
+vbi_raw_decoder * ZvbiCaptureReplay_Parameters(ZvbiCaptureReplay * r);
+unsigned ZvbiCaptureReplay_UpdateServices(ZvbiCaptureReplay * r, vbi_bool reset,
+                                          unsigned services, int strict);
+int ZvbiCaptureReplay_SetPid(ZvbiCaptureReplay * r, unsigned pid);
+int64_t ZvbiCaptureReplay_LastPts(ZvbiCaptureReplay * r);
+void ZvbiCaptureReplay_Flush(ZvbiCaptureReplay * r);
+
+#endif  /* _PY_ZVBI_CAPTURE_REPLAY_H */
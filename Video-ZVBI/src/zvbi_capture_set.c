@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include "Python.h"
+
+#include <time.h>
+#include <unistd.h>
+#if defined (__linux__)
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#include <libzvbi.h>
+
+#include "zvbi_capture.h"
+#include "zvbi_capture_set.h"
+
+// ---------------------------------------------------------------------------
+//  Multiplexer for capturing from multiple devices
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *      captures;       // tuple of Zvbi.Capture objects
+    unsigned        cap_cnt;
+#if defined (__linux__)
+    int             epoll_fd;
+    struct epoll_event * events;
+#else
+    struct pollfd * poll_fds;
+    unsigned        poll_start;     // rotating start index for fairness
+#endif
+    // indices of captures whose descriptor was reported readable, but which
+    // were not yet served; one device is served per call of "wait"
+    unsigned *      ready;
+    unsigned        ready_cnt;
+    unsigned        ready_idx;
+    vbi_bool        busy;
+} ZvbiCaptureSetObj;
+
+// ---------------------------------------------------------------------------
+
+static PyObject *
+ZvbiCaptureSet_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    ZvbiCaptureSetObj * self = (ZvbiCaptureSetObj *) type->tp_alloc(type, 0);
+    if (self != NULL) {
+#if defined (__linux__)
+        self->epoll_fd = -1;
+#endif
+    }
+    return (PyObject *) self;
+}
+
+static void
+ZvbiCaptureSet_Clear(ZvbiCaptureSetObj *self)
+{
+#if defined (__linux__)
+    if (self->epoll_fd != -1) {
+        close(self->epoll_fd);
+        self->epoll_fd = -1;
+    }
+    PyMem_Free(self->events);
+    self->events = NULL;
+#else
+    PyMem_Free(self->poll_fds);
+    self->poll_fds = NULL;
+#endif
+    PyMem_Free(self->ready);
+    self->ready = NULL;
+    self->ready_cnt = 0;
+    self->ready_idx = 0;
+    self->cap_cnt = 0;
+    Py_CLEAR(self->captures);
+}
+
+static void
+ZvbiCaptureSet_dealloc(ZvbiCaptureSetObj *self)
+{
+    ZvbiCaptureSet_Clear(self);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int
+ZvbiCaptureSet_init(ZvbiCaptureSetObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"captures", NULL};
+    PyObject * cap_list = NULL;
+
+    if (self->busy) {
+        PyErr_SetString(ZvbiCaptureError, "CaptureSet is in use by another thread");
+        return -1;
+    }
+    // reset state in case the object is already initialized
+    ZvbiCaptureSet_Clear(self);
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &cap_list)) {
+        return -1;
+    }
+    self->captures = PySequence_Tuple(cap_list);
+    if (self->captures == NULL) {
+        return -1;
+    }
+    Py_ssize_t cap_cnt = PyTuple_GET_SIZE(self->captures);
+    if (cap_cnt == 0) {
+        PyErr_SetString(PyExc_ValueError, "List of captures is empty");
+        ZvbiCaptureSet_Clear(self);
+        return -1;
+    }
+
+    self->ready = PyMem_New(unsigned, cap_cnt);
+#if defined (__linux__)
+    self->events = PyMem_New(struct epoll_event, cap_cnt);
+    self->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if ((self->ready == NULL) || (self->events == NULL)) {
+        ZvbiCaptureSet_Clear(self);
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (self->epoll_fd == -1) {
+        PyErr_Format(ZvbiCaptureError, "Failed to create epoll instance (%s)", strerror(errno));
+        ZvbiCaptureSet_Clear(self);
+        return -1;
+    }
+#else
+    self->poll_fds = PyMem_New(struct pollfd, cap_cnt);
+    if ((self->ready == NULL) || (self->poll_fds == NULL)) {
+        ZvbiCaptureSet_Clear(self);
+        PyErr_NoMemory();
+        return -1;
+    }
+#endif
+
+    for (Py_ssize_t idx = 0; idx < cap_cnt; ++idx) {
+        PyObject * cap = PyTuple_GET_ITEM(self->captures, idx);
+        if (!PyObject_TypeCheck(cap, &ZvbiCaptureTypeDef)) {
+            PyErr_Format(PyExc_TypeError, "Expected object of type Zvbi.Capture, got %s",
+                         Py_TYPE(cap)->tp_name);
+            ZvbiCaptureSet_Clear(self);
+            return -1;
+        }
+        int fd = ZvbiCapture_GetFd(cap);
+        if (fd == -1) {
+            PyErr_Format(ZvbiCaptureError, "Capture #%d does not provide a file descriptor", (int)idx);
+            ZvbiCaptureSet_Clear(self);
+            return -1;
+        }
+#if defined (__linux__)
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u32 = idx;
+        if (epoll_ctl(self->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            PyErr_Format(ZvbiCaptureError, "Failed to add capture #%d (%s)", (int)idx, strerror(errno));
+            ZvbiCaptureSet_Clear(self);
+            return -1;
+        }
+#else
+        self->poll_fds[idx].fd = fd;
+        self->poll_fds[idx].events = POLLIN;
+        self->poll_fds[idx].revents = 0;
+#endif
+    }
+    self->cap_cnt = cap_cnt;
+    return 0;
+}
+
+/*
+ * Wait until at least one of the devices is readable, with the GIL released.
+ * Stores the indices of readable devices in the "ready" list. Returns the
+ * number of ready devices, or -1 upon error (errno is set).
+ */
+static int
+ZvbiCaptureSet_Poll(ZvbiCaptureSetObj *self, int timeout_ms)
+{
+    int cnt;
+
+#if defined (__linux__)
+    Py_BEGIN_ALLOW_THREADS
+    cnt = epoll_wait(self->epoll_fd, self->events, self->cap_cnt, timeout_ms);
+    Py_END_ALLOW_THREADS
+
+    for (int idx = 0; idx < cnt; ++idx) {
+        self->ready[idx] = self->events[idx].data.u32;
+    }
+#else
+    Py_BEGIN_ALLOW_THREADS
+    cnt = poll(self->poll_fds, self->cap_cnt, timeout_ms);
+    Py_END_ALLOW_THREADS
+
+    if (cnt > 0) {
+        // rotate start of the scan, so that all devices are served equally
+        cnt = 0;
+        for (unsigned off = 0; off < self->cap_cnt; ++off) {
+            unsigned idx = (self->poll_start + off) % self->cap_cnt;
+            if (self->poll_fds[idx].revents != 0) {
+                self->ready[cnt++] = idx;
+            }
+        }
+        self->poll_start = (self->poll_start + 1) % self->cap_cnt;
+    }
+#endif
+    if (cnt >= 0) {
+        self->ready_cnt = cnt;
+        self->ready_idx = 0;
+    }
+    return cnt;
+}
+
+static PyObject *
+ZvbiCaptureSet_wait(ZvbiCaptureSetObj *self, PyObject *args)
+{
+    int timeout_ms = 0;
+    PyObject * RETVAL = NULL;
+    struct timespec deadline;
+    vbi_bool expired = FALSE;
+
+    if (!PyArg_ParseTuple(args, "i", &timeout_ms)) {
+        return NULL;
+    }
+    if (self->captures == NULL) {
+        PyErr_SetString(ZvbiCaptureError, "CaptureSet is not initialized");
+        return NULL;
+    }
+    if (self->busy) {
+        PyErr_SetString(ZvbiCaptureError, "CaptureSet is in use by another thread");
+        return NULL;
+    }
+    self->busy = TRUE;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    for (;;) {
+        // serve devices remaining from the previous poll first
+        while ((RETVAL == NULL) && (self->ready_idx < self->ready_cnt)) {
+            unsigned idx = self->ready[self->ready_idx++];
+            PyObject * cap = PyTuple_GET_ITEM(self->captures, idx);
+            PyObject * frame = ZvbiCapture_PullNoWait(cap);
+            if (frame == NULL) {
+                break;
+            }
+            if (frame != Py_None) {
+                RETVAL = Py_BuildValue("(OOO)", cap, PyTuple_GET_ITEM(frame, 0),
+                                                     PyTuple_GET_ITEM(frame, 1));
+            }
+            Py_DECREF(frame);
+        }
+        if ((RETVAL != NULL) || (PyErr_Occurred() != NULL)) {
+            break;
+        }
+        // the deadline is checked regardless of the poll result, as devices
+        // may be reported readable without delivering a frame
+        if (expired) {
+            PyErr_SetNone(ZvbiCaptureTimeout);
+            break;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long remaining = (deadline.tv_sec - now.tv_sec) * 1000L +
+                         (deadline.tv_nsec - now.tv_nsec) / 1000000L;
+        if (remaining <= 0) {
+            remaining = 0;
+            expired = TRUE;
+        }
+
+        int cnt = ZvbiCaptureSet_Poll(self, remaining);
+        if (cnt < 0) {
+            if (errno == EINTR) {
+                if (PyErr_CheckSignals() != 0) {
+                    break;
+                }
+            }
+            else {
+                PyErr_Format(ZvbiCaptureError, "wait error (%s)", strerror(errno));
+                break;
+            }
+        }
+    }
+    self->busy = FALSE;
+    return RETVAL;
+}
+
+/*
+ * Implementation of the len() operator
+ */
+static Py_ssize_t
+ZvbiCaptureSet_SequenceLength(ZvbiCaptureSetObj * self)
+{
+    return self->cap_cnt;
+}
+
+// ---------------------------------------------------------------------------
+
+static PyMethodDef ZvbiCaptureSet_MethodsDef[] =
+{
+    {"wait", (PyCFunction) ZvbiCaptureSet_wait, METH_VARARGS, NULL },
+
+    {NULL}  /* Sentinel */
+};
+
+static PySequenceMethods ZvbiCaptureSetSequenceDef =
+{
+    .sq_length = (lenfunc) ZvbiCaptureSet_SequenceLength,
+};
+
+PyTypeObject ZvbiCaptureSetTypeDef =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "Zvbi.CaptureSet",
+    .tp_doc = PyDoc_STR("Class for capturing from multiple devices in parallel"),
+    .tp_basicsize = sizeof(ZvbiCaptureSetObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = ZvbiCaptureSet_new,
+    .tp_init = (initproc) ZvbiCaptureSet_init,
+    .tp_dealloc = (destructor) ZvbiCaptureSet_dealloc,
+    .tp_methods = ZvbiCaptureSet_MethodsDef,
+    .tp_as_sequence = &ZvbiCaptureSetSequenceDef,
+};
+
+int PyInit_CaptureSet(PyObject * module, PyObject * error_base)
+{
+    if (PyType_Ready(&ZvbiCaptureSetTypeDef) < 0) {
+        return -1;
+    }
+
+    // create class type object
+    Py_INCREF(&ZvbiCaptureSetTypeDef);
+    if (PyModule_AddObject(module, "CaptureSet", (PyObject *) &ZvbiCaptureSetTypeDef) < 0) {
+        Py_DECREF(&ZvbiCaptureSetTypeDef);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,701 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include "Python.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include <libzvbi.h>
+
+#include "zvbi_capture.h"
+#include "zvbi_capture_buf.h"
+#include "zvbi_capture_thread.h"
+
+// ---------------------------------------------------------------------------
+//  Background capture thread
+// ---------------------------------------------------------------------------
+
+// Interval for polling the stop flag while waiting for the device or queue
+#define POLL_INTERVAL_MS 100
+
+// Default for the maximum number of sliced lines per frame (e.g. for DVB)
+#define SLICED_LINE_CNT 64
+
+typedef enum {
+    ZVBI_CAPTURE_THREAD_DROP_OLDEST,
+    ZVBI_CAPTURE_THREAD_DROP_NEWEST,
+    ZVBI_CAPTURE_THREAD_BLOCK,
+} ZvbiCaptureThreadPolicy;
+
+typedef struct {
+    double          timestamp;
+    unsigned        n_lines;
+    unsigned        raw_size;       // zero if the device did not deliver raw data
+    vbi_sliced *    p_sliced;
+    uint8_t *       p_raw;
+} ZvbiCaptureThreadSlot;
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *              capture;
+    PyThread_type_lock      cap_lock;
+
+    ZvbiCaptureThreadPolicy policy;
+    vbi_bool                with_raw;
+    unsigned                max_lines;
+    unsigned                max_raw_size;
+
+    // single-producer single-consumer queue: "head" is advanced only by the
+    // capture thread; "tail" by the consumer, or by the capture thread when
+    // dropping the oldest frame; both are free-running counters, so the slot
+    // count is a power of two for keeping indices continuous across wrap-around
+    unsigned                slot_cnt;
+    ZvbiCaptureThreadSlot * slots;
+    void *                  slot_data;
+    atomic_uint             head;
+    atomic_uint             tail;
+
+    atomic_ulong            frame_cnt;
+    atomic_ulong            drop_cnt;
+    int                     error_no;
+    vbi_bool                at_eof;     // end of file reached when replaying
+
+    // mutex & condition are used only for sleeping while the queue is empty
+    // (consumer) or full (producer in "block" mode); not for queue access
+    pthread_t               thread;
+    pthread_mutex_t         wake_mutex;
+    pthread_cond_t          wake_cond;
+    vbi_bool                sync_init;
+    vbi_bool                thread_started;
+    atomic_bool             running;
+    atomic_bool             stop;
+} ZvbiCaptureThreadObj;
+
+// ---------------------------------------------------------------------------
+
+static void
+ZvbiCaptureThread_AbsTime(struct timespec * ts, long delay_ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += delay_ms / 1000;
+    ts->tv_nsec += (delay_ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec += 1;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void
+ZvbiCaptureThread_Wake(ZvbiCaptureThreadObj * self)
+{
+    pthread_mutex_lock(&self->wake_mutex);
+    pthread_cond_broadcast(&self->wake_cond);
+    pthread_mutex_unlock(&self->wake_mutex);
+}
+
+/*
+ * Copy a captured frame into the next free queue slot. When the queue is
+ * full, the frame is discarded or the oldest queued frame is replaced,
+ * depending on the configured policy. Returns TRUE if the slot shall be
+ * published to the consumer.
+ */
+static vbi_bool
+ZvbiCaptureThread_Store(ZvbiCaptureThreadObj * self,
+                        vbi_capture_buffer * raw_buffer,
+                        vbi_capture_buffer * sliced_buffer)
+{
+    unsigned head = atomic_load(&self->head);
+    unsigned tail = atomic_load(&self->tail);
+
+    if (head - tail >= self->slot_cnt) {
+        if (self->policy != ZVBI_CAPTURE_THREAD_DROP_OLDEST) {
+            atomic_fetch_add(&self->drop_cnt, 1);
+            return FALSE;
+        }
+        // Remove the oldest frame. If this fails, the consumer has taken the
+        // frame meanwhile; either way the slot is free afterward. Note the
+        // consumer detects when the slot it was copying is overwritten, as
+        // then its own update of the tail fails.
+        if (atomic_compare_exchange_strong(&self->tail, &tail, tail + 1)) {
+            atomic_fetch_add(&self->drop_cnt, 1);
+        }
+    }
+
+    ZvbiCaptureThreadSlot * slot = &self->slots[head & (self->slot_cnt - 1)];
+    unsigned n_lines = 0;
+
+    if ((sliced_buffer != NULL) && (sliced_buffer->data != NULL)) {
+        n_lines = sliced_buffer->size / sizeof(vbi_sliced);
+        if (n_lines > self->max_lines) {
+            n_lines = self->max_lines;
+        }
+        memcpy(slot->p_sliced, sliced_buffer->data, n_lines * sizeof(vbi_sliced));
+        slot->timestamp = sliced_buffer->timestamp;
+    }
+    slot->n_lines = n_lines;
+
+    if ((raw_buffer != NULL) && (raw_buffer->data != NULL) && (self->max_raw_size != 0)) {
+        unsigned raw_size = raw_buffer->size;
+        if (raw_size > self->max_raw_size) {
+            raw_size = self->max_raw_size;
+        }
+        memcpy(slot->p_raw, raw_buffer->data, raw_size);
+        slot->raw_size = raw_size;
+        slot->timestamp = raw_buffer->timestamp;
+    }
+    else {
+        slot->raw_size = 0;
+    }
+    return TRUE;
+}
+
+/*
+ * Main function of the capture thread. Note this function must not use any
+ * Python interfaces, as it runs without holding the GIL.
+ */
+static void *
+ZvbiCaptureThread_Main(void * arg)
+{
+    ZvbiCaptureThreadObj * self = arg;
+
+    while (!atomic_load(&self->stop)) {
+        if (self->policy == ZVBI_CAPTURE_THREAD_BLOCK) {
+            // wait for a free slot before capturing, so that frames queue up in the driver meanwhile
+            pthread_mutex_lock(&self->wake_mutex);
+            while ((atomic_load(&self->head) - atomic_load(&self->tail) >= self->slot_cnt) &&
+                   !atomic_load(&self->stop))
+            {
+                struct timespec abs_time;
+                ZvbiCaptureThread_AbsTime(&abs_time, POLL_INTERVAL_MS);
+                pthread_cond_timedwait(&self->wake_cond, &self->wake_mutex, &abs_time);
+            }
+            pthread_mutex_unlock(&self->wake_mutex);
+
+            if (atomic_load(&self->stop)) {
+                break;
+            }
+        }
+
+        vbi_capture_buffer * raw_buffer = NULL;
+        vbi_capture_buffer * sliced_buffer = NULL;
+        vbi_bool stored = FALSE;
+        struct timeval tv;
+        tv.tv_sec  = 0;
+        tv.tv_usec = POLL_INTERVAL_MS * 1000;
+
+        int st;
+        PyThread_acquire_lock(self->cap_lock, WAIT_LOCK);
+        st = ZvbiCapture_Pull(self->capture, (self->with_raw ? &raw_buffer : NULL), &sliced_buffer, &tv);
+        if (st > 0) {
+            ZvbiCapture_CountFrame(self->capture, st, sliced_buffer->timestamp);
+            stored = ZvbiCaptureThread_Store(self, raw_buffer, sliced_buffer);
+        }
+        else if (st < 0) {
+            if (ZvbiCapture_AtEof(self->capture)) {
+                self->at_eof = TRUE;
+            }
+            else {
+                self->error_no = errno;
+                ZvbiCapture_CountFrame(self->capture, st, 0.0);
+            }
+        }
+        PyThread_release_lock(self->cap_lock);
+
+        if (st > 0) {
+            atomic_fetch_add(&self->frame_cnt, 1);
+            if (stored) {
+                // publish the slot to the consumer
+                pthread_mutex_lock(&self->wake_mutex);
+                atomic_fetch_add(&self->head, 1);
+                pthread_cond_broadcast(&self->wake_cond);
+                pthread_mutex_unlock(&self->wake_mutex);
+            }
+        }
+        else if (st < 0) {
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&self->wake_mutex);
+    atomic_store(&self->running, FALSE);
+    pthread_cond_broadcast(&self->wake_cond);
+    pthread_mutex_unlock(&self->wake_mutex);
+
+    return NULL;
+}
+
+/*
+ * Stop the capture thread and wait for its termination. Frames remaining in
+ * the queue can still be retrieved afterward.
+ */
+static void
+ZvbiCaptureThread_Join(ZvbiCaptureThreadObj * self)
+{
+    if (self->thread_started) {
+        self->thread_started = FALSE;
+
+        atomic_store(&self->stop, TRUE);
+        ZvbiCaptureThread_Wake(self);
+
+        Py_BEGIN_ALLOW_THREADS
+        pthread_join(self->thread, NULL);
+        Py_END_ALLOW_THREADS
+
+        ZvbiCapture_SetBackground(self->capture, FALSE);
+    }
+}
+
+/*
+ * Remove the oldest frame from the queue and return it in form of capture
+ * buffer objects. Returns 0 if the queue is empty, or -1 upon error.
+ */
+static int
+ZvbiCaptureThread_Fetch(ZvbiCaptureThreadObj * self, PyObject ** p_result)
+{
+    for (;;) {
+        unsigned tail = atomic_load(&self->tail);
+        unsigned head = atomic_load(&self->head);
+
+        if (tail == head) {
+            return 0;
+        }
+        ZvbiCaptureThreadSlot * slot = &self->slots[tail & (self->slot_cnt - 1)];
+
+        // note values are limited, as the slot may be overwritten concurrently
+        unsigned n_lines = slot->n_lines;
+        unsigned raw_size = slot->raw_size;
+        double timestamp = slot->timestamp;
+        if (n_lines > self->max_lines) {
+            n_lines = self->max_lines;
+        }
+        if (raw_size > self->max_raw_size) {
+            raw_size = self->max_raw_size;
+        }
+
+        vbi_sliced * p_sliced = ZvbiCaptureSlicedBuf_AllocLines(n_lines);
+        uint8_t * p_raw = (raw_size != 0) ? PyMem_RawMalloc(raw_size) : NULL;
+        if ((p_sliced == NULL) || ((raw_size != 0) && (p_raw == NULL))) {
+            ZvbiCaptureSlicedBuf_FreeLines(p_sliced);
+            PyMem_RawFree(p_raw);
+            PyErr_NoMemory();
+            return -1;
+        }
+        memcpy(p_sliced, slot->p_sliced, n_lines * sizeof(vbi_sliced));
+        if (raw_size != 0) {
+            memcpy(p_raw, slot->p_raw, raw_size);
+        }
+
+        if (atomic_compare_exchange_strong(&self->tail, &tail, tail + 1)) {
+            if (self->policy == ZVBI_CAPTURE_THREAD_BLOCK) {
+                ZvbiCaptureThread_Wake(self);
+            }
+            ZvbiCapture_CountDelivery(self->capture, timestamp);
+            PyObject * sliced_obj = ZvbiCaptureSlicedBuf_FromData(p_sliced, n_lines, timestamp);
+            if (sliced_obj == NULL) {
+                ZvbiCaptureSlicedBuf_FreeLines(p_sliced);
+                PyMem_RawFree(p_raw);
+                return -1;
+            }
+            if (self->with_raw) {
+                PyObject * raw_obj;
+                if (p_raw != NULL) {
+                    raw_obj = ZvbiCaptureRawBuf_FromData((char*)p_raw, raw_size, timestamp,
+                                                         ZvbiCapture_GetParameters(self->capture));
+                    if (raw_obj == NULL) {
+                        PyMem_RawFree(p_raw);
+                        Py_DECREF(sliced_obj);
+                        return -1;
+                    }
+                }
+                else {  // DVB devices may not return raw data
+                    raw_obj = Py_None;
+                    Py_INCREF(Py_None);
+                }
+                *p_result = Py_BuildValue("(NN)", raw_obj, sliced_obj);
+                return (*p_result != NULL) ? 1 : -1;
+            }
+            *p_result = sliced_obj;
+            return 1;
+        }
+        // slot was replaced by the capture thread while copying: retry with the next one
+        ZvbiCaptureSlicedBuf_FreeLines(p_sliced);
+        PyMem_RawFree(p_raw);
+    }
+}
+
+/*
+ * Wait until a frame is available in the queue, the thread terminated, or
+ * the given timeout (unless negative) has elapsed.
+ */
+static PyObject *
+ZvbiCaptureThread_Wait(ZvbiCaptureThreadObj * self, long timeout_ms, vbi_bool iterate)
+{
+    PyObject * RETVAL = NULL;
+    struct timespec deadline;
+
+    if (self->slots == NULL) {
+        PyErr_SetString(ZvbiCaptureError, "CaptureThread is not initialized");
+        return NULL;
+    }
+    if (timeout_ms >= 0) {
+        ZvbiCaptureThread_AbsTime(&deadline, timeout_ms);
+    }
+
+    for (;;) {
+        int st = ZvbiCaptureThread_Fetch(self, &RETVAL);
+        if (st != 0) {
+            break;
+        }
+        if (!atomic_load(&self->running)) {
+            if (self->error_no != 0) {
+                PyErr_Format(ZvbiCaptureError, "capture error (%s)", strerror(self->error_no));
+            }
+            else if (iterate) {
+                PyErr_SetNone(PyExc_StopIteration);
+            }
+            else if (self->at_eof) {
+                PyErr_SetString(PyExc_EOFError, "end of replay file");
+            }
+            else {
+                PyErr_SetString(ZvbiCaptureError, "CaptureThread is stopped");
+            }
+            break;
+        }
+
+        struct timespec abs_time;
+        ZvbiCaptureThread_AbsTime(&abs_time, POLL_INTERVAL_MS);
+        if (timeout_ms >= 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if ((now.tv_sec > deadline.tv_sec) ||
+                ((now.tv_sec == deadline.tv_sec) && (now.tv_nsec >= deadline.tv_nsec)))
+            {
+                PyErr_SetNone(ZvbiCaptureTimeout);
+                break;
+            }
+            if ((deadline.tv_sec < abs_time.tv_sec) ||
+                ((deadline.tv_sec == abs_time.tv_sec) && (deadline.tv_nsec < abs_time.tv_nsec)))
+            {
+                abs_time = deadline;
+            }
+        }
+
+        // wait with the GIL released; wake up periodically for handling signals
+        Py_BEGIN_ALLOW_THREADS
+        pthread_mutex_lock(&self->wake_mutex);
+        if ((atomic_load(&self->head) == atomic_load(&self->tail)) && atomic_load(&self->running)) {
+            pthread_cond_timedwait(&self->wake_cond, &self->wake_mutex, &abs_time);
+        }
+        pthread_mutex_unlock(&self->wake_mutex);
+        Py_END_ALLOW_THREADS
+
+        if (PyErr_CheckSignals() != 0) {
+            break;
+        }
+    }
+    return RETVAL;
+}
+
+// ---------------------------------------------------------------------------
+
+static PyObject *
+ZvbiCaptureThread_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    return type->tp_alloc(type, 0);
+}
+
+static void
+ZvbiCaptureThread_dealloc(ZvbiCaptureThreadObj *self)
+{
+    ZvbiCaptureThread_Join(self);
+
+    if (self->sync_init) {
+        pthread_cond_destroy(&self->wake_cond);
+        pthread_mutex_destroy(&self->wake_mutex);
+    }
+    if (self->slots != NULL) {
+        PyMem_RawFree(self->slots);
+    }
+    if (self->slot_data != NULL) {
+        PyMem_RawFree(self->slot_data);
+    }
+    if (self->capture != NULL) {
+        Py_DECREF(self->capture);
+    }
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int
+ZvbiCaptureThread_init(ZvbiCaptureThreadObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"capture", "slots", "policy", "raw", NULL};
+    PyObject * capture = NULL;
+    unsigned slot_cnt = 50;
+    char * policy_str = NULL;
+    int with_raw = FALSE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|$Isp", kwlist,
+                                     &ZvbiCaptureTypeDef, &capture,
+                                     &slot_cnt, &policy_str, &with_raw))
+    {
+        return -1;
+    }
+    if (self->capture != NULL) {
+        PyErr_SetString(ZvbiCaptureError, "CaptureThread is already initialized");
+        return -1;
+    }
+    if ((slot_cnt == 0) || (slot_cnt > 0x10000)) {
+        PyErr_Format(PyExc_ValueError, "Invalid number of slots: %u", slot_cnt);
+        return -1;
+    }
+    // round up to a power of two, as required for indexing via counters
+    while ((slot_cnt & (slot_cnt - 1)) != 0) {
+        slot_cnt = (slot_cnt | (slot_cnt - 1)) + 1;
+    }
+    if ((policy_str == NULL) || (strcmp(policy_str, "drop_oldest") == 0)) {
+        self->policy = ZVBI_CAPTURE_THREAD_DROP_OLDEST;
+    }
+    else if (strcmp(policy_str, "drop_newest") == 0) {
+        self->policy = ZVBI_CAPTURE_THREAD_DROP_NEWEST;
+    }
+    else if (strcmp(policy_str, "block") == 0) {
+        self->policy = ZVBI_CAPTURE_THREAD_BLOCK;
+    }
+    else {
+        PyErr_Format(PyExc_ValueError, "Unknown policy \"%s\": expecting drop_oldest, drop_newest or block",
+                     policy_str);
+        return -1;
+    }
+
+    // determine buffer sizes from the capture parameters
+    PyThread_type_lock cap_lock = ZvbiCapture_GetLock(capture);
+    unsigned line_count = 0;
+    unsigned raw_size = 0;
+
+    if (PyThread_acquire_lock(cap_lock, NOWAIT_LOCK) == 0) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(cap_lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+    vbi_raw_decoder * p_par = ZvbiCapture_GetParameters(capture);
+    if (p_par != NULL) {
+        line_count = p_par->count[0] + p_par->count[1];
+        raw_size = line_count * p_par->bytes_per_line;
+    }
+    PyThread_release_lock(cap_lock);
+
+    if (p_par == NULL) {
+        PyErr_SetString(ZvbiCaptureError, "internal error: failed to query decoder parameters");
+        return -1;
+    }
+    self->max_lines = (line_count > SLICED_LINE_CNT) ? line_count : SLICED_LINE_CNT;
+    self->max_raw_size = with_raw ? raw_size : 0;
+    self->with_raw = with_raw;
+
+    // allocate all queue memory up-front, so that the thread never needs to allocate
+    size_t slot_size = self->max_lines * sizeof(vbi_sliced) + self->max_raw_size;
+    self->slots = PyMem_RawCalloc(slot_cnt, sizeof(ZvbiCaptureThreadSlot));
+    self->slot_data = PyMem_RawMalloc(slot_cnt * slot_size);
+    if ((self->slots == NULL) || (self->slot_data == NULL)) {
+        PyMem_RawFree(self->slots);
+        PyMem_RawFree(self->slot_data);
+        self->slots = NULL;
+        self->slot_data = NULL;
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (unsigned idx = 0; idx < slot_cnt; ++idx) {
+        uint8_t * p = (uint8_t*)self->slot_data + idx * slot_size;
+        self->slots[idx].p_sliced = (vbi_sliced*) p;
+        self->slots[idx].p_raw = p + self->max_lines * sizeof(vbi_sliced);
+    }
+    self->slot_cnt = slot_cnt;
+    atomic_store(&self->head, 0);
+    atomic_store(&self->tail, 0);
+
+    if (!self->sync_init) {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&self->wake_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        pthread_mutex_init(&self->wake_mutex, NULL);
+        self->sync_init = TRUE;
+    }
+
+    if (ZvbiCapture_SetBackground(capture, TRUE) != 0) {
+        PyMem_RawFree(self->slots);
+        PyMem_RawFree(self->slot_data);
+        self->slots = NULL;
+        self->slot_data = NULL;
+        return -1;
+    }
+    self->capture = capture;
+    Py_INCREF(capture);
+    self->cap_lock = cap_lock;
+    self->error_no = 0;
+    self->at_eof = FALSE;
+
+    atomic_store(&self->stop, FALSE);
+    atomic_store(&self->running, TRUE);
+    int st = pthread_create(&self->thread, NULL, ZvbiCaptureThread_Main, self);
+    if (st != 0) {
+        atomic_store(&self->running, FALSE);
+        ZvbiCapture_SetBackground(capture, FALSE);
+        PyErr_Format(ZvbiCaptureError, "Failed to start capture thread (%s)", strerror(st));
+        return -1;
+    }
+    self->thread_started = TRUE;
+    return 0;
+}
+
+static PyObject *
+ZvbiCaptureThread_get(ZvbiCaptureThreadObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"timeout_ms", NULL};
+    PyObject * timeout_obj = Py_None;
+    long timeout_ms = -1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwlist, &timeout_obj)) {
+        return NULL;
+    }
+    if (timeout_obj != Py_None) {
+        timeout_ms = PyLong_AsLong(timeout_obj);
+        if ((timeout_ms == -1) && PyErr_Occurred()) {
+            return NULL;
+        }
+        if (timeout_ms < 0) {
+            PyErr_SetString(PyExc_ValueError, "Timeout value must not be negative");
+            return NULL;
+        }
+    }
+    return ZvbiCaptureThread_Wait(self, timeout_ms, FALSE);
+}
+
+static PyObject *
+ZvbiCaptureThread_stop(ZvbiCaptureThreadObj *self, PyObject *args)
+{
+    ZvbiCaptureThread_Join(self);
+    Py_RETURN_NONE;
+}
+
+/*
+ * Implementation of the standard "__iter__" function
+ */
+static PyObject *
+ZvbiCaptureThread_Iter(ZvbiCaptureThreadObj *self)
+{
+    Py_INCREF(self);  // Note corresponding DECREF is done by caller after end of iteration
+    return (PyObject*) self;
+}
+
+/*
+ * Implementation of the standard "__next__" function
+ */
+static PyObject *
+ZvbiCaptureThread_IterNext(ZvbiCaptureThreadObj *self)
+{
+    return ZvbiCaptureThread_Wait(self, -1, TRUE);
+}
+
+static PyObject *
+ZvbiCaptureThread_GetFrames(ZvbiCaptureThreadObj * self, void * closure)
+{
+    return PyLong_FromUnsignedLong(atomic_load(&self->frame_cnt));
+}
+
+static PyObject *
+ZvbiCaptureThread_GetDropped(ZvbiCaptureThreadObj * self, void * closure)
+{
+    return PyLong_FromUnsignedLong(atomic_load(&self->drop_cnt));
+}
+
+static PyObject *
+ZvbiCaptureThread_GetPending(ZvbiCaptureThreadObj * self, void * closure)
+{
+    return PyLong_FromUnsignedLong(atomic_load(&self->head) - atomic_load(&self->tail));
+}
+
+static PyObject *
+ZvbiCaptureThread_GetRunning(ZvbiCaptureThreadObj * self, void * closure)
+{
+    return PyBool_FromLong(atomic_load(&self->running));
+}
+
+// ---------------------------------------------------------------------------
+
+static PyMethodDef ZvbiCaptureThread_MethodsDef[] =
+{
+    {"get",  (PyCFunction) ZvbiCaptureThread_get,  METH_VARARGS | METH_KEYWORDS, NULL },
+    {"stop", (PyCFunction) ZvbiCaptureThread_stop, METH_NOARGS, NULL },
+
+    {NULL}  /* Sentinel */
+};
+
+static PyGetSetDef ZvbiCaptureThreadGetSetDef[] =
+{
+    { .name = "frames",
+      .get = (getter) ZvbiCaptureThread_GetFrames,
+      .doc = PyDoc_STR("Number of frames captured by the thread, including dropped frames"),
+    },
+    { .name = "dropped",
+      .get = (getter) ZvbiCaptureThread_GetDropped,
+      .doc = PyDoc_STR("Number of frames discarded because the queue was full"),
+    },
+    { .name = "pending",
+      .get = (getter) ZvbiCaptureThread_GetPending,
+      .doc = PyDoc_STR("Number of frames currently waiting in the queue"),
+    },
+    { .name = "running",
+      .get = (getter) ZvbiCaptureThread_GetRunning,
+      .doc = PyDoc_STR("True while the capture thread is running"),
+    },
+    {NULL}
+};
+
+PyTypeObject ZvbiCaptureThreadTypeDef =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "Zvbi.CaptureThread",
+    .tp_doc = PyDoc_STR("Class for capturing VBI data in a background thread"),
+    .tp_basicsize = sizeof(ZvbiCaptureThreadObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = ZvbiCaptureThread_new,
+    .tp_init = (initproc) ZvbiCaptureThread_init,
+    .tp_dealloc = (destructor) ZvbiCaptureThread_dealloc,
+    .tp_methods = ZvbiCaptureThread_MethodsDef,
+    .tp_getset = ZvbiCaptureThreadGetSetDef,
+    .tp_iter = (getiterfunc) ZvbiCaptureThread_Iter,
+    .tp_iternext = (iternextfunc) ZvbiCaptureThread_IterNext,
+};
+
+int PyInit_CaptureThread(PyObject * module, PyObject * error_base)
+{
+    if (PyType_Ready(&ZvbiCaptureThreadTypeDef) < 0) {
+        return -1;
+    }
+
+    // create class type object
+    Py_INCREF(&ZvbiCaptureThreadTypeDef);
+    if (PyModule_AddObject(module, "CaptureThread", (PyObject *) &ZvbiCaptureThreadTypeDef) < 0) {
+        Py_DECREF(&ZvbiCaptureThreadTypeDef);
+        return -1;
+    }
+
+    return 0;
+}
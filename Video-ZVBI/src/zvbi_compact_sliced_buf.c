@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include "Python.h"
+
+#include <stddef.h>
+
+#include <libzvbi.h>
+
+#include "zvbi_capture_buf.h"
+#include "zvbi_compact_sliced_buf.h"
+
+// ---------------------------------------------------------------------------
+//  Packed container for sliced data
+// ---------------------------------------------------------------------------
+
+/*
+ * The object stores the sliced lines of one frame in a variable-length
+ * array following the object header, so that only one allocation is needed.
+ * Each line is stored as follows:
+ * - service ID (4 bytes, LSB first)
+ * - line number (2 bytes, LSB first)
+ * - payload length N (1 byte)
+ * - payload data x N
+ * The payload length is derived from the service ID; data following the
+ * payload in vbi_sliced is not stored and is zero when expanding.
+ */
+typedef struct {
+    PyObject_VAR_HEAD
+    double      timestamp;
+    unsigned    n_lines;
+    Py_ssize_t  iter_off;       // byte offset of the next line during iteration
+    unsigned    iter_idx;
+    uint8_t     data[1];        // packed lines; actual size is given by ob_size
+} ZvbiCompactSlicedBufObj;
+
+#define ZVBI_COMPACT_LINE_HDR_LEN  7
+
+static const struct {
+    unsigned    id;
+    unsigned    data_len;
+} ZvbiCompactSlicedBuf_Services[] =
+{
+    { VBI_SLICED_TELETEXT_A,       37 },
+    { VBI_SLICED_TELETEXT_B_625,   42 },
+    { VBI_SLICED_TELETEXT_C_625,   33 },
+    { VBI_SLICED_TELETEXT_D_625,   34 },
+    { VBI_SLICED_VPS,              13 },
+    { VBI_SLICED_VPS_F2,           13 },
+    { VBI_SLICED_CAPTION_625,       2 },
+    { VBI_SLICED_WSS_625,           2 },
+    { VBI_SLICED_CAPTION_525,       2 },
+    { VBI_SLICED_2xCAPTION_525,     4 },
+    { VBI_SLICED_TELETEXT_B_525,   34 },
+    { VBI_SLICED_TELETEXT_C_525,   33 },
+    { VBI_SLICED_TELETEXT_BD_525,  34 },
+    { VBI_SLICED_TELETEXT_D_525,   34 },
+    { VBI_SLICED_WSS_CPR1204,       3 },
+};
+
+/*
+ * Returns the number of payload bytes to store for the given service ID.
+ * When multiple service bits are set, the maximum length is used. Data of
+ * unknown services (e.g. raw VBI lines) is stored completely.
+ */
+static unsigned
+ZvbiCompactSlicedBuf_PayloadLen(unsigned id)
+{
+    unsigned data_len = 0;
+    vbi_bool known = FALSE;
+
+    for (unsigned idx = 0; idx < sizeof(ZvbiCompactSlicedBuf_Services) / sizeof(ZvbiCompactSlicedBuf_Services[0]); ++idx) {
+        if (id & ZvbiCompactSlicedBuf_Services[idx].id) {
+            if (ZvbiCompactSlicedBuf_Services[idx].data_len > data_len) {
+                data_len = ZvbiCompactSlicedBuf_Services[idx].data_len;
+            }
+            known = TRUE;
+        }
+    }
+    return known ? data_len : sizeof(((vbi_sliced*)NULL)->data);
+}
+
+/*
+ * Unpack the line starting at the given offset. Returns the offset of the
+ * following line.
+ */
+static Py_ssize_t
+ZvbiCompactSlicedBuf_UnpackLine(const ZvbiCompactSlicedBufObj * self, Py_ssize_t off,
+                                vbi_sliced * p_sliced)
+{
+    const uint8_t * p = self->data + off;
+    unsigned data_len = p[6];
+
+    p_sliced->id = p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24);
+    p_sliced->line = p[4] | (p[5] << 8);
+    memcpy(p_sliced->data, p + ZVBI_COMPACT_LINE_HDR_LEN, data_len);
+    memset(p_sliced->data + data_len, 0, sizeof(p_sliced->data) - data_len);
+
+    return off + ZVBI_COMPACT_LINE_HDR_LEN + data_len;
+}
+
+/*
+ * Create a new packed buffer from the given array of sliced lines.
+ */
+static PyObject *
+ZvbiCompactSlicedBuf_FromSliced(PyTypeObject * type, const vbi_sliced * p_sliced,
+                                unsigned n_lines, double timestamp)
+{
+    Py_ssize_t size = 0;
+
+    for (unsigned idx = 0; idx < n_lines; ++idx) {
+        size += ZVBI_COMPACT_LINE_HDR_LEN + ZvbiCompactSlicedBuf_PayloadLen(p_sliced[idx].id);
+    }
+    ZvbiCompactSlicedBufObj * self = (ZvbiCompactSlicedBufObj *) type->tp_alloc(type, size);
+    if (self != NULL) {
+        uint8_t * p = self->data;
+
+        for (unsigned idx = 0; idx < n_lines; ++idx) {
+            unsigned id = p_sliced[idx].id;
+            unsigned data_len = ZvbiCompactSlicedBuf_PayloadLen(id);
+
+            p[0] = id & 0xFF;
+            p[1] = (id >> 8) & 0xFF;
+            p[2] = (id >> 16) & 0xFF;
+            p[3] = id >> 24;
+            p[4] = p_sliced[idx].line & 0xFF;
+            p[5] = (p_sliced[idx].line >> 8) & 0xFF;
+            p[6] = data_len;
+            memcpy(p + ZVBI_COMPACT_LINE_HDR_LEN, p_sliced[idx].data, data_len);
+            p += ZVBI_COMPACT_LINE_HDR_LEN + data_len;
+        }
+        self->n_lines = n_lines;
+        self->timestamp = timestamp;
+    }
+    return (PyObject *) self;
+}
+
+/*
+ * Create a new Zvbi.CaptureSlicedBuf containing the unpacked lines.
+ */
+static PyObject *
+ZvbiCompactSlicedBuf_Expand(ZvbiCompactSlicedBufObj * self)
+{
+    vbi_sliced * data = ZvbiCaptureSlicedBuf_AllocLines(self->n_lines);
+    if (data == NULL) {
+        return PyErr_NoMemory();
+    }
+    Py_ssize_t off = 0;
+    for (unsigned idx = 0; idx < self->n_lines; ++idx) {
+        off = ZvbiCompactSlicedBuf_UnpackLine(self, off, &data[idx]);
+    }
+    PyObject * RETVAL = ZvbiCaptureSlicedBuf_FromData(data, self->n_lines, self->timestamp);
+    if (RETVAL == NULL) {
+        ZvbiCaptureSlicedBuf_FreeLines(data);
+    }
+    return RETVAL;
+}
+
+// ---------------------------------------------------------------------------
+
+static PyObject *
+ZvbiCompactSlicedBuf_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"sliced_buf", NULL};
+    PyObject * sliced_obj = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!", kwlist,
+                                     &ZvbiCaptureSlicedBufTypeDef, &sliced_obj))
+    {
+        return NULL;
+    }
+    vbi_capture_buffer * sliced_buf = ZvbiCaptureBuf_GetBuf(sliced_obj);
+    if ((sliced_buf == NULL) || (sliced_buf->data == NULL) || PyErr_Occurred()) {
+        return NULL;
+    }
+    return ZvbiCompactSlicedBuf_FromSliced(type, sliced_buf->data,
+                                           sliced_buf->size / sizeof(vbi_sliced),
+                                           sliced_buf->timestamp);
+}
+
+static void
+ZvbiCompactSlicedBuf_dealloc(ZvbiCompactSlicedBufObj *self)
+{
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *
+ZvbiCompactSlicedBuf_expand(ZvbiCompactSlicedBufObj *self, PyObject *args)
+{
+    return ZvbiCompactSlicedBuf_Expand(self);
+}
+
+static PyObject *
+ZvbiCompactSlicedBufGetTimestamp(ZvbiCompactSlicedBufObj * self, void * closure)
+{
+    return PyFloat_FromDouble(self->timestamp);
+}
+
+/*
+ * Implementation of the standard "__iter__" function
+ */
+static PyObject *
+ZvbiCompactSlicedBuf_Iter(ZvbiCompactSlicedBufObj *self)
+{
+    Py_INCREF(self);  // Note corresponding DECREF is done by caller after end of iteration
+    self->iter_idx = 0;
+    self->iter_off = 0;
+    return (PyObject*) self;
+}
+
+/*
+ * Implementation of the standard "__next__" function
+ */
+static PyObject *
+ZvbiCompactSlicedBuf_IterNext(ZvbiCompactSlicedBufObj *self)
+{
+    PyObject * RETVAL = NULL;
+
+    if (self->iter_idx < self->n_lines) {
+        vbi_sliced sliced;
+
+        self->iter_off = ZvbiCompactSlicedBuf_UnpackLine(self, self->iter_off, &sliced);
+        self->iter_idx += 1;
+
+        RETVAL = ZvbiCaptureSlicedLine_FromSliced(&sliced);
+    }
+    else {
+        PyErr_SetNone(PyExc_StopIteration);
+    }
+    return RETVAL;
+}
+
+/*
+ * Implmentation of the len() operator
+ */
+static Py_ssize_t
+ZvbiCompactSlicedBuf_SequenceLength(ZvbiCompactSlicedBufObj * self)
+{
+    return self->n_lines;
+}
+
+/*
+ * Implementation of the "buffer protocol": export of the packed data as
+ * read-only byte array, e.g. for determining the memory consumption.
+ */
+static int
+ZvbiCompactSlicedBuf_GetBuffer(ZvbiCompactSlicedBufObj * self, Py_buffer * view, int flags)
+{
+    return PyBuffer_FillInfo(view, (PyObject*) self, self->data, Py_SIZE(self), TRUE, flags);
+}
+
+// ---------------------------------------------------------------------------
+
+/*
+ * Converter for PyArg_Parse* functions accepting sliced data either in
+ * form of Zvbi.CaptureSlicedBuf or Zvbi.CompactSlicedBuf. The latter is
+ * expanded into a temporary Zvbi.CaptureSlicedBuf. In both cases a new
+ * reference is returned, which has to be released by the caller.
+ */
+int
+ZvbiCompactSlicedBuf_Converter(PyObject * obj, void * p_result)
+{
+    PyObject ** p_obj = p_result;
+
+    if (obj == NULL) {
+        // clean-up after failure of parsing a following argument
+        Py_CLEAR(*p_obj);
+        return 0;
+    }
+    if (PyObject_TypeCheck(obj, &ZvbiCompactSlicedBufTypeDef)) {
+        *p_obj = ZvbiCompactSlicedBuf_Expand((ZvbiCompactSlicedBufObj*) obj);
+        return (*p_obj != NULL) ? Py_CLEANUP_SUPPORTED : 0;
+    }
+    if (PyObject_TypeCheck(obj, &ZvbiCaptureSlicedBufTypeDef)) {
+        Py_INCREF(obj);
+        *p_obj = obj;
+        return Py_CLEANUP_SUPPORTED;
+    }
+    PyErr_Format(PyExc_TypeError, "Expected object of type Zvbi.CaptureSlicedBuf or "
+                 "Zvbi.CompactSlicedBuf, got %s", Py_TYPE(obj)->tp_name);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+
+static PyMethodDef ZvbiCompactSlicedBuf_MethodsDef[] =
+{
+    {"expand", (PyCFunction) ZvbiCompactSlicedBuf_expand, METH_NOARGS, NULL },
+
+    {NULL}  /* Sentinel */
+};
+
+static PyGetSetDef ZvbiCompactSlicedBufGetSetDef[] =
+{
+    { .name = "timestamp",
+      .get = (getter) ZvbiCompactSlicedBufGetTimestamp,
+      .set = NULL,
+      .doc = PyDoc_STR("Timestamp indicating when the data was captured; the value is of type float, "
+                       "representing the number of seconds and fractions since 1970-01-01 00:00"),
+    },
+    {NULL}
+};
+
+static PySequenceMethods ZvbiCompactSlicedBufSequenceDef =
+{
+    .sq_length = (lenfunc) ZvbiCompactSlicedBuf_SequenceLength,
+};
+
+static PyBufferProcs ZvbiCompactSlicedBufAsBufferDef =
+{
+    .bf_getbuffer = (getbufferproc) ZvbiCompactSlicedBuf_GetBuffer,
+    .bf_releasebuffer = NULL
+};
+
+PyTypeObject ZvbiCompactSlicedBufTypeDef =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "Zvbi.CompactSlicedBuf",
+    .tp_doc = PyDoc_STR("Container for sliced data in packed form"),
+    .tp_basicsize = offsetof(ZvbiCompactSlicedBufObj, data),
+    .tp_itemsize = 1,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = ZvbiCompactSlicedBuf_new,
+    .tp_dealloc = (destructor) ZvbiCompactSlicedBuf_dealloc,
+    .tp_getset = ZvbiCompactSlicedBufGetSetDef,
+    .tp_methods = ZvbiCompactSlicedBuf_MethodsDef,
+    .tp_iter = (getiterfunc) ZvbiCompactSlicedBuf_Iter,
+    .tp_iternext = (iternextfunc) ZvbiCompactSlicedBuf_IterNext,
+    .tp_as_sequence = &ZvbiCompactSlicedBufSequenceDef,
+    .tp_as_buffer = &ZvbiCompactSlicedBufAsBufferDef,
+};
+
+int PyInit_CompactSlicedBuf(PyObject * module, PyObject * error_base)
+{
+    if (PyType_Ready(&ZvbiCompactSlicedBufTypeDef) < 0) {
+        return -1;
+    }
+
+    // create class type object
+    Py_INCREF(&ZvbiCompactSlicedBufTypeDef);
+    if (PyModule_AddObject(module, "CompactSlicedBuf", (PyObject *) &ZvbiCompactSlicedBufTypeDef) < 0) {
+        Py_DECREF(&ZvbiCompactSlicedBufTypeDef);
+        return -1;
+    }
+
+    return 0;
+}
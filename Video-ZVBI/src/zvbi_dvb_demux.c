@@ -51,16 +51,20 @@ typedef struct vbi_dvb_demux_obj_struct {
     unsigned int    feed_buf_left;
     vbi_sliced *    p_sliced_buf;
 
+    // capture buffer objects passed to the callback, see below
+    ZvbiCaptureBufList cap_bufs;
+
 } ZvbiDvbDemuxObj;
 
 static PyObject * ZvbiDvbDemuxError;
 
 /*
- * This counter is used for limiting the life-time of capture buffer objects
- * produced by the callback to the duration of the callback. Later access to
- * the buffer will result in an exception.
+ * Member "cap_bufs" tracks capture buffer objects passed to the callback,
+ * which refer to storage of the de-multiplexer that is only valid during the
+ * callback. Buffers still referenced by the application when the callback
+ * returns get a private copy of their content. The list is kept per
+ * de-multiplexer instance.
  */
-static int ZvbiDvbDemux_CaptureBufSeqNo;
 
 // ---------------------------------------------------------------------------
 
@@ -79,15 +83,12 @@ zvbi_xs_dvb_pes_handler( vbi_dvb_demux *        dx,
     vbi_bool result = FALSE; /* defaults to "failure" result */
 
     if ((self != NULL) && (self->demux_cb != NULL)) {
-        // invalidate previously returned capture buffer wrapper objects
-        ZvbiDvbDemux_CaptureBufSeqNo++;
-
         vbi_capture_buffer cap_buf;
         cap_buf.data = (void*)sliced;  /* cast removes "const" */
         cap_buf.size = sizeof(vbi_sliced) * sliced_lines;
         cap_buf.timestamp = PTS_TO_TIMESTAMP(pts);
 
-        PyObject * sliced_obj = ZvbiCaptureSlicedBuf_FromPtr(&cap_buf, &ZvbiDvbDemux_CaptureBufSeqNo);
+        PyObject * sliced_obj = ZvbiCaptureSlicedBuf_FromPtr(&cap_buf, (PyObject *) self, &self->cap_bufs);
         if (sliced_obj != NULL) {
             // invoke the Python subroutine
             PyObject * cb_rslt =
@@ -101,8 +102,8 @@ zvbi_xs_dvb_pes_handler( vbi_dvb_demux *        dx,
             Py_DECREF(sliced_obj);
         }
 
-        // invalidate page wrapper object: life-time of buffer is duration of callback only
-        ZvbiDvbDemux_CaptureBufSeqNo++;
+        // life-time of the storage is the duration of the callback only
+        ZvbiCaptureBufList_Invalidate(&self->cap_bufs);
 
         // clear exceptions as we cannot handle them here
         if (PyErr_Occurred() != NULL) {
@@ -173,7 +174,7 @@ ZvbiDvbDemux_dealloc(ZvbiDvbDemuxObj *self)
     }
 
     if (self->p_sliced_buf != NULL) {
-        PyMem_RawFree(self->p_sliced_buf);
+        ZvbiCaptureSlicedBuf_FreeLines(self->p_sliced_buf);
     }
 
     Py_TYPE(self)->tp_free((PyObject *) self);
@@ -209,7 +210,7 @@ ZvbiDvbDemux_init(ZvbiDvbDemuxObj *self, PyObject *args, PyObject *kwds)
             self->log_user_data = NULL;
         }
         if (self->p_sliced_buf != NULL) {
-            PyMem_RawFree(self->p_sliced_buf);
+            ZvbiCaptureSlicedBuf_FreeLines(self->p_sliced_buf);
             self->p_sliced_buf = NULL;
         }
         self->ctx = NULL;
@@ -331,7 +332,7 @@ ZvbiDvbDemux_IterNext(ZvbiDvbDemuxObj *self)
     if (self->feed_buf.buf != NULL) {
         if (self->feed_buf_left > 0) {
             if (self->p_sliced_buf == NULL) {
-                self->p_sliced_buf = PyMem_RawMalloc(sizeof(vbi_sliced) * self->max_sliced_lines);
+                self->p_sliced_buf = ZvbiCaptureSlicedBuf_AllocLines(self->max_sliced_lines);
             }
             int64_t pts;
             n_lines = vbi_dvb_demux_cor(self->ctx,
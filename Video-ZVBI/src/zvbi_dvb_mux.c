@@ -19,6 +19,7 @@
 
 #include "zvbi_dvb_mux.h"
 #include "zvbi_capture_buf.h"
+#include "zvbi_compact_sliced_buf.h"
 #include "zvbi_raw_params.h"
 #include "zvbi_callbacks.h"
 
@@ -224,9 +225,9 @@ ZvbiDvbMux_feed(ZvbiDvbMuxObj *self, PyObject *args, PyObject *kwds)
     PyObject * RETVAL = NULL;
 
     if ((self->mux_cb != NULL) || (self->sliced_buf_obj == NULL)) {
-        if (PyArg_ParseTupleAndKeywords(args, kwds, "|I$O!O!L", kwlist,
+        if (PyArg_ParseTupleAndKeywords(args, kwds, "|I$O&O!L", kwlist,
                                         &service_mask,
-                                        &ZvbiCaptureSlicedBufTypeDef, &sliced_obj,
+                                        ZvbiCompactSlicedBuf_Converter, &sliced_obj,
                                         &ZvbiCaptureRawBufTypeDef, &raw_obj,
                                         &pts))
         {
@@ -299,6 +300,7 @@ ZvbiDvbMux_feed(ZvbiDvbMuxObj *self, PyObject *args, PyObject *kwds)
             else {
                 PyErr_SetString(PyExc_ValueError, "Missing mandatory parameter 'sliced_buf'");
             }
+            Py_XDECREF(sliced_obj);
         }
     }
     else {
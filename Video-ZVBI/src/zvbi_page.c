@@ -28,6 +28,7 @@ typedef struct {
     PyObject_HEAD
     vbi_page *      page;
     vbi_bool        do_free_pg;
+    PyObject      * owner;      // object holding the validity counter
     const int     * p_validity_src;
     int             validity_id;
 } ZvbiPageObj;
@@ -337,14 +338,16 @@ ZvbiPage_New(vbi_page * page)
 }
 
 PyObject *
-ZvbiPage_NewTemporary(vbi_page * page, const int * validity_src)
+ZvbiPage_NewTemporary(vbi_page * page, PyObject * owner, const int * validity_src)
 {
     ZvbiPageObj * self = (ZvbiPageObj *) ZvbiPageTypeDef.tp_alloc(&ZvbiPageTypeDef, 0);
     if (self != NULL) {
         self->page = page;
         self->do_free_pg = FALSE;
+        self->owner = owner;
         self->p_validity_src = validity_src;
         self->validity_id = *validity_src;
+        Py_INCREF(owner);
     }
     return (PyObject *) self;
 }
@@ -356,6 +359,7 @@ ZvbiPage_dealloc(ZvbiPageObj *self)
         vbi_unref_page(self->page);
         PyMem_RawFree(self->page);
     }
+    Py_XDECREF(self->owner);
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
@@ -17,7 +17,7 @@
 extern PyTypeObject ZvbiPageTypeDef;
 
 PyObject * ZvbiPage_New(vbi_page * page);
-PyObject * ZvbiPage_NewTemporary(vbi_page * page, const int * validity_src);
+PyObject * ZvbiPage_NewTemporary(vbi_page * page, PyObject * owner, const int * validity_src);
 vbi_page * ZvbiPage_GetPageBuf(PyObject * obj);
 
 int PyInit_Page(PyObject * module, PyObject * error_base);
@@ -19,6 +19,7 @@
 
 #include "zvbi_proxy.h"
 #include "zvbi_callbacks.h"
+#include "zvbi_async.h"
 
 // ---------------------------------------------------------------------------
 //  VBI Proxy Client
@@ -29,20 +30,59 @@ typedef struct {
     vbi_proxy_client * ctx;
     PyObject * proxy_cb;
     PyObject * proxy_user_data;
+    PyObject * async_loop;
+    PyObject * async_queue;     // weak reference, so that the queue ends with the iterator
 } ZvbiProxyObj;
 
 static PyObject * ZvbiProxyError;
 
+// maximum number of events in the queue of aevents(); the oldest is dropped when full
+#define ZVBI_PROXY_ASYNC_QUEUE_SIZE 64
+
+// ---------------------------------------------------------------------------
+
+/*
+ * Add an event to the queue of aevents(), discarding the oldest one when
+ * the queue is full. This is called within the thread of the event loop.
+ */
+static PyObject *
+ZvbiProxy_QueuePut(PyObject * queue, PyObject * ev_mask)
+{
+    PyObject * RETVAL = NULL;
+    PyObject * full = PyObject_CallMethod(queue, "full", NULL);
+
+    if (full != NULL) {
+        int is_full = PyObject_IsTrue(full);
+        Py_DECREF(full);
+
+        if (is_full > 0) {
+            PyObject * dropped = PyObject_CallMethod(queue, "get_nowait", NULL);
+            Py_XDECREF(dropped);
+        }
+        if (PyErr_Occurred() == NULL) {
+            RETVAL = PyObject_CallMethod(queue, "put_nowait", "(O)", ev_mask);
+        }
+    }
+    return RETVAL;
+}
+
+static PyMethodDef ZvbiProxy_QueuePutDef =
+    {"_queue_put", (PyCFunction) ZvbiProxy_QueuePut, METH_O, NULL };
+
 // ---------------------------------------------------------------------------
 
 /*
  * Invoke callback for an event generated by the proxy client
+ *
+ * Note the callback may be invoked from within capture functions, which are
+ * called with the GIL released. Therefore the GIL has to be acquired here.
  */
 static void
 zvbi_xs_proxy_callback( void * user_data, VBI_PROXY_EV_TYPE ev_mask )
 {
     ZvbiProxyObj * self = user_data;
     PyObject * cb_rslt;
+    PyGILState_STATE gstate = PyGILState_Ensure();
 
     if ((self != NULL) && (self->proxy_cb != NULL)) {
         // invoke the Python subroutine
@@ -63,6 +103,30 @@ zvbi_xs_proxy_callback( void * user_data, VBI_PROXY_EV_TYPE ev_mask )
             PyErr_Print();
         }
     }
+    if ((self != NULL) && (self->async_queue != NULL)) {
+        PyObject * queue = PyWeakref_GetObject(self->async_queue);
+
+        if (queue == Py_None) {
+            // the iterator returned by aevents() was released: stop queuing
+            Py_CLEAR(self->async_queue);
+            Py_CLEAR(self->async_loop);
+        }
+        else if (queue != NULL) {
+            // forward the event to the queue of aevents(); the callback may occur
+            // in a thread other than that of the event loop
+            PyObject * put_func = PyCFunction_New(&ZvbiProxy_QueuePutDef, queue);
+            if (put_func != NULL) {
+                cb_rslt = PyObject_CallMethod(self->async_loop, "call_soon_threadsafe", "Oi",
+                                              put_func, ev_mask);
+                Py_XDECREF(cb_rslt);
+                Py_DECREF(put_func);
+            }
+        }
+        if (PyErr_Occurred() != NULL) {
+            PyErr_Print();
+        }
+    }
+    PyGILState_Release(gstate);
 }
 
 // ---------------------------------------------------------------------------
@@ -86,6 +150,8 @@ ZvbiProxy_dealloc(ZvbiProxyObj *self)
             Py_DECREF(self->proxy_user_data);
         }
     }
+    Py_XDECREF(self->async_loop);
+    Py_XDECREF(self->async_queue);
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
@@ -172,13 +238,53 @@ ZvbiProxy_set_callback(ZvbiProxyObj *self, PyObject *args)
         }
         vbi_proxy_client_set_callback(self->ctx, zvbi_xs_proxy_callback, self);
     }
-    else {
+    else if (self->async_queue == NULL) {
         // remove existing callback registration
         vbi_proxy_client_set_callback(self->ctx, NULL, NULL);
     }
     Py_RETURN_NONE;
 }
 
+/*
+ * Return an asynchronous iterator delivering event masks, as an alternative
+ * to installing a callback function. Events are queued within the event loop
+ * running in the calling thread.
+ */
+static PyObject *
+ZvbiProxy_aevents(ZvbiProxyObj *self, PyObject *args)
+{
+    PyObject * RETVAL = NULL;
+
+    PyObject * loop = ZvbiAsync_GetRunningLoop();
+    if (loop != NULL) {
+        PyObject * queue = ZvbiAsync_NewQueue(ZVBI_PROXY_ASYNC_QUEUE_SIZE);
+        if (queue != NULL) {
+            PyObject * queue_ref = PyWeakref_NewRef(queue, NULL);
+            PyObject * get_func = PyObject_GetAttrString(queue, "get");
+            if ((queue_ref != NULL) && (get_func != NULL)) {
+                RETVAL = ZvbiAsync_NewIter(get_func);
+            }
+            if (RETVAL != NULL) {
+                // replace the queue of a previous call, if any; only the
+                // iterator holds a reference to the queue
+                Py_XDECREF(self->async_loop);
+                Py_XDECREF(self->async_queue);
+                self->async_loop = loop;
+                self->async_queue = queue_ref;
+                Py_INCREF(loop);
+                Py_INCREF(queue_ref);
+
+                vbi_proxy_client_set_callback(self->ctx, zvbi_xs_proxy_callback, self);
+            }
+            Py_XDECREF(get_func);
+            Py_XDECREF(queue_ref);
+            Py_DECREF(queue);
+        }
+        Py_DECREF(loop);
+    }
+    return RETVAL;
+}
+
 
 static PyObject *
 ZvbiProxy_get_driver_api(ZvbiProxyObj *self, PyObject *args)
@@ -326,6 +432,7 @@ ZvbiProxy_GetCtx(PyObject * self)
 static PyMethodDef ZvbiProxy_MethodsDef[] =
 {
     {"set_callback",        (PyCFunction) ZvbiProxy_set_callback,        METH_VARARGS, NULL },
+    {"aevents",             (PyCFunction) ZvbiProxy_aevents,             METH_NOARGS, NULL },
     {"get_driver_api",      (PyCFunction) ZvbiProxy_get_driver_api,      METH_NOARGS, NULL },
     {"channel_request",     (PyCFunction) ZvbiProxy_channel_request,     METH_VARARGS | METH_KEYWORDS, NULL },
     {"channel_notify",      (PyCFunction) ZvbiProxy_channel_notify,      METH_VARARGS, NULL },
@@ -15,10 +15,14 @@
 #define PY_SSIZE_T_CLEAN
 #include "Python.h"
 
+#include <pthread.h>
+#include <unistd.h>
+
 #include <libzvbi.h>
 
 #include "zvbi_raw_dec.h"
 #include "zvbi_raw_params.h"
+#include "zvbi_raw_slicer.h"
 #include "zvbi_capture.h"
 #include "zvbi_capture_buf.h"
 
@@ -27,6 +31,9 @@
 typedef struct {
     PyObject_HEAD
     vbi_raw_decoder rd;
+    vbi_bool busy;          // TRUE while decoding with the GIL released
+    vbi_bool fast_slicer;   // TRUE when the built-in slicer may be used
+    ZvbiRawSlicer * slicer; // built-in slicer, if applicable to parameters and services
 } ZvbiRawDecObj;
 
 static PyObject * ZvbiRawDecError;
@@ -35,6 +42,20 @@ static PyObject * ZvbiRawDecError;
 //  VBI raw decoder
 // ---------------------------------------------------------------------------
 
+/*
+ * The decoder context is used with the GIL released by "decode_many", so
+ * other threads have to be prevented from using it meanwhile.
+ */
+static vbi_bool
+ZvbiRawDec_CheckIdle(ZvbiRawDecObj * self)
+{
+    if (self->busy) {
+        PyErr_SetString(ZvbiRawDecError, "RawDec is in use by another thread");
+        return FALSE;
+    }
+    return TRUE;
+}
+
 static PyObject *
 ZvbiRawDec_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 {
@@ -49,57 +70,105 @@ static void
 ZvbiRawDec_dealloc(ZvbiRawDecObj *self)
 {
     vbi_raw_decoder_destroy(&self->rd);
+    ZvbiRawSlicer_Free(self->slicer);
 
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
+/*
+ * Returns the raw decoder parameters of the given Zvbi.RawParams or
+ * Zvbi.Capture object. Returns NULL and raises an exception upon error.
+ */
+static vbi_raw_decoder *
+ZvbiRawDec_GetParams(PyObject * obj)
+{
+    vbi_raw_decoder * p_par = NULL;
+
+    if (PyObject_IsInstance(obj, (PyObject*)&ZvbiCaptureTypeDef) == 1) {
+        p_par = ZvbiCapture_GetParameters(obj);
+        if (p_par == NULL) {
+            PyErr_SetString(ZvbiRawDecError, "failed to get capture parameters from Capture object");
+        }
+    }
+    else if (PyObject_IsInstance(obj, (PyObject*)&ZvbiRawParamsTypeDef) == 1) {
+        p_par = ZvbiRawParamsGetStruct(obj);
+    }
+    else {
+        // use standard exception TypeError as this error does not come from ZVBI library
+        PyErr_SetString(PyExc_TypeError, "Parameter is neither of type Zvbi.RawParams nor Zvbi.Capture");
+    }
+    return p_par;
+}
+
+/*
+ * Copy individual parameters from the given container into the decoder
+ * context; do not overwrite "private" elements in the raw decoder context
+ */
+static void
+ZvbiRawDec_CopyParams(vbi_raw_decoder * rd, const vbi_raw_decoder * p_par)
+{
+    rd->scanning = p_par->scanning;
+    rd->sampling_format = p_par->sampling_format;
+    rd->sampling_rate = p_par->sampling_rate;
+    rd->bytes_per_line = p_par->bytes_per_line;
+    rd->offset = p_par->offset;
+    rd->start[0] = p_par->start[0];
+    rd->start[1] = p_par->start[1];
+    rd->count[0] = p_par->count[0];
+    rd->count[1] = p_par->count[1];
+    rd->interlaced = p_par->interlaced;
+    rd->synchronous = p_par->synchronous;
+}
+
+/*
+ * Replace the built-in slicer after a change of parameters or services. The
+ * slicer is used instead of vbi_raw_decode() only if enabled by the user and
+ * applicable to the current configuration. Returns FALSE and raises an
+ * exception upon error.
+ */
+static vbi_bool
+ZvbiRawDec_UpdateSlicer(ZvbiRawSlicer ** p_slicer, vbi_bool enabled, const vbi_raw_decoder * rd)
+{
+    ZvbiRawSlicer_Free(*p_slicer);
+    *p_slicer = NULL;
+
+    if (enabled && ZvbiRawSlicer_Supports(rd)) {
+        *p_slicer = ZvbiRawSlicer_New(rd);
+        if (*p_slicer == NULL) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static inline unsigned
+ZvbiRawDec_Slice(vbi_raw_decoder * rd, const ZvbiRawSlicer * slicer, const uint8_t * raw, vbi_sliced * out)
+{
+    if (slicer != NULL) {
+        return ZvbiRawSlicer_Decode(slicer, raw, out);
+    }
+    return vbi_raw_decode(rd, (uint8_t*)raw, out);
+}
+
 static int
 ZvbiRawDec_init(ZvbiRawDecObj *self, PyObject *args, PyObject *kwds)
 {
-    static char * kwlist[] = {"par", NULL};
+    static char * kwlist[] = {"par", "fast_slicer", NULL};
     PyObject * obj = NULL;
-    vbi_raw_decoder * p_par = NULL;
+    int fast_slicer = FALSE;
     int RETVAL = -1;
 
-    if (PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &obj)) {
-        if (PyObject_IsInstance(obj, (PyObject*)&ZvbiCaptureTypeDef) == 1) {
-            vbi_capture * p_cap = ZvbiCapture_GetCtx(obj);
-            if (p_cap != NULL) {
-                p_par = vbi_capture_parameters(p_cap);
-                if (p_par != NULL) {
-                    RETVAL = 0;
-                }
-                else {
-                    PyErr_SetString(ZvbiRawDecError, "failed to get capture parameters from Capture object");
-                }
-            }
-        }
-        else if (PyObject_IsInstance(obj, (PyObject*)&ZvbiRawParamsTypeDef) == 1) {
-            vbi_raw_decoder * p_par = ZvbiRawParamsGetStruct(obj);
-            if (p_par != NULL) {
+    if (PyArg_ParseTupleAndKeywords(args, kwds, "O|$p", kwlist, &obj, &fast_slicer) &&
+        ZvbiRawDec_CheckIdle(self))
+    {
+        vbi_raw_decoder * p_par = ZvbiRawDec_GetParams(obj);
+        if (p_par != NULL) {
+            ZvbiRawDec_CopyParams(&self->rd, p_par);
+            self->fast_slicer = fast_slicer;
+            if (ZvbiRawDec_UpdateSlicer(&self->slicer, self->fast_slicer, &self->rd)) {
                 RETVAL = 0;
             }
         }
-        else {
-            // use standard exception TypeError as this error does not come from ZVBI library
-            PyErr_SetString(PyExc_TypeError, "Parameter is neither of type Zvbi.RawParams nor Zvbi.Capture");
-        }
-
-        if (p_par != NULL) {
-            // copy individual parameters from the given container into "self"
-            // do not overwrite "private" elements in the raw decoder context
-            self->rd.scanning = p_par->scanning;
-            self->rd.sampling_format = p_par->sampling_format;
-            self->rd.sampling_rate = p_par->sampling_rate;
-            self->rd.bytes_per_line = p_par->bytes_per_line;
-            self->rd.offset = p_par->offset;
-            self->rd.start[0] = p_par->start[0];
-            self->rd.start[1] = p_par->start[1];
-            self->rd.count[0] = p_par->count[0];
-            self->rd.count[1] = p_par->count[1];
-            self->rd.interlaced = p_par->interlaced;
-            self->rd.synchronous = p_par->synchronous;
-        }
     }
     return RETVAL;
 }
@@ -133,7 +202,13 @@ ZvbiRawDec_parameters(ZvbiRawDecObj *self, PyObject *args)
 static PyObject *
 ZvbiRawDec_reset(ZvbiRawDecObj *self, PyObject *args)
 {
+    if (!ZvbiRawDec_CheckIdle(self)) {
+        return NULL;
+    }
     vbi_raw_decoder_reset(&self->rd);
+    if (!ZvbiRawDec_UpdateSlicer(&self->slicer, self->fast_slicer, &self->rd)) {
+        return NULL;
+    }
     Py_RETURN_NONE;
 }
 
@@ -143,10 +218,13 @@ ZvbiRawDec_add_services(ZvbiRawDecObj *self, PyObject *args)
     unsigned services;
     int strict = 0;
 
-    if (!PyArg_ParseTuple(args, "I|I", &services, &strict)) {
+    if (!PyArg_ParseTuple(args, "I|I", &services, &strict) || !ZvbiRawDec_CheckIdle(self)) {
         return NULL;
     }
     services = vbi_raw_decoder_add_services(&self->rd, services, strict);
+    if (!ZvbiRawDec_UpdateSlicer(&self->slicer, self->fast_slicer, &self->rd)) {
+        return NULL;
+    }
     return PyLong_FromLong(services);
 }
 
@@ -168,10 +246,13 @@ ZvbiRawDec_remove_services(ZvbiRawDecObj *self, PyObject *args)
 {
     unsigned services;
 
-    if (!PyArg_ParseTuple(args, "I", &services)) {
+    if (!PyArg_ParseTuple(args, "I", &services) || !ZvbiRawDec_CheckIdle(self)) {
         return NULL;
     }
     services = vbi_raw_decoder_remove_services(&self->rd, services);
+    if (!ZvbiRawDec_UpdateSlicer(&self->slicer, self->fast_slicer, &self->rd)) {
+        return NULL;
+    }
     return PyLong_FromLong(services);
 }
 
@@ -181,10 +262,15 @@ ZvbiRawDec_resize(ZvbiRawDecObj *self, PyObject *args)
     int start[2];
     unsigned int count[2];
 
-    if (!PyArg_ParseTuple(args, "iIiI", &start[0], &count[0], &start[1], &count[1])) {
+    if (!PyArg_ParseTuple(args, "iIiI", &start[0], &count[0], &start[1], &count[1]) ||
+        !ZvbiRawDec_CheckIdle(self))
+    {
         return NULL;
     }
     vbi_raw_decoder_resize(&self->rd, start, count);
+    if (!ZvbiRawDec_UpdateSlicer(&self->slicer, self->fast_slicer, &self->rd)) {
+        return NULL;
+    }
     Py_RETURN_NONE;
 }
 
@@ -195,13 +281,15 @@ ZvbiRawDec_decode(ZvbiRawDecObj *self, PyObject *args)
     double timestamp = 0.0;
     PyObject * RETVAL = NULL;
 
+    if (!ZvbiRawDec_CheckIdle(self)) {
+        return NULL;
+    }
     if (PyArg_ParseTuple(args, "y*|d", &in_buf, &timestamp)) {
         size_t raw_size = (self->rd.count[0] + self->rd.count[1]) * self->rd.bytes_per_line;
         if (in_buf.len >= raw_size) {
-            size_t size_sliced = (self->rd.count[0] + self->rd.count[1]) * sizeof(vbi_sliced);
-            vbi_sliced * p_sliced = (vbi_sliced*) PyMem_Malloc(size_sliced);
+            vbi_sliced * p_sliced = ZvbiCaptureSlicedBuf_AllocLines(self->rd.count[0] + self->rd.count[1]);
             if (p_sliced != NULL) {
-                int nof_lines = vbi_raw_decode(&self->rd, in_buf.buf, p_sliced);
+                int nof_lines = ZvbiRawDec_Slice(&self->rd, self->slicer, in_buf.buf, p_sliced);
 
                 RETVAL = ZvbiCaptureSlicedBuf_FromData(p_sliced, nof_lines, timestamp);
             }
@@ -217,6 +305,631 @@ ZvbiRawDec_decode(ZvbiRawDecObj *self, PyObject *args)
     return RETVAL;
 }
 
+static PyObject *
+ZvbiRawDecGetSlicer(ZvbiRawDecObj * self, void * closure)
+{
+    return PyUnicode_FromString((self->slicer != NULL) ? ZvbiRawSlicer_Name(self->slicer) : "libzvbi");
+}
+
+/*
+ * Batch of raw frames for "decode_many"; references to the input buffers are
+ * held until decoding is done.
+ */
+typedef struct {
+    PyObject *          seq;            // sequence of frame buffers, or NULL
+    Py_buffer *         in_bufs;        // one per frame, or a single contiguous buffer
+    Py_ssize_t          in_buf_cnt;     // number of acquired buffers
+    Py_ssize_t          frame_cnt;
+    const uint8_t **    frames;
+    double *            timestamps;
+    unsigned *          line_cnt;       // number of sliced lines per frame
+} ZvbiRawDecBatch;
+
+// Function slicing all frames of a batch into consecutive lines of the given array
+typedef unsigned ZvbiRawDecBatchFunc(PyObject * self, ZvbiRawDecBatch * batch, vbi_sliced * p_sliced);
+
+static void
+ZvbiRawDec_FreeBatch(ZvbiRawDecBatch * batch)
+{
+    for (Py_ssize_t idx = 0; idx < batch->in_buf_cnt; ++idx) {
+        PyBuffer_Release(&batch->in_bufs[idx]);
+    }
+    PyMem_Free(batch->in_bufs);
+    PyMem_Free(batch->frames);
+    PyMem_Free(batch->timestamps);
+    PyMem_Free(batch->line_cnt);
+    Py_XDECREF(batch->seq);
+}
+
+/*
+ * Collect pointers to the raw frames given either as one contiguous buffer
+ * holding consecutive frames, or as a sequence of buffers holding one frame
+ * each. Frames not originating from Zvbi.CaptureRawBuf get timestamps
+ * advancing from the given one by the nominal frame period. Returns FALSE
+ * and raises an exception upon error.
+ */
+static vbi_bool
+ZvbiRawDec_GetBatch(const vbi_raw_decoder * rd, PyObject * frames_obj, double timestamp,
+                    ZvbiRawDecBatch * batch)
+{
+    size_t raw_size = (rd->count[0] + rd->count[1]) * rd->bytes_per_line;
+    double frame_period = (rd->scanning == 525) ? (1001.0 / 30000.0) : (1.0 / 25.0);
+
+    memset(batch, 0, sizeof(*batch));
+
+    if (raw_size == 0) {
+        PyErr_SetString(ZvbiRawDecError, "Raw decoder parameters are not initialized");
+        return FALSE;
+    }
+    if (PyObject_CheckBuffer(frames_obj)) {
+        // contiguous buffer with consecutive frames, e.g. a mapped raw recording
+        batch->in_bufs = PyMem_New(Py_buffer, 1);
+        if (batch->in_bufs == NULL) {
+            PyErr_NoMemory();
+            return FALSE;
+        }
+        if (PyObject_GetBuffer(frames_obj, &batch->in_bufs[0], PyBUF_SIMPLE) != 0) {
+            return FALSE;
+        }
+        batch->in_buf_cnt = 1;
+        if (batch->in_bufs[0].len % raw_size != 0) {
+            PyErr_Format(PyExc_ValueError, "Buffer length %zd is not a multiple of the frame size %zu",
+                         batch->in_bufs[0].len, raw_size);
+            return FALSE;
+        }
+        batch->frame_cnt = batch->in_bufs[0].len / raw_size;
+        if (PyObject_TypeCheck(frames_obj, &ZvbiCaptureRawBufTypeDef)) {
+            timestamp = ZvbiCaptureBuf_GetBuf(frames_obj)->timestamp;
+        }
+    }
+    else {
+        batch->seq = PySequence_Fast(frames_obj, "Expected a buffer or a sequence of buffers");
+        if (batch->seq == NULL) {
+            return FALSE;
+        }
+        batch->frame_cnt = PySequence_Fast_GET_SIZE(batch->seq);
+        batch->in_bufs = PyMem_New(Py_buffer, batch->frame_cnt + 1);
+        if (batch->in_bufs == NULL) {
+            PyErr_NoMemory();
+            return FALSE;
+        }
+    }
+    batch->frames = PyMem_New(const uint8_t *, batch->frame_cnt + 1);
+    batch->timestamps = PyMem_New(double, batch->frame_cnt + 1);
+    batch->line_cnt = PyMem_New(unsigned, batch->frame_cnt + 1);
+    if ((batch->frames == NULL) || (batch->timestamps == NULL) || (batch->line_cnt == NULL)) {
+        PyErr_NoMemory();
+        return FALSE;
+    }
+
+    for (Py_ssize_t idx = 0; idx < batch->frame_cnt; ++idx) {
+        batch->timestamps[idx] = timestamp + idx * frame_period;
+
+        if (batch->seq == NULL) {
+            batch->frames[idx] = (const uint8_t*)batch->in_bufs[0].buf + idx * raw_size;
+        }
+        else {
+            PyObject * item = PySequence_Fast_GET_ITEM(batch->seq, idx);
+            if (PyObject_GetBuffer(item, &batch->in_bufs[idx], PyBUF_SIMPLE) != 0) {
+                return FALSE;
+            }
+            batch->in_buf_cnt += 1;
+            if ((size_t)batch->in_bufs[idx].len < raw_size) {
+                PyErr_Format(ZvbiRawDecError, "Input raw buffer #%zd is smaller than required for "
+                             "VBI geometry", idx);
+                return FALSE;
+            }
+            batch->frames[idx] = batch->in_bufs[idx].buf;
+            if (PyObject_TypeCheck(item, &ZvbiCaptureRawBufTypeDef)) {
+                batch->timestamps[idx] = ZvbiCaptureBuf_GetBuf(item)->timestamp;
+            }
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * Return a tuple with a view on the lines of each frame in the given block.
+ */
+static PyObject *
+ZvbiRawDec_BatchResult(ZvbiRawDecBatch * batch, PyObject * block)
+{
+    PyObject * RETVAL = PyTuple_New(batch->frame_cnt);
+    if (RETVAL != NULL) {
+        unsigned start = 0;
+        for (Py_ssize_t idx = 0; idx < batch->frame_cnt; ++idx) {
+            PyObject * view = ZvbiCaptureSlicedBuf_NewView(block, start, batch->line_cnt[idx],
+                                                           batch->timestamps[idx]);
+            if (view == NULL) {
+                Py_CLEAR(RETVAL);
+                break;
+            }
+            PyTuple_SET_ITEM(RETVAL, idx, view);
+            start += batch->line_cnt[idx];
+        }
+    }
+    return RETVAL;
+}
+
+/*
+ * Common implementation of "decode_many" of Zvbi.RawDec and
+ * Zvbi.ParallelRawDec: collects the input frames, provides the output block
+ * and returns views on the result of the given decoding function. The
+ * decoding function is called without holding the GIL.
+ */
+static PyObject *
+ZvbiRawDec_DecodeMany(PyObject * self, const vbi_raw_decoder * rd, ZvbiRawDecBatchFunc * decode,
+                      PyObject * args, PyObject * kwds)
+{
+    static char * kwlist[] = {"raw_frames", "out", "timestamp", NULL};
+    PyObject * frames_obj = NULL;
+    PyObject * out_obj = Py_None;
+    double timestamp = 0.0;
+    ZvbiRawDecBatch batch;
+    PyObject * RETVAL = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O$d", kwlist, &frames_obj, &out_obj, &timestamp)) {
+        return NULL;
+    }
+    if (ZvbiRawDec_GetBatch(rd, frames_obj, timestamp, &batch)) {
+        // the output block needs capacity for the maximum number of lines of all frames
+        size_t max_lines = (size_t)batch.frame_cnt * (rd->count[0] + rd->count[1]);
+        double block_ts = (batch.frame_cnt > 0) ? batch.timestamps[0] : timestamp;
+
+        if (out_obj == Py_None) {
+            vbi_sliced * p_sliced = ZvbiCaptureSlicedBuf_AllocLines(max_lines);
+            if (p_sliced != NULL) {
+                unsigned n_lines;
+                Py_BEGIN_ALLOW_THREADS
+                n_lines = decode(self, &batch, p_sliced);
+                Py_END_ALLOW_THREADS
+
+                PyObject * block = ZvbiCaptureSlicedBuf_FromData(p_sliced, n_lines, block_ts);
+                if (block != NULL) {
+                    RETVAL = ZvbiRawDec_BatchResult(&batch, block);
+                    Py_DECREF(block);
+                }
+                else {
+                    ZvbiCaptureSlicedBuf_FreeLines(p_sliced);
+                }
+            }
+            else {
+                PyErr_NoMemory();
+            }
+        }
+        else {
+            unsigned out_max_lines = 0;
+            vbi_capture_buffer * out_buf = ZvbiCaptureSlicedBuf_GetFillable(out_obj, &out_max_lines);
+            if (out_buf != NULL) {
+                Py_buffer out_view;
+                if (out_max_lines < max_lines) {
+                    PyErr_Format(PyExc_ValueError, "Output buffer too small: %zu lines required for %zd frames",
+                                 max_lines, batch.frame_cnt);
+                }
+                // keep an export on the output buffer while the GIL is released,
+                // so that it cannot be refilled by other threads meanwhile
+                else if (PyObject_GetBuffer(out_obj, &out_view, PyBUF_SIMPLE) == 0) {
+                    unsigned n_lines;
+                    Py_BEGIN_ALLOW_THREADS
+                    n_lines = decode(self, &batch, out_buf->data);
+                    Py_END_ALLOW_THREADS
+                    PyBuffer_Release(&out_view);
+
+                    out_buf->size = n_lines * sizeof(vbi_sliced);
+                    out_buf->timestamp = block_ts;
+                    RETVAL = ZvbiRawDec_BatchResult(&batch, out_obj);
+                }
+            }
+        }
+    }
+    ZvbiRawDec_FreeBatch(&batch);
+    return RETVAL;
+}
+
+/*
+ * Slice all frames of the batch in the calling thread.
+ */
+static unsigned
+ZvbiRawDec_DecodeBatch(PyObject * obj, ZvbiRawDecBatch * batch, vbi_sliced * p_sliced)
+{
+    ZvbiRawDecObj * self = (ZvbiRawDecObj *) obj;
+    unsigned fill = 0;
+
+    for (Py_ssize_t idx = 0; idx < batch->frame_cnt; ++idx) {
+        batch->line_cnt[idx] = ZvbiRawDec_Slice(&self->rd, self->slicer, batch->frames[idx], p_sliced + fill);
+        fill += batch->line_cnt[idx];
+    }
+    return fill;
+}
+
+static PyObject *
+ZvbiRawDec_decode_many(ZvbiRawDecObj *self, PyObject *args, PyObject *kwds)
+{
+    PyObject * RETVAL = NULL;
+
+    if (ZvbiRawDec_CheckIdle(self)) {
+        self->busy = TRUE;
+        RETVAL = ZvbiRawDec_DecodeMany((PyObject *) self, &self->rd, ZvbiRawDec_DecodeBatch, args, kwds);
+        self->busy = FALSE;
+    }
+    return RETVAL;
+}
+
+// ---------------------------------------------------------------------------
+//  Multi-threaded VBI raw decoder
+// ---------------------------------------------------------------------------
+
+/*
+ * Slicing of different frames is independent, given fixed parameters. Each
+ * worker thread therefore uses its own clone of the raw decoder context and
+ * processes a contiguous range of frames of a batch. The threads are created
+ * by the constructor and wait for the next batch in between, so that the
+ * cost of thread creation is not incurred per call.
+ */
+struct ZvbiParallelRawDecObj_struct;
+
+typedef struct {
+    vbi_raw_decoder     rd;
+    const ZvbiRawSlicer * slicer;       // built-in slicer shared by all workers, or NULL
+    struct ZvbiParallelRawDecObj_struct * owner;
+    unsigned            idx;
+    pthread_t           thread;
+    vbi_bool            started;        // TRUE if the thread was created successfully
+    unsigned            generation;     // last batch seen by the thread
+    ZvbiRawDecBatch *   batch;
+    Py_ssize_t          first_frame;
+    Py_ssize_t          frame_cnt;
+    vbi_sliced *        p_sliced;       // output area with capacity for all lines of the range
+    unsigned            n_lines;        // number of sliced lines in the output area
+} ZvbiParallelRawDecWorker;
+
+typedef struct ZvbiParallelRawDecObj_struct {
+    PyObject_HEAD
+    unsigned                    worker_cnt;
+    ZvbiParallelRawDecWorker *  workers;
+    vbi_bool                    busy;   // TRUE while decoding with the GIL released
+    vbi_bool                    fast_slicer;
+    ZvbiRawSlicer *             slicer; // stateless, hence shared by all workers
+
+    // synchronization with the worker threads, protected by the mutex
+    pthread_mutex_t             mutex;
+    pthread_cond_t              start_cond;
+    pthread_cond_t              done_cond;
+    unsigned                    generation;     // incremented for each batch
+    unsigned                    active_cnt;     // number of workers used for the current batch
+    unsigned                    pending_cnt;    // number of threads still busy with the batch
+    vbi_bool                    stop;
+} ZvbiParallelRawDecObj;
+
+static PyObject *
+ZvbiParallelRawDec_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    ZvbiParallelRawDecObj * self = (ZvbiParallelRawDecObj *) type->tp_alloc(type, 0);
+    if (self != NULL) {
+        pthread_mutex_init(&self->mutex, NULL);
+        pthread_cond_init(&self->start_cond, NULL);
+        pthread_cond_init(&self->done_cond, NULL);
+    }
+    return (PyObject *) self;
+}
+
+/*
+ * Stop and join all worker threads. The threads are idle at this point, as
+ * batches are always completed before returning to the caller.
+ */
+static void
+ZvbiParallelRawDec_StopThreads(ZvbiParallelRawDecObj *self)
+{
+    pthread_mutex_lock(&self->mutex);
+    self->stop = TRUE;
+    pthread_cond_broadcast(&self->start_cond);
+    pthread_mutex_unlock(&self->mutex);
+
+    for (unsigned idx = 1; idx < self->worker_cnt; ++idx) {
+        if (self->workers[idx].started) {
+            pthread_join(self->workers[idx].thread, NULL);
+            self->workers[idx].started = FALSE;
+        }
+    }
+    self->stop = FALSE;
+}
+
+static void
+ZvbiParallelRawDec_Clear(ZvbiParallelRawDecObj *self)
+{
+    if (self->workers != NULL) {
+        ZvbiParallelRawDec_StopThreads(self);
+    }
+    for (unsigned idx = 0; idx < self->worker_cnt; ++idx) {
+        vbi_raw_decoder_destroy(&self->workers[idx].rd);
+    }
+    PyMem_Free(self->workers);
+    self->workers = NULL;
+    self->worker_cnt = 0;
+    ZvbiRawSlicer_Free(self->slicer);
+    self->slicer = NULL;
+}
+
+static void
+ZvbiParallelRawDec_dealloc(ZvbiParallelRawDecObj *self)
+{
+    ZvbiParallelRawDec_Clear(self);
+    pthread_cond_destroy(&self->done_cond);
+    pthread_cond_destroy(&self->start_cond);
+    pthread_mutex_destroy(&self->mutex);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static vbi_bool
+ZvbiParallelRawDec_CheckIdle(ZvbiParallelRawDecObj * self)
+{
+    if (self->busy) {
+        PyErr_SetString(ZvbiRawDecError, "ParallelRawDec is in use by another thread");
+        return FALSE;
+    }
+    if (self->workers == NULL) {
+        PyErr_SetString(ZvbiRawDecError, "ParallelRawDec is not initialized");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void
+ZvbiParallelRawDec_Process(ZvbiParallelRawDecWorker * worker)
+{
+    ZvbiRawDecBatch * batch = worker->batch;
+
+    worker->n_lines = 0;
+    for (Py_ssize_t idx = worker->first_frame; idx < worker->first_frame + worker->frame_cnt; ++idx) {
+        batch->line_cnt[idx] = ZvbiRawDec_Slice(&worker->rd, worker->slicer, batch->frames[idx],
+                                                worker->p_sliced + worker->n_lines);
+        worker->n_lines += batch->line_cnt[idx];
+    }
+}
+
+/*
+ * Main loop of the worker threads: wait for the start of a batch, process
+ * the assigned range of frames (if any) and report completion.
+ */
+static void *
+ZvbiParallelRawDec_Main(void * arg)
+{
+    ZvbiParallelRawDecWorker * worker = arg;
+    ZvbiParallelRawDecObj * self = worker->owner;
+
+    pthread_mutex_lock(&self->mutex);
+    for (;;) {
+        while (!self->stop && (self->generation == worker->generation)) {
+            pthread_cond_wait(&self->start_cond, &self->mutex);
+        }
+        if (self->stop) {
+            break;
+        }
+        worker->generation = self->generation;
+        if (worker->idx < self->active_cnt) {
+            pthread_mutex_unlock(&self->mutex);
+            ZvbiParallelRawDec_Process(worker);
+            pthread_mutex_lock(&self->mutex);
+
+            self->pending_cnt -= 1;
+            if (self->pending_cnt == 0) {
+                pthread_cond_signal(&self->done_cond);
+            }
+        }
+    }
+    pthread_mutex_unlock(&self->mutex);
+    return NULL;
+}
+
+static int
+ZvbiParallelRawDec_init(ZvbiParallelRawDecObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"par", "threads", "fast_slicer", NULL};
+    PyObject * obj = NULL;
+    int thread_cnt = 0;
+    int fast_slicer = FALSE;
+
+    if (self->busy) {
+        PyErr_SetString(ZvbiRawDecError, "ParallelRawDec is in use by another thread");
+        return -1;
+    }
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$ip", kwlist, &obj, &thread_cnt, &fast_slicer)) {
+        return -1;
+    }
+    if (thread_cnt <= 0) {
+        // default: one thread per processor
+        long cpu_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_cnt = (cpu_cnt > 0) ? cpu_cnt : 1;
+    }
+    else if (thread_cnt > 256) {
+        PyErr_Format(PyExc_ValueError, "Invalid number of threads: %d", thread_cnt);
+        return -1;
+    }
+    vbi_raw_decoder * p_par = ZvbiRawDec_GetParams(obj);
+    if (p_par == NULL) {
+        return -1;
+    }
+
+    // reset state in case the object is already initialized
+    ZvbiParallelRawDec_Clear(self);
+
+    self->workers = PyMem_New(ZvbiParallelRawDecWorker, thread_cnt);
+    if (self->workers == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (int idx = 0; idx < thread_cnt; ++idx) {
+        vbi_raw_decoder_init(&self->workers[idx].rd);
+        ZvbiRawDec_CopyParams(&self->workers[idx].rd, p_par);
+        self->workers[idx].owner = self;
+        self->workers[idx].idx = idx;
+        self->workers[idx].started = FALSE;
+        self->workers[idx].generation = self->generation;
+    }
+    self->worker_cnt = thread_cnt;
+
+    // the first range of each batch is processed by the calling thread
+    for (int idx = 1; idx < thread_cnt; ++idx) {
+        self->workers[idx].started = (pthread_create(&self->workers[idx].thread, NULL,
+                                                     ZvbiParallelRawDec_Main, &self->workers[idx]) == 0);
+    }
+    self->fast_slicer = fast_slicer;
+
+    if (!ZvbiRawDec_UpdateSlicer(&self->slicer, self->fast_slicer, &self->workers[0].rd)) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Distribute the frames of the batch onto the workers and wait for all of
+ * them to finish. The first range is processed by the calling thread. The
+ * results are then moved together, so that lines of all frames are stored
+ * consecutively and in order.
+ */
+static unsigned
+ZvbiParallelRawDec_DecodeBatch(PyObject * obj, ZvbiRawDecBatch * batch, vbi_sliced * p_sliced)
+{
+    ZvbiParallelRawDecObj * self = (ZvbiParallelRawDecObj *) obj;
+    unsigned frame_lines = self->workers[0].rd.count[0] + self->workers[0].rd.count[1];
+    unsigned worker_cnt = self->worker_cnt;
+    Py_ssize_t first_frame = 0;
+
+    if (batch->frame_cnt < worker_cnt) {
+        worker_cnt = batch->frame_cnt;
+    }
+    for (unsigned idx = 0; idx < worker_cnt; ++idx) {
+        ZvbiParallelRawDecWorker * worker = &self->workers[idx];
+        // distribute the remainder onto the first workers
+        Py_ssize_t frame_cnt = batch->frame_cnt / worker_cnt + ((idx < batch->frame_cnt % worker_cnt) ? 1 : 0);
+
+        worker->slicer = self->slicer;
+        worker->batch = batch;
+        worker->first_frame = first_frame;
+        worker->frame_cnt = frame_cnt;
+        worker->p_sliced = p_sliced + first_frame * frame_lines;
+        first_frame += frame_cnt;
+    }
+    unsigned pending_cnt = 0;
+    for (unsigned idx = 1; idx < worker_cnt; ++idx) {
+        if (self->workers[idx].started) {
+            pending_cnt += 1;
+        }
+    }
+    if (pending_cnt > 0) {
+        pthread_mutex_lock(&self->mutex);
+        self->active_cnt = worker_cnt;
+        self->pending_cnt = pending_cnt;
+        self->generation += 1;
+        pthread_cond_broadcast(&self->start_cond);
+        pthread_mutex_unlock(&self->mutex);
+    }
+    if (worker_cnt > 0) {
+        ZvbiParallelRawDec_Process(&self->workers[0]);
+    }
+    for (unsigned idx = 1; idx < worker_cnt; ++idx) {
+        if (!self->workers[idx].started) {
+            // thread could not be created: process the range in this thread instead
+            ZvbiParallelRawDec_Process(&self->workers[idx]);
+        }
+    }
+    if (pending_cnt > 0) {
+        pthread_mutex_lock(&self->mutex);
+        while (self->pending_cnt > 0) {
+            pthread_cond_wait(&self->done_cond, &self->mutex);
+        }
+        pthread_mutex_unlock(&self->mutex);
+    }
+
+    unsigned fill = 0;
+    for (unsigned idx = 0; idx < worker_cnt; ++idx) {
+        ZvbiParallelRawDecWorker * worker = &self->workers[idx];
+        if (worker->p_sliced != p_sliced + fill) {
+            memmove(p_sliced + fill, worker->p_sliced, worker->n_lines * sizeof(vbi_sliced));
+        }
+        fill += worker->n_lines;
+    }
+    return fill;
+}
+
+static PyObject *
+ZvbiParallelRawDec_decode_many(ZvbiParallelRawDecObj *self, PyObject *args, PyObject *kwds)
+{
+    PyObject * RETVAL = NULL;
+
+    if (ZvbiParallelRawDec_CheckIdle(self)) {
+        self->busy = TRUE;
+        RETVAL = ZvbiRawDec_DecodeMany((PyObject *) self, &self->workers[0].rd,
+                                       ZvbiParallelRawDec_DecodeBatch, args, kwds);
+        self->busy = FALSE;
+    }
+    return RETVAL;
+}
+
+static PyObject *
+ZvbiParallelRawDec_reset(ZvbiParallelRawDecObj *self, PyObject *args)
+{
+    if (!ZvbiParallelRawDec_CheckIdle(self)) {
+        return NULL;
+    }
+    for (unsigned idx = 0; idx < self->worker_cnt; ++idx) {
+        vbi_raw_decoder_reset(&self->workers[idx].rd);
+    }
+    if (!ZvbiRawDec_UpdateSlicer(&self->slicer, self->fast_slicer, &self->workers[0].rd)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+ZvbiParallelRawDec_add_services(ZvbiParallelRawDecObj *self, PyObject *args)
+{
+    unsigned services;
+    int strict = 0;
+
+    if (!PyArg_ParseTuple(args, "I|I", &services, &strict) || !ZvbiParallelRawDec_CheckIdle(self)) {
+        return NULL;
+    }
+    unsigned result = 0;
+    for (unsigned idx = 0; idx < self->worker_cnt; ++idx) {
+        result = vbi_raw_decoder_add_services(&self->workers[idx].rd, services, strict);
+    }
+    if (!ZvbiRawDec_UpdateSlicer(&self->slicer, self->fast_slicer, &self->workers[0].rd)) {
+        return NULL;
+    }
+    return PyLong_FromLong(result);
+}
+
+static PyObject *
+ZvbiParallelRawDec_remove_services(ZvbiParallelRawDecObj *self, PyObject *args)
+{
+    unsigned services;
+
+    if (!PyArg_ParseTuple(args, "I", &services) || !ZvbiParallelRawDec_CheckIdle(self)) {
+        return NULL;
+    }
+    unsigned result = 0;
+    for (unsigned idx = 0; idx < self->worker_cnt; ++idx) {
+        result = vbi_raw_decoder_remove_services(&self->workers[idx].rd, services);
+    }
+    if (!ZvbiRawDec_UpdateSlicer(&self->slicer, self->fast_slicer, &self->workers[0].rd)) {
+        return NULL;
+    }
+    return PyLong_FromLong(result);
+}
+
+static PyObject *
+ZvbiParallelRawDecGetSlicer(ZvbiParallelRawDecObj * self, void * closure)
+{
+    return PyUnicode_FromString((self->slicer != NULL) ? ZvbiRawSlicer_Name(self->slicer) : "libzvbi");
+}
+
+static PyObject *
+ZvbiParallelRawDecGetThreads(ZvbiParallelRawDecObj * self, void * closure)
+{
+    return PyLong_FromLong(self->worker_cnt);
+}
+
 // ---------------------------------------------------------------------------
 
 static PyMethodDef ZvbiRawDec_MethodsDef[] =
@@ -229,9 +942,20 @@ static PyMethodDef ZvbiRawDec_MethodsDef[] =
     {"remove_services", (PyCFunction) ZvbiRawDec_remove_services, METH_VARARGS, NULL },
     {"resize",          (PyCFunction) ZvbiRawDec_resize,          METH_VARARGS, NULL },
     {"decode",          (PyCFunction) ZvbiRawDec_decode,          METH_VARARGS, NULL },
+    {"decode_many",     (PyCFunction) ZvbiRawDec_decode_many,     METH_VARARGS | METH_KEYWORDS, NULL },
     {NULL}  /* Sentinel */
 };
 
+static PyGetSetDef ZvbiRawDecGetSetDef[] =
+{
+    { .name = "slicer",
+      .get = (getter) ZvbiRawDecGetSlicer,
+      .set = NULL,
+      .doc = PyDoc_STR("Name of the slicer implementation currently in use"),
+    },
+    {NULL}
+};
+
 static PyTypeObject ZvbiRawDecTypeDef =
 {
     PyVarObject_HEAD_INIT(NULL, 0)
@@ -246,11 +970,53 @@ static PyTypeObject ZvbiRawDecTypeDef =
     //.tp_repr = (PyObject * (*)(PyObject*)) ZvbiRawDec_Repr,
     .tp_methods = ZvbiRawDec_MethodsDef,
     //.tp_members = ZvbiRawDec_Members,
+    .tp_getset = ZvbiRawDecGetSetDef,
+};
+
+static PyMethodDef ZvbiParallelRawDec_MethodsDef[] =
+{
+    {"reset",           (PyCFunction) ZvbiParallelRawDec_reset,           METH_NOARGS,  NULL },
+    {"add_services",    (PyCFunction) ZvbiParallelRawDec_add_services,    METH_VARARGS, NULL },
+    {"remove_services", (PyCFunction) ZvbiParallelRawDec_remove_services, METH_VARARGS, NULL },
+    {"decode_many",     (PyCFunction) ZvbiParallelRawDec_decode_many,     METH_VARARGS | METH_KEYWORDS, NULL },
+    {NULL}  /* Sentinel */
+};
+
+static PyGetSetDef ZvbiParallelRawDecGetSetDef[] =
+{
+    { .name = "threads",
+      .get = (getter) ZvbiParallelRawDecGetThreads,
+      .set = NULL,
+      .doc = PyDoc_STR("Number of worker threads"),
+    },
+    { .name = "slicer",
+      .get = (getter) ZvbiParallelRawDecGetSlicer,
+      .set = NULL,
+      .doc = PyDoc_STR("Name of the slicer implementation currently in use"),
+    },
+    {NULL}
+};
+
+static PyTypeObject ZvbiParallelRawDecTypeDef =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "Zvbi.ParallelRawDec",
+    .tp_doc = PyDoc_STR("Class for decoding raw capture output using multiple threads"),
+    .tp_basicsize = sizeof(ZvbiParallelRawDecObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = ZvbiParallelRawDec_new,
+    .tp_init = (initproc) ZvbiParallelRawDec_init,
+    .tp_dealloc = (destructor) ZvbiParallelRawDec_dealloc,
+    .tp_methods = ZvbiParallelRawDec_MethodsDef,
+    .tp_getset = ZvbiParallelRawDecGetSetDef,
 };
 
 int PyInit_RawDec(PyObject * module, PyObject * error_base)
 {
-    if (PyType_Ready(&ZvbiRawDecTypeDef) < 0) {
+    if ((PyType_Ready(&ZvbiRawDecTypeDef) < 0) ||
+        (PyType_Ready(&ZvbiParallelRawDecTypeDef) < 0))
+    {
         return -1;
     }
 
@@ -264,7 +1030,7 @@ int PyInit_RawDec(PyObject * module, PyObject * error_base)
         return -1;
     }
 
-    // create class type object
+    // create class type objects
     Py_INCREF(&ZvbiRawDecTypeDef);
     if (PyModule_AddObject(module, "RawDec", (PyObject *) &ZvbiRawDecTypeDef) < 0) {
         Py_DECREF(&ZvbiRawDecTypeDef);
@@ -272,6 +1038,14 @@ int PyInit_RawDec(PyObject * module, PyObject * error_base)
         Py_CLEAR(ZvbiRawDecError);
         return -1;
     }
+    Py_INCREF(&ZvbiParallelRawDecTypeDef);
+    if (PyModule_AddObject(module, "ParallelRawDec", (PyObject *) &ZvbiParallelRawDecTypeDef) < 0) {
+        Py_DECREF(&ZvbiParallelRawDecTypeDef);
+        Py_DECREF(&ZvbiRawDecTypeDef);
+        Py_XDECREF(ZvbiRawDecError);
+        Py_CLEAR(ZvbiRawDecError);
+        return -1;
+    }
 
     return 0;
 }
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include "Python.h"
+
+#include <libzvbi.h>
+
+#include "zvbi_raw_encoder.h"
+#include "zvbi_raw_params.h"
+#include "zvbi_capture_buf.h"
+#include "zvbi_compact_sliced_buf.h"
+
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    PyObject_HEAD
+    vbi_raw_decoder par;
+    int             blank_level;
+    int             white_level;
+    int             swap_fields;
+    unsigned        seed;           // seed for the next frame, when not specified by the caller
+} ZvbiRawEncoderObj;
+
+static PyObject * ZvbiRawEncoderError;
+
+// default signal levels for 8-bit luma samples according to ITU-R BT.601
+#define ZVBI_RAW_ENCODER_BLANK_LEVEL 16
+#define ZVBI_RAW_ENCODER_WHITE_LEVEL 235
+
+// ---------------------------------------------------------------------------
+//  VBI raw waveform synthesizer
+// ---------------------------------------------------------------------------
+
+static PyObject *
+ZvbiRawEncoder_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    return type->tp_alloc(type, 0);
+}
+
+static void
+ZvbiRawEncoder_dealloc(ZvbiRawEncoderObj *self)
+{
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int
+ZvbiRawEncoder_init(ZvbiRawEncoderObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"par", "blank_level", "white_level", "swap_fields", NULL};
+    PyObject * par_obj = NULL;
+    int blank_level = ZVBI_RAW_ENCODER_BLANK_LEVEL;
+    int white_level = ZVBI_RAW_ENCODER_WHITE_LEVEL;
+    int swap_fields = FALSE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|$iip", kwlist,
+                                     &ZvbiRawParamsTypeDef, &par_obj,
+                                     &blank_level, &white_level, &swap_fields))
+    {
+        return -1;
+    }
+    if ((blank_level < 0) || (white_level > 255) || (blank_level >= white_level)) {
+        PyErr_Format(PyExc_ValueError, "Invalid signal levels: blank %d, white %d", blank_level, white_level);
+        return -1;
+    }
+    vbi_raw_decoder * p_par = ZvbiRawParamsGetStruct(par_obj);
+    if ((p_par->count[0] + p_par->count[1] <= 0) || (p_par->bytes_per_line <= 0)) {
+        PyErr_SetString(ZvbiRawEncoderError, "Raw parameters specify an empty frame");
+        return -1;
+    }
+    self->par = *p_par;
+    self->blank_level = blank_level;
+    self->white_level = white_level;
+    self->swap_fields = swap_fields;
+    self->seed = 1;
+    return 0;
+}
+
+static PyObject *
+ZvbiRawEncoder_encode(ZvbiRawEncoderObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"sliced_buf", "noise", "noise_min_freq", "noise_max_freq", "seed", NULL};
+    PyObject * sliced_obj = NULL;
+    unsigned noise = 0;
+    unsigned noise_min_freq = 0;
+    unsigned noise_max_freq = 5000000;
+    PyObject * seed_obj = Py_None;
+    PyObject * RETVAL = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|$IIIO", kwlist,
+                                     ZvbiCompactSlicedBuf_Converter, &sliced_obj,
+                                     &noise, &noise_min_freq, &noise_max_freq, &seed_obj))
+    {
+        return NULL;
+    }
+    vbi_capture_buffer * sliced_buffer = ZvbiCaptureBuf_GetBuf(sliced_obj);
+    unsigned seed = self->seed;
+
+    if ((seed_obj != Py_None) && ((seed = PyLong_AsUnsignedLong(seed_obj)) == (unsigned)-1) && PyErr_Occurred()) {
+        // error already raised
+    }
+    else if ((sliced_buffer == NULL) || (sliced_buffer->data == NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Sliced capture buffer contains no data");
+    }
+    else if (noise > 256) {
+        PyErr_Format(PyExc_ValueError, "Noise amplitude %u exceeds maximum 256", noise);
+    }
+    else {
+        size_t raw_size = (self->par.count[0] + self->par.count[1]) * self->par.bytes_per_line;
+        uint8_t * raw_data = PyMem_RawMalloc(raw_size);
+
+        if (raw_data != NULL) {
+            // start from defined content, as padding after the samples of each line is not written
+            memset(raw_data, 0, raw_size);
+
+            if (!vbi_raw_vbi_image(raw_data, raw_size, &self->par,
+                                   self->blank_level, self->white_level, self->swap_fields,
+                                   sliced_buffer->data, sliced_buffer->size / sizeof(vbi_sliced)))
+            {
+                PyErr_SetString(ZvbiRawEncoderError, "Failed to render sliced data: unsupported "
+                                "raw parameters, service or line number");
+            }
+            else if ((noise > 0) &&
+                     !vbi_raw_add_noise(raw_data, &self->par, noise_min_freq, noise_max_freq, noise, seed))
+            {
+                PyErr_SetString(ZvbiRawEncoderError, "Failed to add noise: unsupported sampling format "
+                                "or frequency range");
+            }
+            else {
+                RETVAL = ZvbiCaptureRawBuf_FromData((char*)raw_data, raw_size, sliced_buffer->timestamp,
+                                                    &self->par);
+                // different noise for consecutive frames, unless specified by the caller
+                self->seed = seed + 1;
+            }
+            if (RETVAL == NULL) {
+                PyMem_RawFree(raw_data);
+            }
+        }
+        else {
+            PyErr_NoMemory();
+        }
+    }
+    Py_DECREF(sliced_obj);
+    return RETVAL;
+}
+
+// ---------------------------------------------------------------------------
+
+static PyMethodDef ZvbiRawEncoder_MethodsDef[] =
+{
+    {"encode", (PyCFunction) ZvbiRawEncoder_encode, METH_VARARGS | METH_KEYWORDS, NULL },
+    {NULL}  /* Sentinel */
+};
+
+static PyTypeObject ZvbiRawEncoderTypeDef =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "Zvbi.RawEncoder",
+    .tp_doc = PyDoc_STR("Class for synthesizing raw VBI data from sliced data"),
+    .tp_basicsize = sizeof(ZvbiRawEncoderObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = ZvbiRawEncoder_new,
+    .tp_init = (initproc) ZvbiRawEncoder_init,
+    .tp_dealloc = (destructor) ZvbiRawEncoder_dealloc,
+    .tp_methods = ZvbiRawEncoder_MethodsDef,
+};
+
+int PyInit_RawEncoder(PyObject * module, PyObject * error_base)
+{
+    if (PyType_Ready(&ZvbiRawEncoderTypeDef) < 0) {
+        return -1;
+    }
+
+    // create exception class
+    ZvbiRawEncoderError = PyErr_NewException("Zvbi.RawEncoderError", error_base, NULL);
+    Py_XINCREF(ZvbiRawEncoderError);
+    if (PyModule_AddObject(module, "RawEncoderError", ZvbiRawEncoderError) < 0) {
+        Py_XDECREF(ZvbiRawEncoderError);
+        Py_CLEAR(ZvbiRawEncoderError);
+        Py_DECREF(module);
+        return -1;
+    }
+
+    // create class type objects
+    Py_INCREF(&ZvbiRawEncoderTypeDef);
+    if (PyModule_AddObject(module, "RawEncoder", (PyObject *) &ZvbiRawEncoderTypeDef) < 0) {
+        Py_DECREF(&ZvbiRawEncoderTypeDef);
+        Py_XDECREF(ZvbiRawEncoderError);
+        Py_CLEAR(ZvbiRawEncoderError);
+        return -1;
+    }
+
+    return 0;
+}
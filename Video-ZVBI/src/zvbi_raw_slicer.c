@@ -0,0 +1,533 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include "Python.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <libzvbi.h>
+
+#include "zvbi_raw_slicer.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && defined(__GNUC__)
+#define ZVBI_RAW_SLICER_X86 1
+#include <immintrin.h>
+#endif
+
+// ---------------------------------------------------------------------------
+//  Built-in bit slicer for 8-bit luma raw data
+// ---------------------------------------------------------------------------
+
+/*
+ * This slicer is an alternative to vbi_raw_decode() for the most common
+ * services of 625-line systems, when raw data is captured with one byte per
+ * sample (i.e. VBI_PIXFMT_YUV420, or grey-scale). The parts of the work that
+ * scale with the number of samples, which are determining the signal level
+ * and locating the edges of the clock run-in, are vectorized using SSE2 or
+ * AVX2 depending on the CPU, with a portable fallback. Sampling of payload
+ * bits then only needs to look at a few samples per bit.
+ *
+ * Unlike the libzvbi slicer, no state is kept between frames, so that one
+ * instance can be used by multiple threads concurrently.
+ */
+
+typedef struct {
+    vbi_service_set     id;
+    unsigned            first[2];       // first and last line per field, or 0 if not used in a field
+    unsigned            last[2];
+    unsigned            offset_ns;      // nominal start of the clock run-in relative to 0H
+    unsigned            cri_rate;       // rate of clock run-in and framing code
+    unsigned            bit_rate;       // payload bit rate
+    uint32_t            cri;            // clock run-in and framing code; first bit in MSB
+    uint32_t            cri_mask;       // bits of "cri" that have to match
+    unsigned            cri_bits;
+    unsigned            payload_bits;
+    vbi_bool            biphase;        // each payload bit is sent as two halves of opposite level
+    vbi_bool            msb_first;
+} ZvbiRawSlicerService;
+
+/*
+ * Parameters are the same as used by libzvbi, except for a shorter CRI mask
+ * for Teletext, which tolerates loss of the first clock run-in bits.
+ */
+static const ZvbiRawSlicerService ZvbiRawSlicer_Services[] =
+{
+    { VBI_SLICED_TELETEXT_B, { 6, 318 }, { 22, 335 }, 10300, 6937500, 6937500,
+      0x00AAAAE4, 0x000FFFFF, 24, 42 * 8, FALSE, FALSE },
+    { VBI_SLICED_VPS, { 16, 0 }, { 16, 0 }, 7600, 5000000, 2500000,
+      0xAAAA8A99, 0x00FFFFFF, 32, 13 * 8, TRUE, TRUE },
+    { VBI_SLICED_WSS_625, { 23, 0 }, { 23, 0 }, 11000, 5000000, 833333,
+      0xC71E3C1F, 0x924C99CE, 32, 14, TRUE, FALSE },
+};
+#define ZVBI_RAW_SLICER_SVC_CNT (sizeof(ZvbiRawSlicer_Services) / sizeof(ZvbiRawSlicer_Services[0]))
+#define ZVBI_RAW_SLICER_SERVICES (VBI_SLICED_TELETEXT_B | VBI_SLICED_VPS | VBI_SLICED_WSS_625)
+
+// tolerance for the start of the clock run-in relative to the nominal position
+#define ZVBI_RAW_SLICER_EARLY_NS 4000
+#define ZVBI_RAW_SLICER_LATE_NS 8000
+// maximum number of samples searched for the start of the clock run-in
+#define ZVBI_RAW_SLICER_MAX_WIN 2048
+// minimum difference between black and white level for accepting a line
+#define ZVBI_RAW_SLICER_MIN_AMPLITUDE 40
+// number of additional bits sampled for matching the CRI, when the first edge was missed
+#define ZVBI_RAW_SLICER_CRI_SLACK 8
+
+typedef struct {
+    const ZvbiRawSlicerService * svc;
+    uint32_t            cri_step;       // distance of CRI bits in samples (16.16 fixed point)
+    uint32_t            bit_step;       // distance of payload bits in samples (16.16 fixed point)
+    unsigned            win_start;      // range of samples searched for the start of the CRI
+    unsigned            win_end;
+} ZvbiRawSlicerJob;
+
+typedef struct {
+    unsigned            offset;         // offset of the line in the raw frame
+    unsigned            line;           // ITU-R line number, or 0 if unknown
+    unsigned            jobs;           // bit mask of indices into the job table
+} ZvbiRawSlicerRow;
+
+typedef void ZvbiRawSlicerMinMax(const uint8_t * p, unsigned n, unsigned * p_min, unsigned * p_max);
+typedef void ZvbiRawSlicerThreshold(const uint8_t * p, unsigned n, unsigned thresh, uint32_t * masks);
+
+struct ZvbiRawSlicer_s {
+    const char *                name;
+    ZvbiRawSlicerMinMax *       minmax;
+    ZvbiRawSlicerThreshold *    threshold;
+    unsigned                    bytes_per_line;
+    unsigned                    job_cnt;
+    ZvbiRawSlicerJob            jobs[ZVBI_RAW_SLICER_SVC_CNT];
+    unsigned                    row_cnt;
+    ZvbiRawSlicerRow            rows[];
+};
+
+// ---------------------------------------------------------------------------
+//  Sample processing kernels
+
+static void
+ZvbiRawSlicer_MinMaxScalar(const uint8_t * p, unsigned n, unsigned * p_min, unsigned * p_max)
+{
+    unsigned min = 0xFF;
+    unsigned max = 0;
+
+    for (unsigned idx = 0; idx < n; ++idx) {
+        if (p[idx] < min)
+            min = p[idx];
+        if (p[idx] > max)
+            max = p[idx];
+    }
+    *p_min = min;
+    *p_max = max;
+}
+
+/*
+ * Set bit (idx % 32) in masks[idx / 32] for each sample above the threshold,
+ * starting at the given sample index, which has to be a multiple of 32.
+ */
+static void
+ZvbiRawSlicer_ThresholdTail(const uint8_t * p, unsigned idx, unsigned n, unsigned thresh, uint32_t * masks)
+{
+    if (idx < n) {
+        memset(&masks[idx / 32], 0, ((n - idx + 31) / 32) * sizeof(uint32_t));
+
+        for ( ; idx < n; ++idx) {
+            if (p[idx] > thresh)
+                masks[idx / 32] |= (uint32_t)1 << (idx % 32);
+        }
+    }
+}
+
+#if !defined (ZVBI_RAW_SLICER_X86)
+static void
+ZvbiRawSlicer_ThresholdScalar(const uint8_t * p, unsigned n, unsigned thresh, uint32_t * masks)
+{
+    ZvbiRawSlicer_ThresholdTail(p, 0, n, thresh, masks);
+}
+#endif
+
+#if defined (ZVBI_RAW_SLICER_X86)
+static void
+ZvbiRawSlicer_MinMaxSse2(const uint8_t * p, unsigned n, unsigned * p_min, unsigned * p_max)
+{
+    __m128i vmin = _mm_set1_epi8((char)0xFF);
+    __m128i vmax = _mm_setzero_si128();
+    unsigned idx = 0;
+
+    for ( ; idx + 16 <= n; idx += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + idx));
+        vmin = _mm_min_epu8(vmin, v);
+        vmax = _mm_max_epu8(vmax, v);
+    }
+    uint8_t lanes[2][16];
+    _mm_storeu_si128((__m128i*)lanes[0], vmin);
+    _mm_storeu_si128((__m128i*)lanes[1], vmax);
+
+    unsigned min, max;
+    ZvbiRawSlicer_MinMaxScalar(p + idx, n - idx, &min, &max);
+    for (unsigned lane = 0; lane < 16; ++lane) {
+        if (lanes[0][lane] < min)
+            min = lanes[0][lane];
+        if (lanes[1][lane] > max)
+            max = lanes[1][lane];
+    }
+    *p_min = min;
+    *p_max = max;
+}
+
+static void
+ZvbiRawSlicer_ThresholdSse2(const uint8_t * p, unsigned n, unsigned thresh, uint32_t * masks)
+{
+    // there is no unsigned byte comparison, so both sides are shifted into signed range
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    const __m128i vthr = _mm_set1_epi8((char)(thresh ^ 0x80));
+    unsigned idx = 0;
+
+    for ( ; idx + 32 <= n; idx += 32) {
+        __m128i v0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + idx)), bias);
+        __m128i v1 = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + idx + 16)), bias);
+        uint32_t lo = _mm_movemask_epi8(_mm_cmpgt_epi8(v0, vthr));
+        uint32_t hi = _mm_movemask_epi8(_mm_cmpgt_epi8(v1, vthr));
+        masks[idx / 32] = lo | (hi << 16);
+    }
+    ZvbiRawSlicer_ThresholdTail(p, idx, n, thresh, masks);
+}
+
+__attribute__((target("avx2")))
+static void
+ZvbiRawSlicer_MinMaxAvx2(const uint8_t * p, unsigned n, unsigned * p_min, unsigned * p_max)
+{
+    __m256i vmin = _mm256_set1_epi8((char)0xFF);
+    __m256i vmax = _mm256_setzero_si256();
+    unsigned idx = 0;
+
+    for ( ; idx + 32 <= n; idx += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + idx));
+        vmin = _mm256_min_epu8(vmin, v);
+        vmax = _mm256_max_epu8(vmax, v);
+    }
+    uint8_t lanes[2][32];
+    _mm256_storeu_si256((__m256i*)lanes[0], vmin);
+    _mm256_storeu_si256((__m256i*)lanes[1], vmax);
+
+    unsigned min, max;
+    ZvbiRawSlicer_MinMaxScalar(p + idx, n - idx, &min, &max);
+    for (unsigned lane = 0; lane < 32; ++lane) {
+        if (lanes[0][lane] < min)
+            min = lanes[0][lane];
+        if (lanes[1][lane] > max)
+            max = lanes[1][lane];
+    }
+    *p_min = min;
+    *p_max = max;
+}
+
+__attribute__((target("avx2")))
+static void
+ZvbiRawSlicer_ThresholdAvx2(const uint8_t * p, unsigned n, unsigned thresh, uint32_t * masks)
+{
+    const __m256i bias = _mm256_set1_epi8((char)0x80);
+    const __m256i vthr = _mm256_set1_epi8((char)(thresh ^ 0x80));
+    unsigned idx = 0;
+
+    for ( ; idx + 32 <= n; idx += 32) {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + idx)), bias);
+        masks[idx / 32] = (uint32_t) _mm256_movemask_epi8(_mm256_cmpgt_epi8(v, vthr));
+    }
+    ZvbiRawSlicer_ThresholdTail(p, idx, n, thresh, masks);
+}
+#endif  /* ZVBI_RAW_SLICER_X86 */
+
+// ---------------------------------------------------------------------------
+//  Slicing
+
+/*
+ * Return the signal level at the given fractional sample position (16.16
+ * fixed point) by linear interpolation; the result is scaled by 2^16.
+ */
+static inline unsigned
+ZvbiRawSlicer_Sample(const uint8_t * p, uint32_t pos)
+{
+    unsigned idx = pos >> 16;
+    unsigned frac = pos & 0xFFFF;
+
+    return p[idx] * (0x10000 - frac) + p[idx + 1] * frac;
+}
+
+/*
+ * Try matching the clock run-in and framing code, starting with the bit
+ * following the edge at the given position. Returns the position of the
+ * first payload bit, or 0 if there is no match.
+ */
+static uint32_t
+ZvbiRawSlicer_MatchCri(const ZvbiRawSlicerJob * job, const uint8_t * p, unsigned bytes_per_line,
+                       unsigned thresh16, uint32_t edge)
+{
+    const ZvbiRawSlicerService * svc = job->svc;
+    uint32_t cri = svc->cri & svc->cri_mask;
+    uint32_t shift = 0;
+    uint32_t pos = edge + job->cri_step / 2;
+
+    for (unsigned idx = 0; idx < svc->cri_bits + ZVBI_RAW_SLICER_CRI_SLACK; ++idx) {
+        if ((pos >> 16) + 1 >= bytes_per_line)
+            break;
+        shift = (shift << 1) | (ZvbiRawSlicer_Sample(p, pos) > thresh16);
+        pos += job->cri_step;
+
+        if ((shift & svc->cri_mask) == cri)
+            return pos - job->cri_step / 2;
+    }
+    return 0;
+}
+
+static void
+ZvbiRawSlicer_Payload(const ZvbiRawSlicerJob * job, const uint8_t * p, unsigned thresh16,
+                      uint32_t start, vbi_sliced * out)
+{
+    const ZvbiRawSlicerService * svc = job->svc;
+
+    memset(out->data, 0, sizeof(out->data));
+
+    for (unsigned idx = 0; idx < svc->payload_bits; ++idx) {
+        uint32_t pos = start + idx * job->bit_step;
+        unsigned bit;
+
+        if (svc->biphase) {
+            // compare the centres of both halves, which is independent of the threshold
+            bit = ZvbiRawSlicer_Sample(p, pos + job->bit_step / 4) >
+                  ZvbiRawSlicer_Sample(p, pos + job->bit_step / 4 * 3);
+        }
+        else {
+            bit = ZvbiRawSlicer_Sample(p, pos + job->bit_step / 2) > thresh16;
+        }
+        if (bit) {
+            if (svc->msb_first)
+                out->data[idx / 8] |= 0x80 >> (idx % 8);
+            else
+                out->data[idx / 8] |= 1 << (idx % 8);
+        }
+    }
+    out->id = svc->id;
+}
+
+/*
+ * Search for the given service in one line of raw data. The threshold
+ * between low and high level is derived from the range of levels in the
+ * line. Rising edges are candidates for the start of the clock run-in;
+ * the precise position of an edge is interpolated from the adjacent
+ * samples, which determines the phase for sampling the following bits.
+ */
+static vbi_bool
+ZvbiRawSlicer_Line(const ZvbiRawSlicer * slicer, const ZvbiRawSlicerJob * job, const uint8_t * p,
+                   vbi_sliced * out)
+{
+    const ZvbiRawSlicerService * svc = job->svc;
+    unsigned bytes_per_line = slicer->bytes_per_line;
+    unsigned min, max;
+
+    slicer->minmax(p + job->win_start, bytes_per_line - job->win_start, &min, &max);
+    if (max - min < ZVBI_RAW_SLICER_MIN_AMPLITUDE)
+        return FALSE;
+
+    unsigned thresh = (min + max + 1) / 2;
+    unsigned thresh16 = thresh << 16;
+    uint32_t end = job->bit_step * (svc->payload_bits + 1);
+    uint32_t masks[ZVBI_RAW_SLICER_MAX_WIN / 32 + 2];
+    unsigned first = job->win_start - 1;
+    unsigned n = job->win_end - first;
+
+    // bit k of the mask sequence is set when sample "first + k" is above the threshold
+    slicer->threshold(p + first, n, thresh, masks);
+
+    uint32_t prev = 1;
+    for (unsigned word = 0; word < (n + 31) / 32; ++word) {
+        uint32_t rise = masks[word] & ~((masks[word] << 1) | prev);
+        prev = masks[word] >> 31;
+
+        while (rise != 0) {
+            unsigned idx = first + word * 32 + __builtin_ctz(rise);
+            rise &= rise - 1;
+
+            unsigned lo = p[idx - 1];
+            unsigned hi = p[idx];
+            uint32_t edge = ((idx - 1) << 16) + (((thresh - lo) << 16) / (hi - lo));
+            uint32_t start = ZvbiRawSlicer_MatchCri(job, p, bytes_per_line, thresh16, edge);
+
+            if ((start != 0) && (((start + end) >> 16) + 1 < bytes_per_line)) {
+                ZvbiRawSlicer_Payload(job, p, thresh16, start, out);
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+unsigned
+ZvbiRawSlicer_Decode(const ZvbiRawSlicer * slicer, const uint8_t * raw, vbi_sliced * out)
+{
+    unsigned n_lines = 0;
+
+    for (unsigned row = 0; row < slicer->row_cnt; ++row) {
+        const ZvbiRawSlicerRow * p_row = &slicer->rows[row];
+
+        for (unsigned idx = 0; idx < slicer->job_cnt; ++idx) {
+            if ((p_row->jobs & (1 << idx)) &&
+                ZvbiRawSlicer_Line(slicer, &slicer->jobs[idx], raw + p_row->offset, &out[n_lines]))
+            {
+                out[n_lines].line = p_row->line;
+                n_lines += 1;
+                break;
+            }
+        }
+    }
+    return n_lines;
+}
+
+// ---------------------------------------------------------------------------
+//  Set-up
+
+/*
+ * Check if the slicer can be used for the given parameters and services
+ * instead of vbi_raw_decode().
+ */
+vbi_bool
+ZvbiRawSlicer_Supports(const vbi_raw_decoder * rd)
+{
+    if ((rd->scanning != 625) ||
+        (rd->sampling_format != VBI_PIXFMT_YUV420) ||
+        (rd->bytes_per_line < 2) || (rd->bytes_per_line > 0x7FFF) ||
+        (rd->count[0] + rd->count[1] == 0) ||
+        (rd->count[0] < 0) || (rd->count[1] < 0) ||
+        (rd->services == 0) ||
+        ((rd->services & ~ZVBI_RAW_SLICER_SERVICES) != 0))
+    {
+        return FALSE;
+    }
+    for (unsigned idx = 0; idx < ZVBI_RAW_SLICER_SVC_CNT; ++idx) {
+        const ZvbiRawSlicerService * svc = &ZvbiRawSlicer_Services[idx];
+
+        // interpolation requires at least 1.5 samples per bit
+        if ((rd->services & svc->id) && ((double)rd->sampling_rate * 2 < (double)svc->cri_rate * 3))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static unsigned
+ZvbiRawSlicer_NsToSample(const vbi_raw_decoder * rd, long ns)
+{
+    long idx = (long)(((int64_t)ns * rd->sampling_rate + 500000000) / 1000000000) - rd->offset;
+
+    if (idx < 1)
+        return 1;
+    if (idx >= rd->bytes_per_line)
+        return rd->bytes_per_line - 1;
+    return idx;
+}
+
+/*
+ * Create a slicer for the given parameters, which have to be accepted by
+ * ZvbiRawSlicer_Supports(). Returns NULL and raises an exception upon error.
+ */
+ZvbiRawSlicer *
+ZvbiRawSlicer_New(const vbi_raw_decoder * rd)
+{
+    unsigned row_cnt = rd->count[0] + rd->count[1];
+    ZvbiRawSlicer * slicer = PyMem_Malloc(sizeof(ZvbiRawSlicer) + row_cnt * sizeof(ZvbiRawSlicerRow));
+
+    if (slicer == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+#if defined (ZVBI_RAW_SLICER_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        slicer->name = "avx2";
+        slicer->minmax = ZvbiRawSlicer_MinMaxAvx2;
+        slicer->threshold = ZvbiRawSlicer_ThresholdAvx2;
+    }
+    else {
+        slicer->name = "sse2";
+        slicer->minmax = ZvbiRawSlicer_MinMaxSse2;
+        slicer->threshold = ZvbiRawSlicer_ThresholdSse2;
+    }
+#else
+    slicer->name = "scalar";
+    slicer->minmax = ZvbiRawSlicer_MinMaxScalar;
+    slicer->threshold = ZvbiRawSlicer_ThresholdScalar;
+#endif
+    slicer->bytes_per_line = rd->bytes_per_line;
+
+    slicer->job_cnt = 0;
+    for (unsigned idx = 0; idx < ZVBI_RAW_SLICER_SVC_CNT; ++idx) {
+        const ZvbiRawSlicerService * svc = &ZvbiRawSlicer_Services[idx];
+
+        if (rd->services & svc->id) {
+            ZvbiRawSlicerJob * job = &slicer->jobs[slicer->job_cnt++];
+
+            job->svc = svc;
+            job->cri_step = ((uint64_t)rd->sampling_rate << 16) / svc->cri_rate;
+            job->bit_step = ((uint64_t)rd->sampling_rate << 16) / svc->bit_rate;
+            job->win_start = ZvbiRawSlicer_NsToSample(rd, (long)svc->offset_ns - ZVBI_RAW_SLICER_EARLY_NS);
+            job->win_end = ZvbiRawSlicer_NsToSample(rd, (long)svc->offset_ns + ZVBI_RAW_SLICER_LATE_NS);
+            if (job->win_end - job->win_start > ZVBI_RAW_SLICER_MAX_WIN)
+                job->win_end = job->win_start + ZVBI_RAW_SLICER_MAX_WIN;
+        }
+    }
+
+    slicer->row_cnt = row_cnt;
+    for (unsigned field = 0; field < 2; ++field) {
+        for (unsigned idx = 0; idx < (unsigned)rd->count[field]; ++idx) {
+            unsigned row = field * rd->count[0] + idx;
+            ZvbiRawSlicerRow * p_row = &slicer->rows[row];
+
+            if (rd->interlaced)
+                p_row->offset = (idx * 2 + field) * rd->bytes_per_line;
+            else
+                p_row->offset = row * rd->bytes_per_line;
+
+            p_row->line = (rd->start[field] > 0) ? (rd->start[field] + idx) : 0;
+
+            // without line numbers, all services are searched in all lines
+            p_row->jobs = 0;
+            for (unsigned job = 0; job < slicer->job_cnt; ++job) {
+                const ZvbiRawSlicerService * svc = slicer->jobs[job].svc;
+
+                if ((p_row->line == 0) ||
+                    ((svc->first[field] != 0) &&
+                     (p_row->line >= svc->first[field]) && (p_row->line <= svc->last[field])))
+                {
+                    p_row->jobs |= 1 << job;
+                }
+            }
+        }
+    }
+    return slicer;
+}
+
+void
+ZvbiRawSlicer_Free(ZvbiRawSlicer * slicer)
+{
+    PyMem_Free(slicer);
+}
+
+/*
+ * Return the name of the sample processing kernel in use.
+ */
+const char *
+ZvbiRawSlicer_Name(const ZvbiRawSlicer * slicer)
+{
+    return slicer->name;
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#if !defined (_PY_ZVBI_RAW_SLICER_H)
+#define _PY_ZVBI_RAW_SLICER_H
+
+typedef struct ZvbiRawSlicer_s ZvbiRawSlicer;
+
+vbi_bool ZvbiRawSlicer_Supports(const vbi_raw_decoder * rd);
+ZvbiRawSlicer * ZvbiRawSlicer_New(const vbi_raw_decoder * rd);
+void ZvbiRawSlicer_Free(ZvbiRawSlicer * slicer);
+unsigned ZvbiRawSlicer_Decode(const ZvbiRawSlicer * slicer, const uint8_t * raw, vbi_sliced * out);
+const char * ZvbiRawSlicer_Name(const ZvbiRawSlicer * slicer);
+
+#endif  /* _PY_ZVBI_RAW_SLICER_H */
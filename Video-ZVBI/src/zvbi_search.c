@@ -30,18 +30,27 @@ typedef struct {
     PyObject_HEAD
     vbi_search * ctx;
     int direction;
+    int temp_page_seq_no;   // validity of page objects, see below
+    PyObject * progress;
+    PyObject * user_data;
 } ZvbiSearchObj;
 
 static PyObject * ZvbiSearchError;
 
 /*
- * This counter is used for limiting the life-time of page objects that refer
- * to static storage in the libzvbi library. The object encapsulates a copy of
- * the counter at the time of duration. The counter is incremented for any
- * operation that invalidates the page content. Access to the object is
- * rejected via exception when the counter no longer matches the object.
+ * The search progress callback does not support user data, so the search
+ * object is passed via thread-specific storage during vbi_search_next().
+ */
+static Py_tss_t ZvbiSearch_ActiveKey = Py_tss_NEEDS_INIT;
+
+/*
+ * Member "temp_page_seq_no" is used for limiting the life-time of page objects
+ * that refer to static storage in the libzvbi library. The object encapsulates
+ * a copy of the counter at the time of creation, plus a reference to the
+ * search object. The counter is incremented for any operation that invalidates
+ * the page content of the respective search. Access to the object is rejected
+ * via exception when the counter no longer matches the object.
  */
-static int ZvbiSearch_TempPageSeqNo;
 
 // ---------------------------------------------------------------------------
 
@@ -50,23 +59,19 @@ static int ZvbiSearch_TempPageSeqNo;
  * Callback can return FALSE to abort the search.
  */
 static int
-zvbi_xs_search_progress( vbi_page * p_pg, unsigned cb_idx )
+zvbi_xs_search_progress( vbi_page * p_pg )
 {
-    PyObject * cb_obj;
+    ZvbiSearchObj * self = PyThread_tss_get(&ZvbiSearch_ActiveKey);
     int result = FALSE;
 
-    if ( (cb_idx < ZVBI_MAX_CB_COUNT) &&
-         ((cb_obj = ZvbiCallbacks.search[cb_idx].p_cb) != NULL) )
-    {
+    if ((self != NULL) && (self->progress != NULL)) {
         // invalidate wrapper object returned by previous callbacks or search results
-        ZvbiSearch_TempPageSeqNo++;
+        self->temp_page_seq_no++;
 
-        PyObject * pg_obj = ZvbiPage_NewTemporary(p_pg, &ZvbiSearch_TempPageSeqNo);
+        PyObject * pg_obj = ZvbiPage_NewTemporary(p_pg, (PyObject *) self, &self->temp_page_seq_no);
         if (pg_obj != NULL) {
-            PyObject * user_data = ZvbiCallbacks.search[cb_idx].p_data;
-
             // invoke the Python subroutine
-            PyObject * cb_rslt = PyObject_CallFunctionObjArgs(cb_obj, pg_obj, user_data, NULL);
+            PyObject * cb_rslt = PyObject_CallFunctionObjArgs(self->progress, pg_obj, self->user_data, NULL);
 
             // evaluate the result returned by the function
             if (cb_rslt != NULL) {
@@ -76,7 +81,7 @@ zvbi_xs_search_progress( vbi_page * p_pg, unsigned cb_idx )
             Py_DECREF(pg_obj);
 
             // invalidate page wrapper object: life-time of page is duration of callback only
-            ZvbiSearch_TempPageSeqNo++;
+            self->temp_page_seq_no++;
         }
 
         // clear exceptions as we cannot handle them here
@@ -87,38 +92,6 @@ zvbi_xs_search_progress( vbi_page * p_pg, unsigned cb_idx )
     return result;
 }
 
-/*
- * The search callbacks don't support user data, so instead of passing an
- * array index through, the index is resurrected by using different functions.
- */
-static int zvbi_xs_search_progress_0( vbi_page * p_pg ) { return zvbi_xs_search_progress(p_pg, 0); }
-static int zvbi_xs_search_progress_1( vbi_page * p_pg ) { return zvbi_xs_search_progress(p_pg, 1); }
-static int zvbi_xs_search_progress_2( vbi_page * p_pg ) { return zvbi_xs_search_progress(p_pg, 2); }
-static int zvbi_xs_search_progress_3( vbi_page * p_pg ) { return zvbi_xs_search_progress(p_pg, 3); }
-static int zvbi_xs_search_progress_4( vbi_page * p_pg ) { return zvbi_xs_search_progress(p_pg, 4); }
-static int zvbi_xs_search_progress_5( vbi_page * p_pg ) { return zvbi_xs_search_progress(p_pg, 5); }
-static int zvbi_xs_search_progress_6( vbi_page * p_pg ) { return zvbi_xs_search_progress(p_pg, 6); }
-static int zvbi_xs_search_progress_7( vbi_page * p_pg ) { return zvbi_xs_search_progress(p_pg, 7); }
-static int zvbi_xs_search_progress_8( vbi_page * p_pg ) { return zvbi_xs_search_progress(p_pg, 8); }
-static int zvbi_xs_search_progress_9( vbi_page * p_pg ) { return zvbi_xs_search_progress(p_pg, 9); }
-
-static int (* const zvbi_xs_search_cb_list[ZVBI_MAX_CB_COUNT])( vbi_page * pg ) =
-{
-    zvbi_xs_search_progress_0,
-    zvbi_xs_search_progress_1,
-    zvbi_xs_search_progress_2,
-    zvbi_xs_search_progress_3,
-    zvbi_xs_search_progress_4,
-    zvbi_xs_search_progress_5,
-    zvbi_xs_search_progress_6,
-    zvbi_xs_search_progress_7,
-    zvbi_xs_search_progress_8,
-    zvbi_xs_search_progress_9,
-};
-#if (ZVBI_MAX_CB_COUNT) != 10
-#error "Search progress callback function list length mismatch"
-#endif
-
 // ---------------------------------------------------------------------------
 
 static PyObject *
@@ -133,7 +106,8 @@ ZvbiSearch_dealloc(ZvbiSearchObj *self)
     if (self->ctx) {
         vbi_search_delete(self->ctx);
     }
-    ZvbiCallbacks_free_by_obj(ZvbiCallbacks.search, self);
+    Py_XDECREF(self->progress);
+    Py_XDECREF(self->user_data);
 
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
@@ -159,7 +133,10 @@ ZvbiSearch_init(ZvbiSearchObj *self, PyObject *args, PyObject *kwds)
     if (self->ctx) {
         vbi_search_delete(self->ctx);
         self->ctx = NULL;
+        self->temp_page_seq_no++;
     }
+    Py_CLEAR(self->progress);
+    Py_CLEAR(self->user_data);
 
     if (PyArg_ParseTupleAndKeywords(args, kwds, "O!U|ii$ppIOO", kwlist,
                                     &ZvbiServiceDecTypeDef, &dec_obj, &pattern_obj,
@@ -192,34 +169,21 @@ ZvbiSearch_init(ZvbiSearchObj *self, PyObject *args, PyObject *kwds)
                 *p = 0;
 
                 // invalidate wrapper object returned by previous search results
-                ZvbiSearch_TempPageSeqNo++;
-
-                if (progress == NULL) {
-                    self->ctx = vbi_search_new(dec, pgno, subno, ucs2, casefold, regexp, NULL);
-                    if (self->ctx != NULL) {
-                        RETVAL = 0;
-                    }
-                    else {
-                        PyErr_SetString(ZvbiSearchError, "failed to create search object");
+                self->temp_page_seq_no++;
+
+                self->ctx = vbi_search_new(dec, pgno, subno, ucs2, casefold, regexp,
+                                           ((progress != NULL) ? zvbi_xs_search_progress : NULL));
+                if (self->ctx != NULL) {
+                    if (progress != NULL) {
+                        Py_INCREF(progress);
+                        Py_XINCREF(user_data);
+                        self->progress = progress;
+                        self->user_data = user_data;
                     }
+                    RETVAL = 0;
                 }
                 else {
-                    unsigned cb_idx = ZvbiCallbacks_alloc(ZvbiCallbacks.search, progress, user_data, self);
-                    if (cb_idx < ZVBI_MAX_CB_COUNT) {
-                        self->ctx = vbi_search_new(dec, pgno, subno, ucs2, casefold, regexp,
-                                                   zvbi_xs_search_cb_list[cb_idx]);
-
-                        if (self->ctx != NULL) {
-                            RETVAL = 0;
-                        }
-                        else {
-                            PyErr_SetString(ZvbiSearchError, "failed to create search object");
-                            ZvbiCallbacks_free_by_idx(ZvbiCallbacks.search, cb_idx);
-                        }
-                    }
-                    else {
-                        PyErr_SetString(ZvbiSearchError, "Max. search callback count exceeded");
-                    }
+                    PyErr_SetString(ZvbiSearchError, "failed to create search object");
                 }
                 PyMem_RawFree(ucs2);
             }
@@ -244,13 +208,21 @@ ZvbiSearch_IterNext(ZvbiSearchObj *self)
     PyObject * RETVAL = NULL;
 
     // invalidate wrapper object returned by previous search results
-    ZvbiSearch_TempPageSeqNo++;
+    self->temp_page_seq_no++;
 
     vbi_page * page = NULL;
+
+    // make the search object available to the progress callback; the previous
+    // value is restored for supporting searches nested within the callback
+    void * prev_active = PyThread_tss_get(&ZvbiSearch_ActiveKey);
+    PyThread_tss_set(&ZvbiSearch_ActiveKey, self);
+
     int st = vbi_search_next(self->ctx, &page, self->direction);
 
+    PyThread_tss_set(&ZvbiSearch_ActiveKey, prev_active);
+
     if ((st == VBI_SEARCH_SUCCESS) && (page != NULL)) {
-        RETVAL = ZvbiPage_NewTemporary(page, &ZvbiSearch_TempPageSeqNo);
+        RETVAL = ZvbiPage_NewTemporary(page, (PyObject *) self, &self->temp_page_seq_no);
     }
     else if (st == VBI_SEARCH_NOT_FOUND) {
         PyErr_SetString(PyExc_StopIteration, "no page found");
@@ -298,6 +270,12 @@ int PyInit_Search(PyObject * module, PyObject * error_base)
     if (PyType_Ready(&ZvbiSearchTypeDef) < 0) {
         return -1;
     }
+    if (!PyThread_tss_is_created(&ZvbiSearch_ActiveKey) &&
+        (PyThread_tss_create(&ZvbiSearch_ActiveKey) != 0))
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Failed to create thread-specific storage key");
+        return -1;
+    }
 
     // create exception class
     ZvbiSearchError = PyErr_NewException("Zvbi.SearchError", error_base, NULL);
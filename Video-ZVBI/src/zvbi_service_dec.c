@@ -21,17 +21,89 @@
 #include "zvbi_page.h"
 #include "zvbi_event_types.h"
 #include "zvbi_capture_buf.h"
+#include "zvbi_compact_sliced_buf.h"
 #include "zvbi_callbacks.h"
 
 // ---------------------------------------------------------------------------
 
+/*
+ * Copy of an event reported by the decoder while the GIL is released, for
+ * delivery to the Python handler after decoding. Data referenced by the
+ * event is copied too, as it is valid only during the callback.
+ */
+typedef struct {
+    vbi_event           event;
+    struct ZvbiServiceDecHandler_s * handler;   // NULL for polled events
+    union {
+        uint8_t             raw_header[40];
+        vbi_link            link;
+        vbi_program_info    prog_info;
+    } data;
+} ZvbiServiceDecEvent;
+
+/*
+ * Filter for TTX_PAGE events, applied before events are converted for Python:
+ * Bitmap of page numbers matching any sub-page, plus a list of page and
+ * sub-page number pairs.
+ */
+#define ZVBI_PAGE_FILTER_PGNO_COUNT 0x900
+
+typedef struct {
+    uint8_t     pgno_map[ZVBI_PAGE_FILTER_PGNO_COUNT / 8];
+    unsigned    sub_count;
+    struct {
+        vbi_pgno    pgno;
+        vbi_subno   subno;
+    }           sub[];
+} ZvbiServiceDecPageFilter;
+
 typedef struct {
+    ZvbiServiceDecEvent * p_ev;
+    unsigned len;
+    unsigned size;
+    unsigned limit;                     // maximum number of queued events, or 0 if unlimited
+    unsigned lost;                      // number of events dropped due to memory shortage or limit
+} ZvbiServiceDecEvQueue;
+
+typedef struct ZvbiServiceDecObj_s ZvbiServiceDecObj;
+
+/*
+ * Python event handler registered with the decoder. The address of this
+ * structure is passed to libzvbi as user data, so that no lookup is needed
+ * for dispatching events.
+ */
+typedef struct ZvbiServiceDecHandler_s {
+    ZvbiServiceDecObj * self;
+    PyObject *          p_cb;
+    PyObject *          p_data;
+    ZvbiServiceDecPageFilter * filter;
+    vbi_bool            removed;        // unregistered while queued events are delivered
+    struct ZvbiServiceDecHandler_s * next_removed;
+} ZvbiServiceDecHandler;
+
+struct ZvbiServiceDecObj_s {
     PyObject_HEAD
     vbi_decoder * ctx;
-} ZvbiServiceDecObj;
+    ZvbiServiceDecHandler ** handlers;  // registered event handlers, in registration order
+    unsigned handler_count;
+    unsigned handler_size;
+    unsigned deliver_depth;             // nesting level of delivering queued events
+    ZvbiServiceDecHandler * removed_handlers;  // released when delivery is complete
+    vbi_bool defer_events;              // decode without GIL and deliver events afterward
+    vbi_bool busy;                      // TRUE while decoding with the GIL released
+    ZvbiServiceDecEvQueue ev_queue;     // events collected while decoding
+    ZvbiServiceDecEvQueue poll_queue;   // events collected for poll_events()
+    int poll_mask;                      // event types registered for polling
+    ZvbiServiceDecPageFilter * poll_filter;
+};
 
 static PyObject * ZvbiServiceDecError;
 
+// initial number of elements in the event queue; the queue grows as needed
+#define ZVBI_SERVICE_DEC_EV_QUEUE_SIZE 16
+// maximum number of events queued for poll_events()
+#define ZVBI_SERVICE_DEC_POLL_QUEUE_MAX 4096
+
 // ---------------------------------------------------------------------------
 
 vbi_decoder *
@@ -52,28 +124,114 @@ ZvbiServiceDec_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
     return type->tp_alloc(type, 0);
 }
 
+static void
+ZvbiServiceDec_FreeHandler(ZvbiServiceDecHandler * handler)
+{
+    Py_DECREF(handler->p_cb);
+    Py_XDECREF(handler->p_data);
+    PyMem_Free(handler->filter);
+    PyMem_Free(handler);
+}
+
+/*
+ * Release a handler that is no longer registered. While queued events are
+ * delivered, the handler is only marked as removed, as the queue may still
+ * refer to it; it is then released after delivery is complete.
+ */
+static void
+ZvbiServiceDec_ReleaseHandler(ZvbiServiceDecObj * self, ZvbiServiceDecHandler * handler)
+{
+    if (self->deliver_depth > 0) {
+        handler->removed = TRUE;
+        handler->next_removed = self->removed_handlers;
+        self->removed_handlers = handler;
+    }
+    else {
+        ZvbiServiceDec_FreeHandler(handler);
+    }
+}
+
+static void
+ZvbiServiceDec_FreeRemovedHandlers(ZvbiServiceDecObj * self)
+{
+    while (self->removed_handlers != NULL) {
+        ZvbiServiceDecHandler * handler = self->removed_handlers;
+        self->removed_handlers = handler->next_removed;
+        ZvbiServiceDec_FreeHandler(handler);
+    }
+}
+
+/*
+ * Release all event handlers. This is used only after the decoder context
+ * was deleted, so handlers need not be unregistered from it.
+ */
+static void
+ZvbiServiceDec_FreeHandlers(ZvbiServiceDecObj * self)
+{
+    for (unsigned idx = 0; idx < self->handler_count; ++idx) {
+        ZvbiServiceDec_ReleaseHandler(self, self->handlers[idx]);
+    }
+    PyMem_Free(self->handlers);
+    self->handlers = NULL;
+    self->handler_count = 0;
+    self->handler_size = 0;
+}
+
 static void
 ZvbiServiceDec_dealloc(ZvbiServiceDecObj *self)
 {
     if (self->ctx) {
         vbi_decoder_delete(self->ctx);
     }
+    ZvbiServiceDec_FreeHandlers(self);
+    ZvbiServiceDec_FreeRemovedHandlers(self);
+    PyMem_RawFree(self->ev_queue.p_ev);
+    PyMem_RawFree(self->poll_queue.p_ev);
+    PyMem_Free(self->poll_filter);
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
+/*
+ * In mode "defer_events" the decoder context is used with the GIL released,
+ * so other threads have to be prevented from using it meanwhile in ways
+ * which may generate events.
+ */
+static vbi_bool
+ZvbiServiceDec_CheckIdle(ZvbiServiceDecObj * self)
+{
+    if (self->busy) {
+        PyErr_SetString(ZvbiServiceDecError, "ServiceDec is in use by another thread");
+        return FALSE;
+    }
+    return TRUE;
+}
+
 static int
 ZvbiServiceDec_init(ZvbiServiceDecObj *self, PyObject *args, PyObject *kwds)
 {
-    static char * kwlist[] = {NULL};
+    static char * kwlist[] = {"defer_events", NULL};
+    int defer_events = FALSE;
     int RETVAL = -1;
 
+    if (!ZvbiServiceDec_CheckIdle(self)) {
+        return -1;
+    }
+
     // reset state in case the module is already initialized
     if (self->ctx) {
         vbi_decoder_delete(self->ctx);
         self->ctx = NULL;
     }
+    ZvbiServiceDec_FreeHandlers(self);
+    self->poll_queue.len = 0;
+    self->poll_queue.limit = ZVBI_SERVICE_DEC_POLL_QUEUE_MAX;
+    self->poll_queue.lost = 0;
+    self->poll_mask = 0;
+    PyMem_Free(self->poll_filter);
+    self->poll_filter = NULL;
 
-    if (PyArg_ParseTupleAndKeywords(args, kwds, "", kwlist)) {
+    if (PyArg_ParseTupleAndKeywords(args, kwds, "|$p", kwlist, &defer_events)) {
+        self->defer_events = defer_events;
         self->ctx = vbi_decoder_new();
 
         if (self->ctx != NULL) {
@@ -90,26 +248,95 @@ ZvbiServiceDec_init(ZvbiServiceDecObj *self, PyObject *args, PyObject *kwds)
 //  Teletext Page De-Multiplexing & Caching
 // ---------------------------------------------------------------------------
 
+static vbi_bool ZvbiServiceDec_DeliverEvents(ZvbiServiceDecObj * self);
+
+/*
+ * Sliced data of one video frame, as passed to vbi_decode()
+ */
+typedef struct {
+    vbi_sliced *    p_sliced;
+    int             n_lines;
+    double          timestamp;
+} ZvbiServiceDecFrame;
+
+/*
+ * Feed the given frames into the decoder. In mode "defer_events" the GIL
+ * is released meanwhile and events of all frames are delivered afterward.
+ * Returns FALSE and raises an exception upon error.
+ */
+static vbi_bool
+ZvbiServiceDec_Decode(ZvbiServiceDecObj * self, const ZvbiServiceDecFrame * frames, unsigned count)
+{
+    if (!self->defer_events) {
+        for (unsigned idx = 0; idx < count; ++idx) {
+            vbi_decode(self->ctx, frames[idx].p_sliced, frames[idx].n_lines, frames[idx].timestamp);
+        }
+        return TRUE;
+    }
+    if (!ZvbiServiceDec_CheckIdle(self)) {
+        return FALSE;
+    }
+    self->busy = TRUE;
+    Py_BEGIN_ALLOW_THREADS
+    for (unsigned idx = 0; idx < count; ++idx) {
+        vbi_decode(self->ctx, frames[idx].p_sliced, frames[idx].n_lines, frames[idx].timestamp);
+    }
+    Py_END_ALLOW_THREADS
+    self->busy = FALSE;
+
+    return ZvbiServiceDec_DeliverEvents(self);
+}
+
+/*
+ * Get the storage of the given sliced buffer object for decoding. In mode
+ * "defer_events", buffers returned by "pull" are detached from storage of
+ * the capture context first: The export taken by the caller only prevents
+ * refilling buffers created via the constructor, whereas another thread may
+ * pull the next frame into the storage of the capture context while the
+ * GIL is released. Raises an exception upon error.
+ */
+static vbi_capture_buffer *
+ZvbiServiceDec_GetFrameBuf(ZvbiServiceDecObj * self, PyObject * sliced_obj)
+{
+    if (self->defer_events && !ZvbiCaptureBuf_Detach(sliced_obj)) {
+        return NULL;
+    }
+    return ZvbiCaptureBuf_GetBuf(sliced_obj);
+}
+
 static PyObject *
 ZvbiServiceDec_decode(ZvbiServiceDecObj *self, PyObject *args)
 {
     PyObject * sliced_obj;
     PyObject * RETVAL = NULL;
 
-    if (PyArg_ParseTuple(args, "O!", &ZvbiCaptureSlicedBufTypeDef, &sliced_obj)) {
-        vbi_capture_buffer * sliced_buffer = ZvbiCaptureBuf_GetBuf(sliced_obj);
-        if ((sliced_buffer != NULL) && (sliced_buffer->data != NULL)) {
-            vbi_sliced * p_sliced = sliced_buffer->data;
-            int n_lines = sliced_buffer->size / sizeof(vbi_sliced);
+    if (PyArg_ParseTuple(args, "O&", ZvbiCompactSlicedBuf_Converter, &sliced_obj)) {
+        vbi_capture_buffer * sliced_buffer = ZvbiServiceDec_GetFrameBuf(self, sliced_obj);
+        if (PyErr_Occurred()) {
+            // buffer is invalid or could not be detached
+        }
+        else if ((sliced_buffer != NULL) && (sliced_buffer->data != NULL)) {
+            ZvbiServiceDecFrame frame;
+            Py_buffer view;
+
+            frame.p_sliced = sliced_buffer->data;
             // note "size" of CaptureSlicedBuf is calculated from "n_lines" result of slicer
+            frame.n_lines = sliced_buffer->size / sizeof(vbi_sliced);
+            frame.timestamp = sliced_buffer->timestamp;
 
-            vbi_decode(self->ctx, p_sliced, n_lines, sliced_buffer->timestamp);
-            Py_INCREF(Py_None);
-            RETVAL = Py_None;
+            // keep an export on the buffer, so that it cannot be refilled while the GIL is released
+            if (PyObject_GetBuffer(sliced_obj, &view, PyBUF_SIMPLE) == 0) {
+                if (ZvbiServiceDec_Decode(self, &frame, 1)) {
+                    Py_INCREF(Py_None);
+                    RETVAL = Py_None;
+                }
+                PyBuffer_Release(&view);
+            }
         }
         else {
             PyErr_SetString(PyExc_ValueError, "Sliced capture buffer contains no data");
         }
+        Py_DECREF(sliced_obj);
     }
     return RETVAL;
 }
@@ -118,15 +345,28 @@ static PyObject *
 ZvbiServiceDec_decode_bytes(ZvbiServiceDecObj *self, PyObject *args)
 {
     PyObject * RETVAL = NULL;
+    PyObject * in_obj;
     Py_buffer in_buf;
     unsigned n_lines;
     double timestamp;
 
-    if (PyArg_ParseTuple(args, "y*Id", &in_buf, &n_lines, &timestamp)) {
+    if (!PyArg_ParseTuple(args, "OId", &in_obj, &n_lines, &timestamp)) {
+        return NULL;
+    }
+    // see ZvbiServiceDec_GetFrameBuf()
+    if (self->defer_events && PyObject_TypeCheck(in_obj, &ZvbiCaptureSlicedBufTypeDef) &&
+        !ZvbiCaptureBuf_Detach(in_obj))
+    {
+        return NULL;
+    }
+    if (PyObject_GetBuffer(in_obj, &in_buf, PyBUF_SIMPLE) == 0) {
         if (n_lines <= in_buf.len / sizeof(vbi_sliced)) {
-            vbi_decode(self->ctx, (vbi_sliced*)in_buf.buf, n_lines, timestamp);
-            Py_INCREF(Py_None);
-            RETVAL = Py_None;
+            ZvbiServiceDecFrame frame = { (vbi_sliced*)in_buf.buf, n_lines, timestamp };
+
+            if (ZvbiServiceDec_Decode(self, &frame, 1)) {
+                Py_INCREF(Py_None);
+                RETVAL = Py_None;
+            }
         }
         else {
             PyErr_SetString(PyExc_ValueError, "Buffer too short for given number of lines");
@@ -136,13 +376,167 @@ ZvbiServiceDec_decode_bytes(ZvbiServiceDecObj *self, PyObject *args)
     return RETVAL;
 }
 
+/*
+ * Decode a sequence of sliced buffer objects, each containing one frame
+ */
+static PyObject *
+ZvbiServiceDec_DecodeSeq(ZvbiServiceDecObj * self, PyObject * frames_obj)
+{
+    PyObject * RETVAL = NULL;
+    PyObject * seq = PySequence_Fast(frames_obj, "Expected a sequence of sliced buffers");
+
+    if (seq != NULL) {
+        Py_ssize_t count = PySequence_Fast_GET_SIZE(seq);
+        ZvbiServiceDecFrame * frames = PyMem_Malloc((count + 1) * sizeof(ZvbiServiceDecFrame));
+        PyObject ** bufs = PyMem_Malloc((count + 1) * sizeof(PyObject *));
+        Py_buffer * views = PyMem_Malloc((count + 1) * sizeof(Py_buffer));
+        Py_ssize_t n_ok = 0;
+
+        if ((frames != NULL) && (bufs != NULL) && (views != NULL)) {
+            for (Py_ssize_t idx = 0; idx < count; ++idx) {
+                if (!ZvbiCompactSlicedBuf_Converter(PySequence_Fast_GET_ITEM(seq, idx), &bufs[idx])) {
+                    break;
+                }
+                vbi_capture_buffer * sliced_buffer = ZvbiServiceDec_GetFrameBuf(self, bufs[idx]);
+                if (PyErr_Occurred() || (sliced_buffer == NULL) || (sliced_buffer->data == NULL)) {
+                    if (!PyErr_Occurred()) {
+                        PyErr_Format(PyExc_ValueError, "Sliced capture buffer at index %zd contains no data", idx);
+                    }
+                    Py_DECREF(bufs[idx]);
+                    break;
+                }
+                // keep an export on each buffer, so that it cannot be refilled while the GIL is released
+                if (PyObject_GetBuffer(bufs[idx], &views[idx], PyBUF_SIMPLE) != 0) {
+                    Py_DECREF(bufs[idx]);
+                    break;
+                }
+                frames[idx].p_sliced = sliced_buffer->data;
+                frames[idx].n_lines = sliced_buffer->size / sizeof(vbi_sliced);
+                frames[idx].timestamp = sliced_buffer->timestamp;
+                n_ok += 1;
+            }
+            if ((n_ok == count) && ZvbiServiceDec_Decode(self, frames, count)) {
+                Py_INCREF(Py_None);
+                RETVAL = Py_None;
+            }
+            for (Py_ssize_t idx = 0; idx < n_ok; ++idx) {
+                PyBuffer_Release(&views[idx]);
+                Py_DECREF(bufs[idx]);
+            }
+        }
+        else {
+            PyErr_NoMemory();
+        }
+        PyMem_Free(frames);
+        PyMem_Free(bufs);
+        PyMem_Free(views);
+        Py_DECREF(seq);
+    }
+    return RETVAL;
+}
+
+/*
+ * Decode a contiguous block of sliced lines of multiple frames, split into
+ * frames according to the given sequences of line counts and timestamps
+ */
+static PyObject *
+ZvbiServiceDec_DecodeBlock(ZvbiServiceDecObj * self, PyObject * block_obj,
+                           PyObject * n_lines_obj, PyObject * timestamps_obj)
+{
+    PyObject * RETVAL = NULL;
+    PyObject * n_lines_seq = NULL;
+    PyObject * timestamps_seq = NULL;
+    Py_buffer in_buf;
+
+    // see ZvbiServiceDec_GetFrameBuf()
+    if (self->defer_events && PyObject_TypeCheck(block_obj, &ZvbiCaptureSlicedBufTypeDef) &&
+        !ZvbiCaptureBuf_Detach(block_obj))
+    {
+        return NULL;
+    }
+    if (PyObject_GetBuffer(block_obj, &in_buf, PyBUF_SIMPLE) == 0) {
+        if (((n_lines_seq = PySequence_Fast(n_lines_obj, "n_lines must be a sequence of line counts")) != NULL) &&
+            ((timestamps_seq = PySequence_Fast(timestamps_obj, "timestamps must be a sequence of float")) != NULL))
+        {
+            Py_ssize_t count = PySequence_Fast_GET_SIZE(n_lines_seq);
+
+            if (PySequence_Fast_GET_SIZE(timestamps_seq) == count) {
+                ZvbiServiceDecFrame * frames = PyMem_Malloc((count + 1) * sizeof(ZvbiServiceDecFrame));
+                if (frames != NULL) {
+                    size_t max_lines = in_buf.len / sizeof(vbi_sliced);
+                    size_t line_idx = 0;
+                    Py_ssize_t idx;
+
+                    for (idx = 0; idx < count; ++idx) {
+                        long n_lines = PyLong_AsLong(PySequence_Fast_GET_ITEM(n_lines_seq, idx));
+                        double timestamp = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(timestamps_seq, idx));
+
+                        if (PyErr_Occurred()) {
+                            break;
+                        }
+                        if ((n_lines < 0) || ((size_t)n_lines > max_lines - line_idx)) {
+                            PyErr_Format(PyExc_ValueError, "Buffer too short for given number of lines "
+                                         "at frame index %zd", idx);
+                            break;
+                        }
+                        frames[idx].p_sliced = (vbi_sliced*)in_buf.buf + line_idx;
+                        frames[idx].n_lines = n_lines;
+                        frames[idx].timestamp = timestamp;
+                        line_idx += n_lines;
+                    }
+                    if ((idx == count) && ZvbiServiceDec_Decode(self, frames, count)) {
+                        Py_INCREF(Py_None);
+                        RETVAL = Py_None;
+                    }
+                    PyMem_Free(frames);
+                }
+                else {
+                    PyErr_NoMemory();
+                }
+            }
+            else {
+                PyErr_SetString(PyExc_ValueError, "Sequences n_lines and timestamps differ in length");
+            }
+        }
+        Py_XDECREF(n_lines_seq);
+        Py_XDECREF(timestamps_seq);
+        PyBuffer_Release(&in_buf);
+    }
+    return RETVAL;
+}
+
+static PyObject *
+ZvbiServiceDec_decode_many(ZvbiServiceDecObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"frames", "n_lines", "timestamps", NULL};
+    PyObject * frames_obj = NULL;
+    PyObject * n_lines_obj = NULL;
+    PyObject * timestamps_obj = NULL;
+    PyObject * RETVAL = NULL;
+
+    if (PyArg_ParseTupleAndKeywords(args, kwds, "O|$OO", kwlist,
+                                    &frames_obj, &n_lines_obj, &timestamps_obj))
+    {
+        if ((n_lines_obj == NULL) && (timestamps_obj == NULL)) {
+            RETVAL = ZvbiServiceDec_DecodeSeq(self, frames_obj);
+        }
+        else if ((n_lines_obj != NULL) && (timestamps_obj != NULL)) {
+            RETVAL = ZvbiServiceDec_DecodeBlock(self, frames_obj, n_lines_obj, timestamps_obj);
+        }
+        else {
+            PyErr_SetString(PyExc_TypeError, "Parameters n_lines and timestamps must be given together");
+        }
+    }
+    return RETVAL;
+}
+
 static PyObject *
 ZvbiServiceDec_channel_switched(ZvbiServiceDecObj *self, PyObject *args)
 {
     PyObject * RETVAL = NULL;
     unsigned nuid;
 
-    if (PyArg_ParseTuple(args, "|I", &nuid)) {
+    if (PyArg_ParseTuple(args, "|I", &nuid) && ZvbiServiceDec_CheckIdle(self)) {
         vbi_channel_switched(self->ctx, nuid);
         Py_INCREF(Py_None);
         RETVAL = Py_None;
@@ -317,73 +711,437 @@ ZvbiServiceDec_page_title(ZvbiServiceDecObj *self, PyObject *args)
 //  Event Handling
 // ---------------------------------------------------------------------------
 
+static vbi_bool
+ZvbiServiceDec_PageFilterCheckPgno(long pgno)
+{
+    if ((pgno < 0x100) || (pgno >= ZVBI_PAGE_FILTER_PGNO_COUNT)) {
+        PyErr_Format(PyExc_ValueError, "Invalid page number 0x%x in page filter", (int)pgno);
+        return FALSE;
+    }
+    return TRUE;
+}
+
 /*
- * Invoke callback for an event generated by the VT decoder
+ * Check if an exported buffer qualifies as page filter bitmap: only plain
+ * contiguous byte buffers are accepted, so that e.g. arrays of 16-bit
+ * integers are treated as sequences of page numbers instead.
  */
-static void
-zvbi_xs_vt_event_handler( vbi_event * event, void * user_data )
+static vbi_bool
+ZvbiServiceDec_PageFilterIsBitmap(const Py_buffer * view)
 {
-    PyObject * cb_obj;
-    unsigned cb_idx = PVOID2UINT(user_data);
+    return (view->itemsize == 1) &&
+           ((view->format == NULL) || (strcmp(view->format, "B") == 0)) &&
+           PyBuffer_IsContiguous(view, 'C');
+}
+
+/*
+ * Convert the page filter parameter of event handler registration. The
+ * parameter is either a bytes-like bitmap indexed by page number (LSB first),
+ * or an iterable (e.g. a set or range) of page numbers or tuples of page and
+ * sub-page number. Returns NULL without exception for parameter None.
+ */
+static ZvbiServiceDecPageFilter *
+ZvbiServiceDec_PageFilterFromObj(PyObject * obj, vbi_bool * p_ok)
+{
+    ZvbiServiceDecPageFilter * filter = NULL;
+    Py_buffer bitmap;
 
-    if ( (cb_idx < ZVBI_MAX_CB_COUNT) &&
-         ((cb_obj = ZvbiCallbacks.event[cb_idx].p_cb) != NULL) )
+    *p_ok = TRUE;
+    if ((obj == NULL) || (obj == Py_None)) {
+        return NULL;
+    }
+
+    vbi_bool is_bitmap = FALSE;
+    if (PyBytes_Check(obj) || PyByteArray_Check(obj)) {
+        is_bitmap = (PyObject_GetBuffer(obj, &bitmap, PyBUF_SIMPLE) == 0);
+    }
+    else if (PyObject_CheckBuffer(obj) &&
+             (PyObject_GetBuffer(obj, &bitmap, PyBUF_FORMAT | PyBUF_STRIDES) == 0))
     {
-        PyObject * ev_obj = ZvbiEvent_ObjFromEvent(event);
-        PyObject * cb_rslt;
+        is_bitmap = ZvbiServiceDec_PageFilterIsBitmap(&bitmap);
+        if (!is_bitmap) {
+            PyBuffer_Release(&bitmap);
+        }
+    }
 
-        if (ev_obj != NULL) {
-            // invoke the Python subroutine
-            if (ZvbiCallbacks.event[cb_idx].p_data != NULL) {
-                cb_rslt = PyObject_CallFunction(cb_obj, "iOO", event->type, ev_obj, ZvbiCallbacks.event[cb_idx].p_data);
+    if (PyErr_Occurred()) {
+        // failed to export the buffer
+    }
+    else if (is_bitmap) {
+        if ((size_t)bitmap.len <= sizeof(filter->pgno_map)) {
+            filter = PyMem_Calloc(1, sizeof(ZvbiServiceDecPageFilter));
+            if (filter != NULL) {
+                memcpy(filter->pgno_map, bitmap.buf, bitmap.len);
             }
             else {
-                cb_rslt = PyObject_CallFunction(cb_obj, "iO", event->type, ev_obj);
+                PyErr_NoMemory();
+            }
+        }
+        else {
+            PyErr_Format(PyExc_ValueError, "Page filter bitmap is too long (max. %d bytes)",
+                         (int)sizeof(filter->pgno_map));
+        }
+        PyBuffer_Release(&bitmap);
+    }
+    else {
+        PyObject * seq = PySequence_Fast(obj, "Page filter must be a bytes-like bitmap or an iterable of page numbers");
+        if (seq != NULL) {
+            Py_ssize_t len = PySequence_Fast_GET_SIZE(seq);
+            unsigned sub_count = 0;
+
+            for (Py_ssize_t idx = 0; idx < len; ++idx) {
+                if (PyTuple_Check(PySequence_Fast_GET_ITEM(seq, idx))) {
+                    sub_count += 1;
+                }
             }
+            filter = PyMem_Calloc(1, sizeof(ZvbiServiceDecPageFilter) + sub_count * sizeof(filter->sub[0]));
+            if (filter != NULL) {
+                for (Py_ssize_t idx = 0; idx < len; ++idx) {
+                    PyObject * item = PySequence_Fast_GET_ITEM(seq, idx);
+                    long pgno;
 
-            if (cb_rslt != NULL) {
-                Py_DECREF(cb_rslt);
+                    if (PyTuple_Check(item)) {
+                        int subno;
+                        if (!PyArg_ParseTuple(item, "li;Page filter items must be page numbers or (pgno, subno) tuples",
+                                              &pgno, &subno) ||
+                            !ZvbiServiceDec_PageFilterCheckPgno(pgno))
+                        {
+                            break;
+                        }
+                        filter->sub[filter->sub_count].pgno = pgno;
+                        filter->sub[filter->sub_count].subno = subno;
+                        filter->sub_count += 1;
+                    }
+                    else {
+                        pgno = PyLong_AsLong(item);
+                        if (((pgno == -1) && PyErr_Occurred()) ||
+                            !ZvbiServiceDec_PageFilterCheckPgno(pgno))
+                        {
+                            break;
+                        }
+                        filter->pgno_map[pgno >> 3] |= 1 << (pgno & 7);
+                    }
+                }
             }
-            Py_DECREF(ev_obj);
+            else {
+                PyErr_NoMemory();
+            }
+            Py_DECREF(seq);
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        PyMem_Free(filter);
+        filter = NULL;
+        *p_ok = FALSE;
+    }
+    return filter;
+}
+
+/*
+ * Check if the event passes the given page filter. Only TTX_PAGE events
+ * are filtered. This may be called without holding the GIL.
+ */
+static vbi_bool
+ZvbiServiceDec_PageFilterMatch(const ZvbiServiceDecPageFilter * filter, const vbi_event * event)
+{
+    if ((filter == NULL) || (event->type != VBI_EVENT_TTX_PAGE)) {
+        return TRUE;
+    }
+    vbi_pgno pgno = event->ev.ttx_page.pgno;
+
+    if ((pgno >= 0) && (pgno < ZVBI_PAGE_FILTER_PGNO_COUNT) &&
+        (filter->pgno_map[pgno >> 3] & (1 << (pgno & 7))))
+    {
+        return TRUE;
+    }
+    for (unsigned idx = 0; idx < filter->sub_count; ++idx) {
+        if ((filter->sub[idx].pgno == pgno) && (filter->sub[idx].subno == event->ev.ttx_page.subno)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*
+ * Invoke the given Python handler for an event
+ */
+static void
+ZvbiServiceDec_InvokeHandler( ZvbiServiceDecHandler * handler, vbi_event * event )
+{
+    // keep references, as the handler may unregister itself during the call
+    PyObject * cb_obj = handler->p_cb;
+    PyObject * data_obj = handler->p_data;
+    PyObject * ev_obj = ZvbiEvent_ObjFromEvent(event);
+    PyObject * cb_rslt;
+
+    if (ev_obj != NULL) {
+        Py_INCREF(cb_obj);
+        Py_XINCREF(data_obj);
+
+        // invoke the Python subroutine
+        if (data_obj != NULL) {
+            cb_rslt = PyObject_CallFunction(cb_obj, "iOO", event->type, ev_obj, data_obj);
+        }
+        else {
+            cb_rslt = PyObject_CallFunction(cb_obj, "iO", event->type, ev_obj);
+        }
+
+        if (cb_rslt != NULL) {
+            Py_DECREF(cb_rslt);
+        }
+        Py_DECREF(ev_obj);
+        Py_DECREF(cb_obj);
+        Py_XDECREF(data_obj);
+    }
+
+    // clear exceptions as we cannot handle them here
+    if (PyErr_Occurred() != NULL) {
+        PyErr_Print();
+    }
+}
+
+/*
+ * Append a copy of the event to the given queue. This is called without
+ * holding the GIL, so only the raw memory allocator can be used. When the
+ * queue is full, the event is dropped and counted as lost.
+ */
+static void
+ZvbiServiceDec_QueueEvent( ZvbiServiceDecEvQueue * queue, vbi_event * event, ZvbiServiceDecHandler * handler )
+{
+    if ((queue->limit != 0) && (queue->len >= queue->limit)) {
+        queue->lost += 1;
+        return;
+    }
+    if (queue->len >= queue->size) {
+        unsigned size = (queue->size > 0) ? (queue->size * 2) : ZVBI_SERVICE_DEC_EV_QUEUE_SIZE;
+        ZvbiServiceDecEvent * p_queue = PyMem_RawRealloc(queue->p_ev, size * sizeof(ZvbiServiceDecEvent));
+        if (p_queue == NULL) {
+            queue->lost += 1;
+            return;
+        }
+        queue->p_ev = p_queue;
+        queue->size = size;
+    }
+    ZvbiServiceDecEvent * p_ev = &queue->p_ev[queue->len++];
+
+    p_ev->event = *event;
+    p_ev->handler = handler;
+
+    if ((event->type == VBI_EVENT_TTX_PAGE) && (event->ev.ttx_page.raw_header != NULL)) {
+        memcpy(p_ev->data.raw_header, event->ev.ttx_page.raw_header, sizeof(p_ev->data.raw_header));
+    }
+    else if ((event->type == VBI_EVENT_TRIGGER) && (event->ev.trigger != NULL)) {
+        p_ev->data.link = *event->ev.trigger;
+    }
+    else if ((event->type == VBI_EVENT_PROG_INFO) && (event->ev.prog_info != NULL)) {
+        p_ev->data.prog_info = *event->ev.prog_info;
+    }
+}
+
+/*
+ * Point references within a queued event to the copies of referenced data,
+ * as the queue may have been moved while growing.
+ */
+static vbi_event *
+ZvbiServiceDec_QueuedEvent( ZvbiServiceDecEvent * p_ev )
+{
+    if ((p_ev->event.type == VBI_EVENT_TTX_PAGE) && (p_ev->event.ev.ttx_page.raw_header != NULL)) {
+        p_ev->event.ev.ttx_page.raw_header = p_ev->data.raw_header;
+    }
+    else if ((p_ev->event.type == VBI_EVENT_TRIGGER) && (p_ev->event.ev.trigger != NULL)) {
+        p_ev->event.ev.trigger = &p_ev->data.link;
+    }
+    else if ((p_ev->event.type == VBI_EVENT_PROG_INFO) && (p_ev->event.ev.prog_info != NULL)) {
+        p_ev->event.ev.prog_info = &p_ev->data.prog_info;
+    }
+    return &p_ev->event;
+}
+
+/*
+ * Invoke Python handlers for all events collected while decoding. The queue
+ * is detached while handlers run, as these might decode recursively.
+ * Returns FALSE and raises an exception if events were lost.
+ */
+static vbi_bool
+ZvbiServiceDec_DeliverEvents(ZvbiServiceDecObj * self)
+{
+    ZvbiServiceDecEvQueue queue = self->ev_queue;
+
+    memset(&self->ev_queue, 0, sizeof(self->ev_queue));
+
+    self->deliver_depth += 1;
+    for (unsigned idx = 0; idx < queue.len; ++idx) {
+        ZvbiServiceDecEvent * p_ev = &queue.p_ev[idx];
+
+        // skip handlers that were unregistered by a preceding handler
+        if (!p_ev->handler->removed) {
+            ZvbiServiceDec_InvokeHandler(p_ev->handler, ZvbiServiceDec_QueuedEvent(p_ev));
+        }
+    }
+    self->deliver_depth -= 1;
+    if (self->deliver_depth == 0) {
+        ZvbiServiceDec_FreeRemovedHandlers(self);
+    }
+
+    // keep the queue memory for the next call, unless replaced during recursion
+    if (self->ev_queue.p_ev == NULL) {
+        self->ev_queue.p_ev = queue.p_ev;
+        self->ev_queue.size = queue.size;
+    }
+    else {
+        PyMem_RawFree(queue.p_ev);
+    }
+
+    if (queue.lost > 0) {
+        PyErr_Format(ZvbiServiceDecError, "%u events were lost due to memory shortage", queue.lost);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Callback for events generated by the VT decoder: the Python handler is
+ * invoked directly, or the event is queued while decoding without the GIL.
+ */
+static void
+zvbi_xs_vt_event_handler( vbi_event * event, void * user_data )
+{
+    ZvbiServiceDecHandler * handler = user_data;
+
+    if (ZvbiServiceDec_PageFilterMatch(handler->filter, event)) {
+        if (handler->self->busy) {
+            ZvbiServiceDec_QueueEvent(&handler->self->ev_queue, event, handler);
+        }
+        else {
+            ZvbiServiceDec_InvokeHandler(handler, event);
         }
+    }
+}
+
+/*
+ * Search the handler registered with the given function and user data;
+ * returns the index, or the handler count if not found.
+ */
+static unsigned
+ZvbiServiceDec_FindHandler(ZvbiServiceDecObj * self, PyObject * handler_obj, PyObject * user_data_obj)
+{
+    unsigned idx;
+
+    for (idx = 0; idx < self->handler_count; ++idx) {
+        if ((self->handlers[idx]->p_cb == handler_obj) &&
+            (self->handlers[idx]->p_data == user_data_obj))
+        {
+            break;
+        }
+    }
+    return idx;
+}
 
-        // clear exceptions as we cannot handle them here
-        if (PyErr_Occurred() != NULL) {
-            PyErr_Print();
+/*
+ * Append a new handler to the list. Ownership of the filter is passed to
+ * the handler in any case. Returns NULL upon memory allocation failure.
+ */
+static ZvbiServiceDecHandler *
+ZvbiServiceDec_AddHandler(ZvbiServiceDecObj * self, PyObject * handler_obj, PyObject * user_data_obj,
+                          ZvbiServiceDecPageFilter * filter)
+{
+    ZvbiServiceDecHandler * handler = NULL;
+
+    if (self->handler_count >= self->handler_size) {
+        unsigned size = (self->handler_size > 0) ? (self->handler_size * 2) : 4;
+        ZvbiServiceDecHandler ** p_list = PyMem_Realloc(self->handlers, size * sizeof(*p_list));
+        if (p_list == NULL) {
+            PyErr_NoMemory();
+            PyMem_Free(filter);
+            return NULL;
         }
+        self->handlers = p_list;
+        self->handler_size = size;
+    }
+    handler = PyMem_Malloc(sizeof(ZvbiServiceDecHandler));
+    if (handler != NULL) {
+        handler->self = self;
+        handler->p_cb = handler_obj;
+        handler->p_data = user_data_obj;
+        handler->filter = filter;
+        handler->removed = FALSE;
+        handler->next_removed = NULL;
+        Py_INCREF(handler_obj);
+        Py_XINCREF(user_data_obj);
+
+        self->handlers[self->handler_count++] = handler;
     }
+    else {
+        PyErr_NoMemory();
+        PyMem_Free(filter);
+    }
+    return handler;
+}
+
+/*
+ * Unregister the handler at the given index from the decoder and release it
+ */
+static void
+ZvbiServiceDec_RemoveHandler(ZvbiServiceDecObj * self, unsigned idx)
+{
+    ZvbiServiceDecHandler * handler = self->handlers[idx];
+
+    vbi_event_handler_unregister(self->ctx, zvbi_xs_vt_event_handler, handler);
+
+    self->handler_count -= 1;
+    memmove(&self->handlers[idx], &self->handlers[idx + 1],
+            (self->handler_count - idx) * sizeof(self->handlers[0]));
+
+    ZvbiServiceDec_ReleaseHandler(self, handler);
 }
 
 
 static PyObject *
-ZvbiServiceDec_event_handler_register(ZvbiServiceDecObj *self, PyObject *args)
+ZvbiServiceDec_event_handler_register(ZvbiServiceDecObj *self, PyObject *args, PyObject *kwds)
 {
+    static char * kwlist[] = {"event_mask", "handler", "user_data", "pages", NULL};
     int event_mask;
     PyObject * handler_obj = NULL;
     PyObject * user_data_obj = NULL;
+    PyObject * pages_obj = NULL;
+    ZvbiServiceDecPageFilter * filter = NULL;
+    vbi_bool filter_ok = FALSE;
     PyObject * RETVAL = NULL;
 
-    if (PyArg_ParseTuple(args, "iO|O", &event_mask, &handler_obj, &user_data_obj) &&
-        ZvbiCallbacks_CheckObj(handler_obj))
+    if (PyArg_ParseTupleAndKeywords(args, kwds, "iO|O$O", kwlist,
+                                    &event_mask, &handler_obj, &user_data_obj, &pages_obj) &&
+        ZvbiCallbacks_CheckObj(handler_obj) && ZvbiServiceDec_CheckIdle(self))
     {
-        ZvbiCallbacks_free_by_ptr(ZvbiCallbacks.event, self, handler_obj, user_data_obj, TRUE);
-        unsigned cb_idx = ZvbiCallbacks_alloc(ZvbiCallbacks.event, handler_obj, user_data_obj, self);
-        if (cb_idx < ZVBI_MAX_CB_COUNT) {
+        filter = ZvbiServiceDec_PageFilterFromObj(pages_obj, &filter_ok);
+    }
+    if (filter_ok) {
+        ZvbiServiceDecHandler * handler;
+        unsigned idx = ZvbiServiceDec_FindHandler(self, handler_obj, user_data_obj);
+
+        if (idx < self->handler_count) {
+            // already registered: libzvbi only updates the event mask
+            handler = self->handlers[idx];
+            PyMem_Free(handler->filter);
+            handler->filter = filter;
+        }
+        else {
+            handler = ZvbiServiceDec_AddHandler(self, handler_obj, user_data_obj, filter);
+            idx = self->handler_count - 1;
+        }
+        if (handler != NULL) {
             if (vbi_event_handler_register(self->ctx, event_mask,
                                            zvbi_xs_vt_event_handler,
-                                           UINT2PVOID(cb_idx)))
+                                           handler))
             {
                 Py_INCREF(Py_None);
                 RETVAL = Py_None;
             }
             else {
                 PyErr_SetString(ZvbiServiceDecError, "Registration failed");
-                ZvbiCallbacks_free_by_idx(ZvbiCallbacks.event, cb_idx);
+                ZvbiServiceDec_RemoveHandler(self, idx);
             }
         }
-        else {
-            PyErr_SetString(ZvbiServiceDecError, "Max. Zvbi.ServiceDec callback count exceeded");
-        }
     }
     return RETVAL;
 }
@@ -395,21 +1153,215 @@ ZvbiServiceDec_event_handler_unregister(ZvbiServiceDecObj *self, PyObject *args)
     PyObject * user_data_obj = NULL;
     PyObject * RETVAL = NULL;
 
-    if (PyArg_ParseTuple(args, "O|O", &handler_obj, &user_data_obj)) {
-        unsigned cb_idx = ZvbiCallbacks_free_by_ptr(ZvbiCallbacks.event, self, handler_obj, user_data_obj, TRUE);
-        vbi_event_handler_unregister(self->ctx, zvbi_xs_vt_event_handler, UINT2PVOID(cb_idx));
+    if (PyArg_ParseTuple(args, "O|O", &handler_obj, &user_data_obj) && ZvbiServiceDec_CheckIdle(self)) {
+        unsigned idx = ZvbiServiceDec_FindHandler(self, handler_obj, user_data_obj);
+        if (idx < self->handler_count) {
+            ZvbiServiceDec_RemoveHandler(self, idx);
+        }
         Py_INCREF(Py_None);
         RETVAL = Py_None;
     }
     return RETVAL;
 }
 
+// ---------------------------------------------------------------------------
+//  Event polling
+// ---------------------------------------------------------------------------
+
+// flags within records returned by poll_events(compact=True)
+#define ZVBI_POLL_FLAG_ROLL_HEADER      (1<<0)
+#define ZVBI_POLL_FLAG_HEADER_UPDATE    (1<<1)
+#define ZVBI_POLL_FLAG_CLOCK_UPDATE     (1<<2)
+
+/*
+ * Callback for events registered for polling: the event is only queued.
+ * This may be called without holding the GIL (see "defer_events").
+ */
+static void
+zvbi_xs_vt_poll_handler( vbi_event * event, void * user_data )
+{
+    ZvbiServiceDecObj * self = user_data;
+
+    if (ZvbiServiceDec_PageFilterMatch(self->poll_filter, event)) {
+        ZvbiServiceDec_QueueEvent(&self->poll_queue, event, NULL);
+    }
+}
+
+static PyObject *
+ZvbiServiceDec_event_poll_register(ZvbiServiceDecObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"event_mask", "pages", NULL};
+    int event_mask;
+    PyObject * pages_obj = NULL;
+    ZvbiServiceDecPageFilter * filter = NULL;
+    vbi_bool filter_ok = FALSE;
+    PyObject * RETVAL = NULL;
+
+    if (PyArg_ParseTupleAndKeywords(args, kwds, "i|$O", kwlist, &event_mask, &pages_obj) &&
+        ZvbiServiceDec_CheckIdle(self))
+    {
+        filter = ZvbiServiceDec_PageFilterFromObj(pages_obj, &filter_ok);
+    }
+    if (filter_ok) {
+        PyMem_Free(self->poll_filter);
+        self->poll_filter = filter;
+
+        if (event_mask != 0) {
+            if (vbi_event_handler_register(self->ctx, event_mask, zvbi_xs_vt_poll_handler, self)) {
+                self->poll_mask = event_mask;
+                Py_INCREF(Py_None);
+                RETVAL = Py_None;
+            }
+            else {
+                PyErr_SetString(ZvbiServiceDecError, "Registration failed");
+            }
+        }
+        else {
+            vbi_event_handler_unregister(self->ctx, zvbi_xs_vt_poll_handler, self);
+            self->poll_mask = 0;
+            Py_INCREF(Py_None);
+            RETVAL = Py_None;
+        }
+    }
+    return RETVAL;
+}
+
+/*
+ * Return the given number of queued events as a list of tuples (type, event),
+ * i.e. with the same parameters as passed to event handler callbacks.
+ */
+static PyObject *
+ZvbiServiceDec_PollList(ZvbiServiceDecObj * self, unsigned count)
+{
+    PyObject * RETVAL = PyList_New(count);
+
+    if (RETVAL != NULL) {
+        for (unsigned idx = 0; idx < count; ++idx) {
+            vbi_event * event = ZvbiServiceDec_QueuedEvent(&self->poll_queue.p_ev[idx]);
+            PyObject * ev_obj = ZvbiEvent_ObjFromEvent(event);
+            PyObject * tuple = NULL;
+
+            if (ev_obj != NULL) {
+                tuple = Py_BuildValue("iN", event->type, ev_obj);
+            }
+            if (tuple == NULL) {
+                Py_DECREF(RETVAL);
+                RETVAL = NULL;
+                break;
+            }
+            PyList_SET_ITEM(RETVAL, idx, tuple);
+        }
+    }
+    return RETVAL;
+}
+
+/*
+ * Return the given number of queued events as a 2-dimensional memoryview of
+ * unsigned integers, with one record (type, pgno, subno, flags) per event.
+ */
+static PyObject *
+ZvbiServiceDec_PollCompact(ZvbiServiceDecObj * self, unsigned count)
+{
+    PyObject * RETVAL = NULL;
+    PyObject * bytes = PyBytes_FromStringAndSize(NULL, count * 4 * sizeof(uint32_t));
+
+    if (bytes != NULL) {
+        uint32_t * p_rec = (uint32_t*) PyBytes_AS_STRING(bytes);
+
+        for (unsigned idx = 0; idx < count; ++idx, p_rec += 4) {
+            vbi_event * event = &self->poll_queue.p_ev[idx].event;
+
+            p_rec[0] = event->type;
+            p_rec[1] = 0;
+            p_rec[2] = 0;
+            p_rec[3] = 0;
+
+            if (event->type == VBI_EVENT_TTX_PAGE) {
+                p_rec[1] = event->ev.ttx_page.pgno;
+                p_rec[2] = event->ev.ttx_page.subno;
+                p_rec[3] = (event->ev.ttx_page.roll_header ? ZVBI_POLL_FLAG_ROLL_HEADER : 0) |
+                           (event->ev.ttx_page.header_update ? ZVBI_POLL_FLAG_HEADER_UPDATE : 0) |
+                           (event->ev.ttx_page.clock_update ? ZVBI_POLL_FLAG_CLOCK_UPDATE : 0);
+            }
+            else if (event->type == VBI_EVENT_CAPTION) {
+                p_rec[1] = event->ev.caption.pgno;
+            }
+        }
+
+        PyObject * view = PyMemoryView_FromObject(bytes);
+        if (view != NULL) {
+            if (count > 0) {
+                RETVAL = PyObject_CallMethod(view, "cast", "s(Ii)", "I", count, 4);
+            }
+            else {
+                // memoryview does not support casting to a shape containing zero
+                RETVAL = PyObject_CallMethod(view, "cast", "s", "I");
+            }
+            Py_DECREF(view);
+        }
+        Py_DECREF(bytes);
+    }
+    return RETVAL;
+}
+
+static PyObject *
+ZvbiServiceDec_poll_events(ZvbiServiceDecObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"max", "compact", NULL};
+    PyObject * max_obj = Py_None;
+    int compact = FALSE;
+    PyObject * RETVAL = NULL;
+
+    if (PyArg_ParseTupleAndKeywords(args, kwds, "|O$p", kwlist, &max_obj, &compact) &&
+        ZvbiServiceDec_CheckIdle(self))
+    {
+        unsigned count = self->poll_queue.len;
+
+        if (max_obj != Py_None) {
+            long max_count = PyLong_AsLong(max_obj);
+            if ((max_count == -1) && PyErr_Occurred()) {
+                return NULL;
+            }
+            if (max_count < 0) {
+                PyErr_SetString(PyExc_ValueError, "Maximum event count must not be negative");
+                return NULL;
+            }
+            if ((unsigned long)max_count < count) {
+                count = max_count;
+            }
+        }
+
+        if (self->poll_queue.lost > 0) {
+            // report lost events once; the queued events are kept for the next call
+            PyErr_Format(ZvbiServiceDecError, "%u events were lost due to queue overflow or memory shortage",
+                         self->poll_queue.lost);
+            self->poll_queue.lost = 0;
+        }
+        else {
+            if (compact) {
+                RETVAL = ZvbiServiceDec_PollCompact(self, count);
+            }
+            else {
+                RETVAL = ZvbiServiceDec_PollList(self, count);
+            }
+            if (RETVAL != NULL) {
+                // discard the returned events from the queue
+                self->poll_queue.len -= count;
+                memmove(self->poll_queue.p_ev, self->poll_queue.p_ev + count,
+                        self->poll_queue.len * sizeof(ZvbiServiceDecEvent));
+            }
+        }
+    }
+    return RETVAL;
+}
+
 // ---------------------------------------------------------------------------
 
 static PyMethodDef ZvbiServiceDec_MethodsDef[] =
 {
     {"decode",           (PyCFunction) ZvbiServiceDec_decode,           METH_VARARGS, NULL },
     {"decode_bytes",     (PyCFunction) ZvbiServiceDec_decode_bytes,     METH_VARARGS, NULL },
+    {"decode_many",      (PyCFunction) ZvbiServiceDec_decode_many,      METH_VARARGS | METH_KEYWORDS, NULL },
     {"channel_switched", (PyCFunction) ZvbiServiceDec_channel_switched, METH_VARARGS, NULL },
     {"classify_page",    (PyCFunction) ZvbiServiceDec_classify_page,    METH_VARARGS, NULL },
     {"set_brightness",   (PyCFunction) ZvbiServiceDec_set_brightness,   METH_VARARGS, NULL },
@@ -422,8 +1374,10 @@ static PyMethodDef ZvbiServiceDec_MethodsDef[] =
     {"page_title",       (PyCFunction) ZvbiServiceDec_page_title,       METH_VARARGS, NULL },
 
     // event_handler_add, event_handler_remove: omitted b/c deprecated
-    {"event_handler_register",   (PyCFunction) ZvbiServiceDec_event_handler_register,   METH_VARARGS, NULL },
+    {"event_handler_register",   (PyCFunction) ZvbiServiceDec_event_handler_register,   METH_VARARGS | METH_KEYWORDS, NULL },
     {"event_handler_unregister", (PyCFunction) ZvbiServiceDec_event_handler_unregister, METH_VARARGS, NULL },
+    {"event_poll_register",      (PyCFunction) ZvbiServiceDec_event_poll_register,      METH_VARARGS | METH_KEYWORDS, NULL },
+    {"poll_events",              (PyCFunction) ZvbiServiceDec_poll_events,              METH_VARARGS | METH_KEYWORDS, NULL },
 
     {NULL}  /* Sentinel */
 };
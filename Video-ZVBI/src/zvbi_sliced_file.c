@@ -0,0 +1,833 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include "Python.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <libzvbi.h>
+
+#include "zvbi_capture_buf.h"
+#include "zvbi_compact_sliced_buf.h"
+#include "zvbi_sliced_file.h"
+
+// ---------------------------------------------------------------------------
+//  Binary file format for sliced data
+// ---------------------------------------------------------------------------
+
+/*
+ * The format is the one written by example "capture.py --sliced" and read
+ * by "decode.py" (originally by test/capture.c of libzvbi). Each frame
+ * consists of:
+ * - time in seconds since the previous frame as newline-terminated string
+ * - number of sliced lines (one byte)
+ * - per line: type index (0..7), line number (LSB, MSB), data x N, where N
+ *   is implied by the type index
+ */
+
+// Maximum length of the timestamp string, including the newline character
+#define TIMESTAMP_MAX_LEN  32
+
+static const struct {
+    unsigned    id;
+    unsigned    data_len;
+} ZvbiSlicedFile_Services[8] =
+{
+    { VBI_SLICED_TELETEXT_B,  42 },
+    { VBI_SLICED_CAPTION_625,  2 },
+    { VBI_SLICED_VPS,         13 },
+    { VBI_SLICED_WSS_625,      2 },
+    { VBI_SLICED_WSS_CPR1204,  3 },
+    { 0,                       0 },
+    { 0,                       0 },
+    { VBI_SLICED_CAPTION_525,  2 },
+};
+
+/*
+ * Parse one frame from the given buffer. Lines exceeding the given maximum
+ * are skipped. Returns 1 and the number of consumed bytes for a complete
+ * frame, 0 when the buffer does not contain a complete frame, or -1 when the
+ * data does not conform to the format.
+ */
+int
+ZvbiSlicedFile_ParseFrame(const uint8_t * buf, size_t len,
+                          vbi_sliced * sliced, unsigned max_lines,
+                          unsigned * p_n_lines, double * p_delta, size_t * p_used)
+{
+    char ts_str[TIMESTAMP_MAX_LEN + 1];
+    size_t ts_len = (len < TIMESTAMP_MAX_LEN) ? len : TIMESTAMP_MAX_LEN;
+
+    const uint8_t * p_nl = memchr(buf, '\n', ts_len);
+    if (p_nl == NULL) {
+        return (len < TIMESTAMP_MAX_LEN) ? 0 : -1;
+    }
+    ts_len = p_nl - buf;
+    memcpy(ts_str, buf, ts_len);
+    ts_str[ts_len] = 0;
+
+    char * p_end = NULL;
+    double delta = strtod(ts_str, &p_end);
+    if ((p_end == ts_str) || (*p_end != 0)) {
+        return -1;
+    }
+    if (delta < 0.0) {
+        delta = -delta;
+    }
+
+    size_t off = ts_len + 1;
+    if (off >= len) {
+        return 0;
+    }
+    unsigned line_cnt = buf[off++];
+    unsigned n_lines = 0;
+
+    for (unsigned idx = 0; idx < line_cnt; ++idx) {
+        if (off + 3 > len) {
+            return 0;
+        }
+        unsigned type = buf[off];
+        if ((type >= 8) || (ZvbiSlicedFile_Services[type].data_len == 0)) {
+            return -1;
+        }
+        unsigned data_len = ZvbiSlicedFile_Services[type].data_len;
+        if (off + 3 + data_len > len) {
+            return 0;
+        }
+        if (n_lines < max_lines) {
+            vbi_sliced * p_sliced = &sliced[n_lines++];
+            p_sliced->id = ZvbiSlicedFile_Services[type].id;
+            p_sliced->line = (buf[off + 1] | (buf[off + 2] << 8)) & 0xFFF;
+            memcpy(p_sliced->data, buf + off + 3, data_len);
+            memset(p_sliced->data + data_len, 0, sizeof(p_sliced->data) - data_len);
+        }
+        off += 3 + data_len;
+    }
+
+    *p_n_lines = n_lines;
+    *p_delta = delta;
+    *p_used = off;
+    return 1;
+}
+
+/*
+ * Encode one frame into the given buffer, which must have space for at
+ * least ZVBI_SLICED_FILE_MAX_FRAME_LEN bytes. Lines with services not
+ * supported by the format are skipped. Returns the number of bytes used.
+ */
+static size_t
+ZvbiSlicedFile_EncodeFrame(uint8_t * buf, const vbi_sliced * sliced, unsigned n_lines,
+                           double delta)
+{
+    size_t off = snprintf((char*)buf, TIMESTAMP_MAX_LEN, "%f\n", delta);
+    if ((off >= TIMESTAMP_MAX_LEN) || (buf[off - 1] != '\n')) {
+        // out-of-range delta: write the nominal frame distance instead
+        off = snprintf((char*)buf, TIMESTAMP_MAX_LEN, "%f\n", 0.04);
+    }
+    size_t cnt_off = off++;
+    unsigned line_cnt = 0;
+
+    for (unsigned idx = 0; (idx < n_lines) && (line_cnt < ZVBI_SLICED_FILE_MAX_LINES); ++idx) {
+        for (unsigned type = 0; type < 8; ++type) {
+            if (sliced[idx].id & ZvbiSlicedFile_Services[type].id) {
+                unsigned data_len = ZvbiSlicedFile_Services[type].data_len;
+                buf[off + 0] = type;
+                buf[off + 1] = sliced[idx].line & 0xFF;
+                buf[off + 2] = sliced[idx].line >> 8;
+                memcpy(buf + off + 3, sliced[idx].data, data_len);
+                off += 3 + data_len;
+                line_cnt += 1;
+                break;
+            }
+        }
+    }
+    buf[cnt_off] = line_cnt;
+    return off;
+}
+
+/*
+ * Synchronize the file descriptor underlying the given file object with
+ * the object's buffer: pending output is flushed, and for seekable files
+ * the descriptor is positioned at the logical position of the object, as
+ * a buffered reader may have read ahead. Returns FALSE and raises an
+ * exception on failure.
+ */
+static vbi_bool
+ZvbiSlicedFile_SyncFileObj(PyObject * file, int fd)
+{
+    vbi_bool result = TRUE;
+
+    if (PyObject_HasAttrString(file, "flush")) {
+        PyObject * ret = PyObject_CallMethod(file, "flush", NULL);
+        if (ret != NULL) {
+            Py_DECREF(ret);
+        }
+        else {
+            result = FALSE;
+        }
+    }
+    if (result && PyObject_HasAttrString(file, "seekable") && PyObject_HasAttrString(file, "tell")) {
+        PyObject * seekable = PyObject_CallMethod(file, "seekable", NULL);
+        if (seekable != NULL) {
+            if (PyObject_IsTrue(seekable) == 1) {
+                PyObject * pos_obj = PyObject_CallMethod(file, "tell", NULL);
+                if (pos_obj != NULL) {
+                    long long pos = PyLong_AsLongLong(pos_obj);
+                    if ((pos == -1) && PyErr_Occurred()) {
+                        result = FALSE;
+                    }
+                    else if (lseek(fd, (off_t)pos, SEEK_SET) == (off_t)-1) {
+                        PyErr_SetFromErrno(PyExc_OSError);
+                        result = FALSE;
+                    }
+                    Py_DECREF(pos_obj);
+                }
+                else {
+                    result = FALSE;
+                }
+            }
+            Py_DECREF(seekable);
+        }
+        else {
+            result = FALSE;
+        }
+    }
+    return result;
+}
+
+/*
+ * Get a file descriptor for the given file argument, which is either a
+ * path name, or an integer file descriptor or an object with a "fileno"
+ * method. In the first case the file is opened and has to be closed by the
+ * caller. Returns -1 and raises an exception on failure.
+ */
+static int
+ZvbiSlicedFile_OpenFd(PyObject * file, int flags, vbi_bool * p_do_close)
+{
+    int fd = -1;
+
+    if (PyLong_Check(file)) {
+        fd = PyObject_AsFileDescriptor(file);
+        *p_do_close = FALSE;
+    }
+    else if (PyObject_HasAttrString(file, "fileno")) {
+        fd = PyObject_AsFileDescriptor(file);
+        if ((fd != -1) && !ZvbiSlicedFile_SyncFileObj(file, fd)) {
+            fd = -1;
+        }
+        *p_do_close = FALSE;
+    }
+    else {
+        PyObject * path_obj = NULL;
+        if (PyUnicode_FSConverter(file, &path_obj)) {
+            const char * path = PyBytes_AsString(path_obj);
+
+            Py_BEGIN_ALLOW_THREADS
+            fd = open(path, flags | O_CLOEXEC, 0666);
+            Py_END_ALLOW_THREADS
+
+            if (fd == -1) {
+                PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, file);
+            }
+            Py_DECREF(path_obj);
+            *p_do_close = TRUE;
+        }
+    }
+    return fd;
+}
+
+// ---------------------------------------------------------------------------
+//  Writer class
+// ---------------------------------------------------------------------------
+
+// Maximum size of one frame in the file format: 45 bytes for teletext lines
+#define ZVBI_SLICED_FILE_MAX_FRAME_LEN  (TIMESTAMP_MAX_LEN + 1 + ZVBI_SLICED_FILE_MAX_LINES * (3 + 42))
+#define ZVBI_SLICED_FILE_DEFAULT_BUF_SIZE  (1024 * 1024)
+
+typedef struct {
+    PyObject_HEAD
+    int             fd;
+    vbi_bool        do_close;
+    PyObject *      file;           // reference to file object passed by caller
+    uint8_t *       buf;
+    size_t          buf_size;
+    size_t          buf_fill;
+    double          last_timestamp;
+    vbi_bool        have_last;      // FALSE until the first frame was written
+} ZvbiSlicedWriterObj;
+
+static PyObject *
+ZvbiSlicedWriter_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    ZvbiSlicedWriterObj * self = (ZvbiSlicedWriterObj *) type->tp_alloc(type, 0);
+    if (self != NULL) {
+        self->fd = -1;
+    }
+    return (PyObject *) self;
+}
+
+/*
+ * Write the buffered data to the file. Returns FALSE and sets errno upon
+ * error, in which case the unwritten data remains in the buffer.
+ */
+static vbi_bool
+ZvbiSlicedWriter_WriteBuffer(ZvbiSlicedWriterObj * self)
+{
+    size_t done = 0;
+    vbi_bool result = TRUE;
+
+    while (done < self->buf_fill) {
+        ssize_t wlen;
+
+        Py_BEGIN_ALLOW_THREADS
+        wlen = write(self->fd, self->buf + done, self->buf_fill - done);
+        Py_END_ALLOW_THREADS
+
+        if (wlen > 0) {
+            done += wlen;
+        }
+        else if ((wlen < 0) && (errno == EINTR)) {
+            if (PyErr_CheckSignals() != 0) {
+                result = FALSE;
+                break;
+            }
+        }
+        else {
+            if (wlen == 0)
+                errno = EIO;
+            result = FALSE;
+            break;
+        }
+    }
+    if (done > 0) {
+        memmove(self->buf, self->buf + done, self->buf_fill - done);
+        self->buf_fill -= done;
+    }
+    return result;
+}
+
+/*
+ * Flush buffered data and close the file. Returns FALSE and raises an
+ * exception upon write errors.
+ */
+static vbi_bool
+ZvbiSlicedWriter_Close(ZvbiSlicedWriterObj * self)
+{
+    vbi_bool result = TRUE;
+
+    if (self->fd != -1) {
+        if (!ZvbiSlicedWriter_WriteBuffer(self)) {
+            if (!PyErr_Occurred())
+                PyErr_SetFromErrno(PyExc_OSError);
+            result = FALSE;
+        }
+        if (self->do_close) {
+            if ((close(self->fd) != 0) && result) {
+                PyErr_SetFromErrno(PyExc_OSError);
+                result = FALSE;
+            }
+        }
+        self->fd = -1;
+    }
+    PyMem_Free(self->buf);
+    self->buf = NULL;
+    self->buf_fill = 0;
+    Py_CLEAR(self->file);
+    return result;
+}
+
+static void
+ZvbiSlicedWriter_dealloc(ZvbiSlicedWriterObj *self)
+{
+    PyObject *exc_type, *exc_value, *exc_tb;
+
+    // data is flushed implicitly; errors can only be reported via close()
+    PyErr_Fetch(&exc_type, &exc_value, &exc_tb);
+    if (!ZvbiSlicedWriter_Close(self)) {
+        PyErr_WriteUnraisable((PyObject *) self);
+    }
+    PyErr_Restore(exc_type, exc_value, exc_tb);
+
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int
+ZvbiSlicedWriter_init(ZvbiSlicedWriterObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"file", "buffer_size", NULL};
+    PyObject * file = NULL;
+    Py_ssize_t buf_size = ZVBI_SLICED_FILE_DEFAULT_BUF_SIZE;
+
+    // reset state in case the object is already initialized
+    if (!ZvbiSlicedWriter_Close(self)) {
+        return -1;
+    }
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$n", kwlist, &file, &buf_size)) {
+        return -1;
+    }
+    if (buf_size < ZVBI_SLICED_FILE_MAX_FRAME_LEN) {
+        PyErr_Format(PyExc_ValueError, "Buffer size must be at least %d",
+                     ZVBI_SLICED_FILE_MAX_FRAME_LEN);
+        return -1;
+    }
+    self->buf = PyMem_Malloc(buf_size);
+    if (self->buf == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    self->buf_size = buf_size;
+    self->buf_fill = 0;
+    self->last_timestamp = 0.0;
+    self->have_last = FALSE;
+
+    self->fd = ZvbiSlicedFile_OpenFd(file, O_WRONLY | O_CREAT | O_TRUNC, &self->do_close);
+    if (self->fd == -1) {
+        ZvbiSlicedWriter_Close(self);
+        return -1;
+    }
+    self->file = file;
+    Py_INCREF(file);
+    return 0;
+}
+
+static PyObject *
+ZvbiSlicedWriter_write(ZvbiSlicedWriterObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"sliced_buf", "flush", NULL};
+    PyObject * sliced_obj = NULL;
+    int do_flush = FALSE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|$p", kwlist,
+                                     ZvbiCompactSlicedBuf_Converter, &sliced_obj, &do_flush))
+    {
+        return NULL;
+    }
+    if (self->fd == -1) {
+        PyErr_SetString(PyExc_ValueError, "I/O operation on closed file");
+        Py_DECREF(sliced_obj);
+        return NULL;
+    }
+    vbi_capture_buffer * sliced_buf = ZvbiCaptureBuf_GetBuf(sliced_obj);
+    if ((sliced_buf == NULL) || (sliced_buf->data == NULL) || PyErr_Occurred()) {
+        Py_DECREF(sliced_obj);
+        return NULL;
+    }
+
+    if (self->buf_fill + ZVBI_SLICED_FILE_MAX_FRAME_LEN > self->buf_size) {
+        if (!ZvbiSlicedWriter_WriteBuffer(self)) {
+            Py_DECREF(sliced_obj);
+            return PyErr_Occurred() ? NULL : PyErr_SetFromErrno(PyExc_OSError);
+        }
+    }
+    // same as in capture example: the first frame gets the nominal frame distance
+    double delta = self->have_last ? (sliced_buf->timestamp - self->last_timestamp) : 0.04;
+    self->last_timestamp = sliced_buf->timestamp;
+    self->have_last = TRUE;
+
+    self->buf_fill += ZvbiSlicedFile_EncodeFrame(self->buf + self->buf_fill, sliced_buf->data,
+                                                 sliced_buf->size / sizeof(vbi_sliced), delta);
+    Py_DECREF(sliced_obj);
+
+    if (do_flush) {
+        if (!ZvbiSlicedWriter_WriteBuffer(self)) {
+            return PyErr_Occurred() ? NULL : PyErr_SetFromErrno(PyExc_OSError);
+        }
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+ZvbiSlicedWriter_flush(ZvbiSlicedWriterObj *self, PyObject *args)
+{
+    if (self->fd == -1) {
+        PyErr_SetString(PyExc_ValueError, "I/O operation on closed file");
+        return NULL;
+    }
+    if (!ZvbiSlicedWriter_WriteBuffer(self)) {
+        return PyErr_Occurred() ? NULL : PyErr_SetFromErrno(PyExc_OSError);
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+ZvbiSlicedWriter_close(ZvbiSlicedWriterObj *self, PyObject *args)
+{
+    if (!ZvbiSlicedWriter_Close(self)) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+ZvbiSlicedWriter_enter(ZvbiSlicedWriterObj *self, PyObject *args)
+{
+    Py_INCREF(self);
+    return (PyObject *) self;
+}
+
+static PyObject *
+ZvbiSlicedWriter_exit(ZvbiSlicedWriterObj *self, PyObject *args)
+{
+    if (!ZvbiSlicedWriter_Close(self)) {
+        return NULL;
+    }
+    Py_RETURN_FALSE;
+}
+
+// ---------------------------------------------------------------------------
+//  Reader class
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    PyObject_HEAD
+    int             fd;
+    vbi_bool        do_close;
+    PyObject *      file;           // reference to file object passed by caller
+    uint8_t *       buf;            // read buffer, or start of the mapped file
+    size_t          buf_size;
+    size_t          buf_start;
+    size_t          buf_end;
+    vbi_bool        is_mapped;
+    vbi_bool        eof;
+    long long       file_offset;    // file offset corresponding to buf[0]
+    double          elapsed;
+    vbi_sliced      lines[ZVBI_SLICED_FILE_MAX_LINES];
+} ZvbiSlicedReaderObj;
+
+static PyObject *
+ZvbiSlicedReader_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    ZvbiSlicedReaderObj * self = (ZvbiSlicedReaderObj *) type->tp_alloc(type, 0);
+    if (self != NULL) {
+        self->fd = -1;
+    }
+    return (PyObject *) self;
+}
+
+static void
+ZvbiSlicedReader_Close(ZvbiSlicedReaderObj * self)
+{
+    if (self->buf != NULL) {
+        if (self->is_mapped) {
+            munmap(self->buf, self->buf_size);
+        }
+        else {
+            PyMem_Free(self->buf);
+        }
+        self->buf = NULL;
+    }
+    if ((self->fd != -1) && self->do_close) {
+        close(self->fd);
+    }
+    self->fd = -1;
+    self->is_mapped = FALSE;
+    self->buf_size = 0;
+    self->buf_start = 0;
+    self->buf_end = 0;
+    Py_CLEAR(self->file);
+}
+
+static void
+ZvbiSlicedReader_dealloc(ZvbiSlicedReaderObj *self)
+{
+    ZvbiSlicedReader_Close(self);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+/*
+ * Map the complete file content into memory. Returns FALSE if the file
+ * cannot be mapped (e.g. a pipe), in which case the caller falls back to
+ * buffered reading.
+ */
+static vbi_bool
+ZvbiSlicedReader_Map(ZvbiSlicedReaderObj * self)
+{
+    struct stat st;
+
+    if ((fstat(self->fd, &st) != 0) || !S_ISREG(st.st_mode)) {
+        return FALSE;
+    }
+    off_t start = lseek(self->fd, 0, SEEK_CUR);
+    if ((start < 0) || (start > st.st_size)) {
+        return FALSE;
+    }
+    if (st.st_size > 0) {
+        void * ptr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, self->fd, 0);
+        if (ptr == MAP_FAILED) {
+            return FALSE;
+        }
+        madvise(ptr, st.st_size, MADV_SEQUENTIAL);
+        self->buf = ptr;
+        self->is_mapped = TRUE;
+    }
+    self->buf_size = st.st_size;
+    self->buf_start = start;
+    self->buf_end = st.st_size;
+    self->eof = TRUE;
+    return TRUE;
+}
+
+static int
+ZvbiSlicedReader_init(ZvbiSlicedReaderObj *self, PyObject *args, PyObject *kwds)
+{
+    static char * kwlist[] = {"file", "mmap", "buffer_size", NULL};
+    PyObject * file = NULL;
+    int use_mmap = FALSE;
+    Py_ssize_t buf_size = ZVBI_SLICED_FILE_DEFAULT_BUF_SIZE;
+
+    // reset state in case the object is already initialized
+    ZvbiSlicedReader_Close(self);
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$pn", kwlist, &file, &use_mmap, &buf_size)) {
+        return -1;
+    }
+    if (buf_size < ZVBI_SLICED_FILE_MAX_FRAME_LEN) {
+        PyErr_Format(PyExc_ValueError, "Buffer size must be at least %d",
+                     ZVBI_SLICED_FILE_MAX_FRAME_LEN);
+        return -1;
+    }
+    self->fd = ZvbiSlicedFile_OpenFd(file, O_RDONLY, &self->do_close);
+    if (self->fd == -1) {
+        return -1;
+    }
+    self->file = file;
+    Py_INCREF(file);
+    self->eof = FALSE;
+    self->file_offset = 0;
+    self->elapsed = 0.0;
+
+    if (!use_mmap || !ZvbiSlicedReader_Map(self)) {
+        self->buf = PyMem_Malloc(buf_size);
+        if (self->buf == NULL) {
+            ZvbiSlicedReader_Close(self);
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->buf_size = buf_size;
+    }
+    return 0;
+}
+
+/*
+ * Read more data into the buffer, after discarding consumed data. Returns
+ * FALSE and raises an exception upon error.
+ */
+static vbi_bool
+ZvbiSlicedReader_Fill(ZvbiSlicedReaderObj * self)
+{
+    if (self->buf_start > 0) {
+        memmove(self->buf, self->buf + self->buf_start, self->buf_end - self->buf_start);
+        self->file_offset += self->buf_start;
+        self->buf_end -= self->buf_start;
+        self->buf_start = 0;
+    }
+    for (;;) {
+        ssize_t rlen;
+
+        Py_BEGIN_ALLOW_THREADS
+        rlen = read(self->fd, self->buf + self->buf_end, self->buf_size - self->buf_end);
+        Py_END_ALLOW_THREADS
+
+        if (rlen >= 0) {
+            self->buf_end += rlen;
+            if (rlen == 0)
+                self->eof = TRUE;
+            break;
+        }
+        else if (errno != EINTR) {
+            PyErr_SetFromErrno(PyExc_OSError);
+            return FALSE;
+        }
+        else if (PyErr_CheckSignals() != 0) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * Parse the next frame and return it as sliced buffer object. Returns NULL
+ * without exception at the end of file.
+ */
+static PyObject *
+ZvbiSlicedReader_Next(ZvbiSlicedReaderObj * self)
+{
+    if (self->buf == NULL) {
+        if (self->fd == -1) {
+            PyErr_SetString(PyExc_ValueError, "I/O operation on closed file");
+        }
+        return NULL;  // else empty mapped file
+    }
+    for (;;) {
+        unsigned n_lines = 0;
+        double delta = 0.0;
+        size_t used = 0;
+
+        int st = ZvbiSlicedFile_ParseFrame(self->buf + self->buf_start,
+                                           self->buf_end - self->buf_start,
+                                           self->lines, ZVBI_SLICED_FILE_MAX_LINES,
+                                           &n_lines, &delta, &used);
+        if (st > 0) {
+            vbi_sliced * data = ZvbiCaptureSlicedBuf_AllocLines(n_lines);
+            if (data == NULL) {
+                return PyErr_NoMemory();
+            }
+            memcpy(data, self->lines, n_lines * sizeof(vbi_sliced));
+
+            // time stored in the file is relative to the preceding frame
+            PyObject * RETVAL = ZvbiCaptureSlicedBuf_FromData(data, n_lines, self->elapsed + delta);
+            if (RETVAL == NULL) {
+                ZvbiCaptureSlicedBuf_FreeLines(data);
+                return NULL;
+            }
+            self->buf_start += used;
+            self->elapsed += delta;
+            return RETVAL;
+        }
+        else if (st < 0) {
+            PyErr_Format(PyExc_ValueError, "Invalid sliced data format at file offset %lld",
+                         self->file_offset + (long long)self->buf_start);
+            return NULL;
+        }
+        else if (self->eof) {
+            if (self->buf_start < self->buf_end) {
+                PyErr_Format(PyExc_ValueError, "Truncated frame at file offset %lld",
+                             self->file_offset + (long long)self->buf_start);
+            }
+            return NULL;
+        }
+        else if (!ZvbiSlicedReader_Fill(self)) {
+            return NULL;
+        }
+    }
+}
+
+static PyObject *
+ZvbiSlicedReader_read(ZvbiSlicedReaderObj *self, PyObject *args)
+{
+    PyObject * RETVAL = ZvbiSlicedReader_Next(self);
+    if ((RETVAL == NULL) && (PyErr_Occurred() == NULL)) {
+        RETVAL = Py_None;
+        Py_INCREF(Py_None);
+    }
+    return RETVAL;
+}
+
+static PyObject *
+ZvbiSlicedReader_Iter(ZvbiSlicedReaderObj *self)
+{
+    Py_INCREF(self);
+    return (PyObject *) self;
+}
+
+static PyObject *
+ZvbiSlicedReader_close(ZvbiSlicedReaderObj *self, PyObject *args)
+{
+    ZvbiSlicedReader_Close(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+ZvbiSlicedReader_enter(ZvbiSlicedReaderObj *self, PyObject *args)
+{
+    Py_INCREF(self);
+    return (PyObject *) self;
+}
+
+static PyObject *
+ZvbiSlicedReader_exit(ZvbiSlicedReaderObj *self, PyObject *args)
+{
+    ZvbiSlicedReader_Close(self);
+    Py_RETURN_FALSE;
+}
+
+// ---------------------------------------------------------------------------
+
+static PyMethodDef ZvbiSlicedWriter_MethodsDef[] =
+{
+    {"write",     (PyCFunction) ZvbiSlicedWriter_write, METH_VARARGS | METH_KEYWORDS, NULL },
+    {"flush",     (PyCFunction) ZvbiSlicedWriter_flush, METH_NOARGS, NULL },
+    {"close",     (PyCFunction) ZvbiSlicedWriter_close, METH_NOARGS, NULL },
+    {"__enter__", (PyCFunction) ZvbiSlicedWriter_enter, METH_NOARGS, NULL },
+    {"__exit__",  (PyCFunction) ZvbiSlicedWriter_exit,  METH_VARARGS, NULL },
+
+    {NULL}  /* Sentinel */
+};
+
+PyTypeObject ZvbiSlicedWriterTypeDef =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "Zvbi.SlicedWriter",
+    .tp_doc = PyDoc_STR("Class for writing sliced data to a file in binary format"),
+    .tp_basicsize = sizeof(ZvbiSlicedWriterObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = ZvbiSlicedWriter_new,
+    .tp_init = (initproc) ZvbiSlicedWriter_init,
+    .tp_dealloc = (destructor) ZvbiSlicedWriter_dealloc,
+    .tp_methods = ZvbiSlicedWriter_MethodsDef,
+};
+
+static PyMethodDef ZvbiSlicedReader_MethodsDef[] =
+{
+    {"read",      (PyCFunction) ZvbiSlicedReader_read,  METH_NOARGS, NULL },
+    {"close",     (PyCFunction) ZvbiSlicedReader_close, METH_NOARGS, NULL },
+    {"__enter__", (PyCFunction) ZvbiSlicedReader_enter, METH_NOARGS, NULL },
+    {"__exit__",  (PyCFunction) ZvbiSlicedReader_exit,  METH_VARARGS, NULL },
+
+    {NULL}  /* Sentinel */
+};
+
+PyTypeObject ZvbiSlicedReaderTypeDef =
+{
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "Zvbi.SlicedReader",
+    .tp_doc = PyDoc_STR("Class for reading sliced data from a file in binary format"),
+    .tp_basicsize = sizeof(ZvbiSlicedReaderObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = ZvbiSlicedReader_new,
+    .tp_init = (initproc) ZvbiSlicedReader_init,
+    .tp_dealloc = (destructor) ZvbiSlicedReader_dealloc,
+    .tp_iter = (getiterfunc) ZvbiSlicedReader_Iter,
+    .tp_iternext = (iternextfunc) ZvbiSlicedReader_Next,
+    .tp_methods = ZvbiSlicedReader_MethodsDef,
+};
+
+int PyInit_SlicedFile(PyObject * module, PyObject * error_base)
+{
+    if ((PyType_Ready(&ZvbiSlicedWriterTypeDef) < 0) ||
+        (PyType_Ready(&ZvbiSlicedReaderTypeDef) < 0))
+    {
+        return -1;
+    }
+
+    // create class type objects
+    Py_INCREF(&ZvbiSlicedWriterTypeDef);
+    if (PyModule_AddObject(module, "SlicedWriter", (PyObject *) &ZvbiSlicedWriterTypeDef) < 0) {
+        Py_DECREF(&ZvbiSlicedWriterTypeDef);
+        return -1;
+    }
+    Py_INCREF(&ZvbiSlicedReaderTypeDef);
+    if (PyModule_AddObject(module, "SlicedReader", (PyObject *) &ZvbiSlicedReaderTypeDef) < 0) {
+        Py_DECREF(&ZvbiSlicedReaderTypeDef);
+        Py_DECREF(&ZvbiSlicedWriterTypeDef);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2006-2020 T. Zoerner.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#if !defined (_PY_ZVBI_SLICED_FILE_H)
+#define _PY_ZVBI_SLICED_FILE_H
+
+// Maximum number of lines per frame supported by the file format
+#define ZVBI_SLICED_FILE_MAX_LINES 255
+
+int ZvbiSlicedFile_ParseFrame(const uint8_t * buf, size_t len,
+                              vbi_sliced * sliced, unsigned max_lines,
+                              unsigned * p_n_lines, double * p_delta, size_t * p_used);
+
+extern PyTypeObject ZvbiSlicedWriterTypeDef;
+extern PyTypeObject ZvbiSlicedReaderTypeDef;
+
+int PyInit_SlicedFile(PyObject * module, PyObject * error_base);
+
+#endif  /* _PY_ZVBI_SLICED_FILE_H */
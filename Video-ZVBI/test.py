@@ -14,12 +14,822 @@
 #
 # For a copy of the GPL refer to <http://www.gnu.org/licenses/>
 
-import Zvbi
+import array
+import os
+import random
+import struct
+import sys
+import tempfile
+import time
+import unittest
 
-# Well, so far we only test if the module loads correctly.
-# For manual testing, see the examples/ sub-directory.
+import Zvbi
 
+# First test if the module loads correctly.
 print("OK module booted, library version %d.%d.%d\n" % (Zvbi.lib_version()))
 
 if not Zvbi.check_lib_version(0, 2, 35):
     print("Library version is outdated")
+
+# The following tests work offline, i.e. without capture device, using
+# sliced data synthesized below. For manual testing with a device, see
+# the examples/ sub-directory.
+
+FRAME_CNT = 50
+
+def ttx_packet(mag, pkt, pgno, text):
+    """Returns a Teletext packet (MRAG and payload, 42 bytes)."""
+    data = bytearray([Zvbi.ham8((mag & 7) | ((pkt & 1) << 3)), Zvbi.ham8(pkt >> 1)])
+    if pkt == 0:
+        # page number units & tens, sub-code and control bits (all zero)
+        data += bytes([Zvbi.ham8(pgno & 0xF), Zvbi.ham8((pgno >> 4) & 0xF)])
+        data += bytes([Zvbi.ham8(0)] * 6)
+        text = text[:32]
+    data += Zvbi.par_str(text.ljust(42 - len(data)))
+    return bytes(data)
+
+def make_frame(frame_idx):
+    """Returns sliced lines of a frame as list of (ident, line_no, data)."""
+    pgno = 0x100 + (frame_idx // 5)
+    lines = [(Zvbi.VBI_SLICED_TELETEXT_B, 7, ttx_packet(1, 0, pgno, "Header %d" % frame_idx)),
+             (Zvbi.VBI_SLICED_TELETEXT_B, 8, ttx_packet(1, 1 + frame_idx % 23, pgno, "Row %d" % frame_idx))]
+    if frame_idx % 10 == 0:
+        lines.append((Zvbi.VBI_SLICED_VPS, 16, bytes(range(frame_idx % 200, frame_idx % 200 + 13))))
+    return lines
+
+def encode_frame(lines, delta=0.04):
+    """Encodes a frame in the binary format of "capture.py --sliced"."""
+    type_idx = {Zvbi.VBI_SLICED_TELETEXT_B: 0, Zvbi.VBI_SLICED_VPS: 2, Zvbi.VBI_SLICED_WSS_625: 3}
+    data = bytearray(b"%f\n" % delta)
+    data.append(len(lines))
+    for ident, line_no, payload in lines:
+        data += bytes([type_idx[ident], line_no & 0xFF, line_no >> 8])
+        data += payload
+    return bytes(data)
+
+def write_sliced_file(path, frame_cnt=FRAME_CNT):
+    """Creates a sliced file with synthesized frames; returns the content."""
+    content = b"".join(encode_frame(make_frame(idx)) for idx in range(frame_cnt))
+    with open(path, "wb") as f:
+        f.write(content)
+    return content
+
+def frame_lines(sliced_buf):
+    """Returns the lines of a sliced buffer with payload truncated to the service size."""
+    size = {Zvbi.VBI_SLICED_TELETEXT_B: 42, Zvbi.VBI_SLICED_VPS: 13, Zvbi.VBI_SLICED_WSS_625: 2}
+    return [(ident, line_no, bytes(data[:size[ident]])) for data, ident, line_no in sliced_buf]
+
+def raw_params():
+    """Returns raw parameters of a typical 625-line capture card."""
+    par = Zvbi.RawParams()
+    par.scanning = 625
+    par.sampling_format = Zvbi.VBI_PIXFMT_YUV420
+    par.sampling_rate = 13500000
+    par.bytes_per_line = 720
+    par.offset = 128
+    par.start_a = 7
+    par.count_a = 17
+    par.start_b = 320
+    par.count_b = 16
+    par.interlaced = False
+    par.synchronous = True
+    return par
+
+
+class SlicedFileFixture(unittest.TestCase):
+    """Base class for tests working on a sliced file with synthesized frames."""
+    frame_cnt = FRAME_CNT
+
+    def setUp(self):
+        self.tmp_dir = tempfile.TemporaryDirectory()
+        self.path = os.path.join(self.tmp_dir.name, "in.dat")
+        self.content = write_sliced_file(self.path, self.frame_cnt)
+
+    def tearDown(self):
+        self.tmp_dir.cleanup()
+
+
+class SlicedFileTest(SlicedFileFixture):
+    def test_read(self):
+        for use_mmap in (False, True):
+            with Zvbi.SlicedReader(self.path, mmap=use_mmap) as rd:
+                frames = list(rd)
+            self.assertEqual(len(frames), FRAME_CNT)
+            for idx, sliced_buf in enumerate(frames):
+                self.assertEqual(frame_lines(sliced_buf), make_frame(idx))
+                self.assertAlmostEqual(sliced_buf.timestamp, (idx + 1) * 0.04)
+
+    def test_round_trip(self):
+        out_path = os.path.join(self.tmp_dir.name, "out.dat")
+        with Zvbi.SlicedWriter(out_path) as wr:
+            for sliced_buf in Zvbi.SlicedReader(self.path):
+                wr.write(sliced_buf)
+        with open(out_path, "rb") as f:
+            self.assertEqual(f.read(), self.content)
+
+        # same via packed buffers
+        with Zvbi.SlicedWriter(out_path) as wr:
+            for sliced_buf in Zvbi.SlicedReader(self.path):
+                wr.write(Zvbi.CompactSlicedBuf(sliced_buf))
+        with open(out_path, "rb") as f:
+            self.assertEqual(f.read(), self.content)
+
+    def test_uneven_spacing(self):
+        # first frame gets the nominal distance, as the writer has no predecessor
+        deltas = [0.04, 0.02, 0.1, 0.04, 0.5, 0.03]
+        content = b"".join(encode_frame(make_frame(idx), delta) for idx, delta in enumerate(deltas))
+        with open(self.path, "wb") as f:
+            f.write(content)
+        with Zvbi.SlicedReader(self.path) as rd:
+            frames = list(rd)
+        self.assertEqual([round(sliced_buf.timestamp, 6) for sliced_buf in frames],
+                         [round(sum(deltas[:idx + 1]), 6) for idx in range(len(deltas))])
+
+        out_path = os.path.join(self.tmp_dir.name, "out.dat")
+        with Zvbi.SlicedWriter(out_path) as wr:
+            for sliced_buf in frames:
+                wr.write(sliced_buf)
+        with open(out_path, "rb") as f:
+            self.assertEqual(f.read(), content)
+
+    def test_file_objects(self):
+        # data written via the file object before must precede the output
+        out_path = os.path.join(self.tmp_dir.name, "out.dat")
+        with open(out_path, "wb") as f:
+            f.write(b"HEAD")
+            wr = Zvbi.SlicedWriter(f)
+            for sliced_buf in Zvbi.SlicedReader(self.path):
+                wr.write(sliced_buf)
+            wr.close()
+
+        # data read ahead into the buffer of the file object must not be skipped
+        with open(out_path, "rb") as f:
+            self.assertEqual(f.read(4), b"HEAD")
+            frames = list(Zvbi.SlicedReader(f))
+        self.assertEqual(len(frames), FRAME_CNT)
+        self.assertEqual(frame_lines(frames[0]), make_frame(0))
+
+    def test_truncated(self):
+        with open(self.path, "wb") as f:
+            f.write(self.content[:-5])
+        rd = Zvbi.SlicedReader(self.path)
+        for idx in range(FRAME_CNT - 1):
+            self.assertIsNotNone(rd.read())
+        with self.assertRaises(ValueError):
+            rd.read()
+
+
+class ReplayTest(SlicedFileFixture):
+    frame_cnt = 5
+
+    def test_replay(self):
+        cap = Zvbi.Capture.Replay(self.path, "sliced")
+        self.assertEqual(frame_lines(cap.read_sliced(0)), make_frame(0))
+        self.assertEqual(frame_lines(cap.pull_sliced(0)), make_frame(1))
+        raw_buf, sliced_buf = cap.pull(0)
+        self.assertIsNone(raw_buf)
+        self.assertEqual(frame_lines(sliced_buf), make_frame(2))
+        cap.read_sliced(0)
+        cap.read_sliced(0)
+        with self.assertRaises(EOFError):
+            cap.read_sliced(1000)
+        with self.assertRaises(EOFError):
+            cap.pull_sliced(1000)
+
+    def test_read_into(self):
+        cap = Zvbi.Capture.Replay(self.path, "sliced")
+        par = cap.parameters()
+        sliced_buf = Zvbi.CaptureSlicedBuf(par.count_a + par.count_b)
+        n_lines, timestamp = cap.read_into(0, sliced=sliced_buf)
+        self.assertEqual(n_lines, len(make_frame(0)))
+        self.assertEqual(frame_lines(sliced_buf), make_frame(0))
+        # buffer is not refilled while exported
+        view = memoryview(sliced_buf)
+        with self.assertRaises(BufferError):
+            cap.read_into(0, sliced=sliced_buf)
+        view.release()
+        cap.read_into(0, sliced=sliced_buf)
+        self.assertEqual(frame_lines(sliced_buf), make_frame(1))
+
+    def test_many_lines(self):
+        # more lines than a capture device would deliver per frame
+        lines = [(Zvbi.VBI_SLICED_TELETEXT_B, 7 + idx, ttx_packet(1, 1 + idx % 23, 0x100, "Row %d" % idx))
+                 for idx in range(100)]
+        with open(self.path, "wb") as f:
+            f.write(encode_frame(lines))
+        cap = Zvbi.Capture.Replay(self.path, "sliced")
+        self.assertEqual(frame_lines(cap.read_sliced(0)), lines)
+
+    def test_realtime(self):
+        cap = Zvbi.Capture.Replay(self.path, "sliced", realtime=True)
+        first = cap.pull_sliced(1000).timestamp
+        # next frame is due only after 40 ms
+        with self.assertRaises(Zvbi.CaptureTimeout):
+            cap.pull_sliced(0)
+        for idx in range(1, 5):
+            sliced_buf = cap.pull_sliced(1000)
+            self.assertEqual(frame_lines(sliced_buf), make_frame(idx))
+            self.assertAlmostEqual(sliced_buf.timestamp - first, idx * 0.04, places=3)
+        # end of file is reported regardless of the timeout
+        with self.assertRaises(EOFError):
+            cap.pull_sliced(0)
+        with self.assertRaises(EOFError):
+            cap.pull_sliced(1000)
+
+    def test_stats(self):
+        cap = Zvbi.Capture.Replay(self.path, "sliced", realtime=True)
+        cap.pull_sliced(1000)
+        with self.assertRaises(Zvbi.CaptureTimeout):
+            cap.pull_sliced(0)
+        for idx in range(1, 5):
+            cap.pull_sliced(1000)
+        # end of file is not counted as error
+        with self.assertRaises(EOFError):
+            cap.pull_sliced(1000)
+        st = cap.stats(reset=True)
+        self.assertEqual(st.frames, 5)
+        self.assertEqual(st.timeouts, 1)
+        self.assertEqual(st.errors, 0)
+        self.assertEqual(st.missed_frames, 0)
+        self.assertEqual(sum(st.delay_hist), 5)
+        self.assertEqual(len(st.delay_hist), len(st.delay_bins) + 1)
+        st = cap.stats()
+        self.assertEqual((st.frames, st.timeouts, st.errors), (0, 0, 0))
+        self.assertEqual(sum(st.delay_hist), 0)
+
+    def test_capture_set(self):
+        # replay provides no file descriptor, so that wait() can only be
+        # tested with capture devices; only construction is covered here
+        caps = [Zvbi.Capture.Replay(self.path, "sliced") for idx in range(2)]
+        with self.assertRaises(Zvbi.CaptureError):
+            Zvbi.CaptureSet(caps)
+        with self.assertRaises(ValueError):
+            Zvbi.CaptureSet([])
+        with self.assertRaises(TypeError):
+            Zvbi.CaptureSet([caps[0], None])
+
+
+class SlicedBufTest(SlicedFileFixture):
+    frame_cnt = 20
+
+    def setUp(self):
+        super().setUp()
+        self.cap = Zvbi.Capture.Replay(self.path, "sliced")
+
+    def test_subscript(self):
+        sliced_buf = self.cap.pull_sliced(0)
+        ref = make_frame(0)
+        self.assertEqual(len(sliced_buf), len(ref))
+        self.assertEqual(frame_lines(sliced_buf[1:]), ref[1:])
+        self.assertEqual(frame_lines(sliced_buf[:0]), [])
+        line = sliced_buf[-1]
+        self.assertEqual((line.ident, line.line_no), ref[-1][:2])
+        with self.assertRaises(IndexError):
+            sliced_buf[len(ref)]
+
+    def test_select(self):
+        sliced_buf = self.cap.pull_sliced(0)
+        ref = make_frame(0)
+        vps = sliced_buf.select(Zvbi.VBI_SLICED_VPS)
+        self.assertEqual(frame_lines(vps), [l for l in ref if l[0] == Zvbi.VBI_SLICED_VPS])
+        self.assertEqual(vps.timestamp, sliced_buf.timestamp)
+        ttx, vps2, wss, cc = sliced_buf.partition()
+        self.assertEqual(frame_lines(ttx), [l for l in ref if l[0] == Zvbi.VBI_SLICED_TELETEXT_B])
+        self.assertEqual(frame_lines(vps2), frame_lines(vps))
+        self.assertEqual((len(wss), len(cc)), (0, 0))
+
+    def test_memoryview(self):
+        sliced_buf = self.cap.pull_sliced(0).detach()
+        view = memoryview(sliced_buf)
+        self.assertEqual(view.itemsize, 64)
+        self.assertEqual(len(view), len(sliced_buf))
+        self.assertTrue(view.readonly)
+        data = view.cast("B")
+        ref = make_frame(0)
+        self.assertEqual(bytes(data[8:8 + 42]), ref[0][2])
+        view.release()
+
+    def test_detach(self):
+        # buffers still referenced upon the next pull are detached implicitly
+        first = self.cap.pull_sliced(0)
+        part = first[1:]
+        explicit = self.cap.pull_sliced(0).detach()
+        exported = memoryview(explicit).cast("B")
+        for idx in range(2, 12):
+            self.cap.pull_sliced(0)
+        self.assertEqual(frame_lines(first), make_frame(0))
+        self.assertEqual(frame_lines(part), make_frame(0)[1:])
+        self.assertEqual(frame_lines(explicit), make_frame(1))
+        self.assertEqual(bytes(exported[8:8 + 42]), make_frame(1)[0][2])
+        del first
+        self.assertEqual(frame_lines(part), make_frame(0)[1:])
+
+    def test_detach_last_owner_ref(self):
+        # the capture context is released by detaching its last buffer
+        sliced_buf = Zvbi.Capture.Replay(self.path, "sliced").pull_sliced(0)
+        part = sliced_buf[1:]
+        self.assertIs(sliced_buf.detach(), sliced_buf)
+        self.assertEqual(frame_lines(sliced_buf), make_frame(0))
+        self.assertEqual(frame_lines(part), make_frame(0)[1:])
+        self.assertEqual(frame_lines(sliced_buf.detach()), make_frame(0))
+
+    def test_export_pulled(self):
+        # memoryviews on pulled buffers must outlive the capture context
+        exported = memoryview(self.cap.pull_sliced(0)).cast("B")
+        exported_part = memoryview(self.cap.pull_sliced(0)[1:]).cast("B")
+        self.cap.pull_sliced(0)
+        del self.cap
+        self.assertEqual(bytes(exported[8:8 + 42]), make_frame(0)[0][2])
+        self.assertEqual(bytes(exported_part[8:8 + 42]), make_frame(1)[1][2])
+
+    def test_constructor(self):
+        sliced_buf = Zvbi.CaptureSlicedBuf(16)
+        self.assertEqual(len(sliced_buf), 0)
+        self.assertEqual(list(sliced_buf), [])
+
+
+class RawBufTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp_dir = tempfile.TemporaryDirectory()
+        self.par = raw_params()
+        self.bpl = self.par.bytes_per_line
+        frame_size = self.bpl * (self.par.count_a + self.par.count_b)
+        rnd = random.Random(2)
+        self.frames = [bytes(rnd.randrange(256) for _ in range(frame_size)) for _ in range(3)]
+        path = os.path.join(self.tmp_dir.name, "in.raw")
+        with open(path, "wb") as f:
+            f.write(b"".join(self.frames))
+        self.cap = Zvbi.Capture.Replay(path, "raw", raw_params=self.par)
+
+    def tearDown(self):
+        self.tmp_dir.cleanup()
+
+    def test_export_pulled(self):
+        # 2-D exports and field views must outlive the capture context
+        lines = memoryview(self.cap.pull_raw(0))
+        second = self.cap.pull_raw(0).field(1)
+        self.cap.pull_raw(0)
+        del self.cap
+        self.assertEqual(lines.shape, (self.par.count_a + self.par.count_b, self.bpl))
+        self.assertEqual(lines.tobytes(), self.frames[0])
+        self.assertEqual(second.shape, (self.par.count_b, self.bpl))
+        self.assertEqual(second.tobytes(), self.frames[1][self.par.count_a * self.bpl:])
+
+
+class DecodeManyTest(SlicedFileFixture):
+    def setUp(self):
+        super().setUp()
+        with Zvbi.SlicedReader(self.path) as rd:
+            self.frames = list(rd)
+
+    def new_decoder(self):
+        vt = Zvbi.ServiceDec()
+        events = []
+        vt.event_handler_register(Zvbi.VBI_EVENT_TTX_PAGE, lambda ev_type, ev: events.append((ev_type, ev)))
+        return vt, events
+
+    def test_sequence(self):
+        vt, ref = self.new_decoder()
+        for sliced_buf in self.frames:
+            vt.decode(sliced_buf)
+
+        vt, events = self.new_decoder()
+        vt.decode_many(self.frames[:7])
+        vt.decode_many(tuple(self.frames[7:]))
+        self.assertEqual(events, ref)
+
+        vt, events = self.new_decoder()
+        vt.decode_many([Zvbi.CompactSlicedBuf(sliced_buf) for sliced_buf in self.frames])
+        self.assertEqual(events, ref)
+
+    def test_block(self):
+        vt, ref = self.new_decoder()
+        for sliced_buf in self.frames:
+            vt.decode_bytes(bytes(sliced_buf), len(sliced_buf), sliced_buf.timestamp)
+
+        block = b"".join(bytes(sliced_buf) for sliced_buf in self.frames)
+        n_lines = [len(sliced_buf) for sliced_buf in self.frames]
+        timestamps = [sliced_buf.timestamp for sliced_buf in self.frames]
+
+        vt, events = self.new_decoder()
+        vt.decode_many(block, n_lines=n_lines, timestamps=timestamps)
+        self.assertEqual(events, ref)
+
+        # trailing unused lines are ignored
+        vt, events = self.new_decoder()
+        vt.decode_many(bytearray(block) + bytes(64 * 3), n_lines=n_lines, timestamps=timestamps)
+        self.assertEqual(events, ref)
+
+    def test_block_format(self):
+        # block is a plain concatenation of "vbi_sliced" structures
+        sliced_buf = self.frames[0]
+        block = b"".join(struct.pack("=II56s", ident, line_no, data) for data, ident, line_no in sliced_buf)
+        self.assertEqual(block, bytes(sliced_buf))
+
+    def test_errors(self):
+        vt, events = self.new_decoder()
+        block = b"".join(bytes(sliced_buf) for sliced_buf in self.frames[:3])
+        n_lines = [len(sliced_buf) for sliced_buf in self.frames[:3]]
+
+        with self.assertRaises(TypeError):
+            vt.decode_many(block, n_lines=n_lines)
+        with self.assertRaises(ValueError):
+            vt.decode_many(block, n_lines=n_lines, timestamps=[0.0, 0.04])
+        with self.assertRaises(ValueError):
+            vt.decode_many(block, n_lines=n_lines[:2] + [n_lines[2] + 1], timestamps=[0.0, 0.04, 0.08])
+        with self.assertRaises(ValueError):
+            vt.decode_many(block, n_lines=[-1, 0, 0], timestamps=[0.0, 0.04, 0.08])
+        with self.assertRaises(TypeError):
+            vt.decode_many(block, n_lines=[1, "x", 0], timestamps=[0.0, 0.04, 0.08])
+        with self.assertRaises(TypeError):
+            vt.decode_many(self.frames[:2] + [b"foo"])
+        with self.assertRaises(TypeError):
+            vt.decode_many(42)
+        # nothing is decoded when parameters are invalid
+        self.assertEqual(events, [])
+
+
+class DeferEventsTest(SlicedFileFixture):
+    def decode_all(self, defer_events):
+        vt = Zvbi.ServiceDec(defer_events=defer_events)
+        log = []
+        def handler(ev_type, ev, user_data):
+            log.append((user_data, ev_type, ev))
+        def last(ev_type, ev):
+            log.append(("last", ev_type, ev))
+            last_cnt = len([ev for ev in log if ev[0] == "last"])
+            if last_cnt == 4:
+                vt.event_handler_unregister(handler, "second")
+            elif last_cnt == 10:
+                vt.event_handler_unregister(last)
+        vt.event_handler_register(Zvbi.VBI_EVENT_TTX_PAGE, handler, "first")
+        vt.event_handler_register(Zvbi.VBI_EVENT_TTX_PAGE, handler, "second")
+        vt.event_handler_register(Zvbi.VBI_EVENT_TTX_PAGE, last)
+        # pulled buffers are overwritten by the next pull, unless detached
+        cap = Zvbi.Capture.Replay(self.path, "sliced")
+        for idx in range(FRAME_CNT):
+            vt.decode(cap.pull_sliced(0))
+        return log
+
+    def test_unregister(self):
+        ref = self.decode_all(False)
+        self.assertEqual(self.decode_all(True), ref)
+        self.assertEqual([ev[0] for ev in ref[:3]], ["first", "second", "last"])
+        self.assertEqual(len([ev for ev in ref if ev[0] == "second"]), 4)
+        self.assertEqual(len([ev for ev in ref if ev[0] == "last"]), 10)
+        self.assertEqual(len([ev for ev in ref if ev[0] == "first"]), 2 * FRAME_CNT + FRAME_CNT // 10)
+
+    def test_decode_bytes(self):
+        events = {}
+        for defer_events in (False, True):
+            vt = Zvbi.ServiceDec(defer_events=defer_events)
+            events[defer_events] = []
+            vt.event_handler_register(Zvbi.VBI_EVENT_TTX_PAGE,
+                                      lambda ev_type, ev, log=events[defer_events]: log.append(ev))
+            cap = Zvbi.Capture.Replay(self.path, "sliced")
+            for idx in range(FRAME_CNT):
+                sliced_buf = cap.pull_sliced(0)
+                vt.decode_bytes(sliced_buf, len(sliced_buf), sliced_buf.timestamp)
+        self.assertEqual(events[True], events[False])
+        self.assertNotEqual(events[False], [])
+
+    def test_refcount(self):
+        def handler(ev_type, ev, user_data):
+            pass
+        ref_cnt = sys.getrefcount(handler)
+        vt = Zvbi.ServiceDec(defer_events=True)
+        for idx in range(10):
+            vt.event_handler_register(Zvbi.VBI_EVENT_TTX_PAGE, handler, idx)
+        with Zvbi.SlicedReader(self.path) as rd:
+            vt.decode_many(list(rd))
+        for idx in range(0, 10, 2):
+            vt.event_handler_unregister(handler, idx)
+        del vt
+        self.assertEqual(sys.getrefcount(handler), ref_cnt)
+
+
+class RawEncoderTest(SlicedFileFixture):
+    frame_cnt = 20
+
+    def setUp(self):
+        super().setUp()
+        self.par = raw_params()
+        self.frame_size = self.par.bytes_per_line * (self.par.count_a + self.par.count_b)
+        with Zvbi.SlicedReader(self.path) as rd:
+            self.frames = list(rd)
+
+    def decode(self, raw_buf):
+        # new decoder per frame, so that results do not depend on line learning
+        raw_dec = Zvbi.RawDec(self.par)
+        raw_dec.add_services(Zvbi.VBI_SLICED_TELETEXT_B | Zvbi.VBI_SLICED_VPS)
+        return raw_dec.decode(raw_buf)
+
+    def test_round_trip(self):
+        raw_enc = Zvbi.RawEncoder(self.par)
+        for noise in (0, 10):
+            for idx, sliced_buf in enumerate(self.frames):
+                raw_buf = raw_enc.encode(sliced_buf, noise=noise)
+                self.assertEqual(len(raw_buf), self.frame_size)
+                self.assertEqual(raw_buf.timestamp, sliced_buf.timestamp)
+                self.assertEqual(frame_lines(self.decode(raw_buf)), make_frame(idx))
+
+    def test_seed(self):
+        raw_enc = Zvbi.RawEncoder(self.par)
+        ref = bytes(raw_enc.encode(self.frames[0], noise=10, seed=5))
+        self.assertEqual(bytes(raw_enc.encode(self.frames[0], noise=10, seed=5)), ref)
+        self.assertNotEqual(bytes(raw_enc.encode(self.frames[0], noise=10, seed=6)), ref)
+        self.assertNotEqual(bytes(raw_enc.encode(self.frames[0])), ref)
+
+        # without seed, the noise differs between frames, but the sequence is reproducible
+        def encode_all():
+            raw_enc = Zvbi.RawEncoder(self.par)
+            return [bytes(raw_enc.encode(self.frames[0], noise=10)) for _ in range(3)]
+        seq = encode_all()
+        self.assertEqual(encode_all(), seq)
+        self.assertEqual(len(set(seq)), 3)
+
+    def wss_frames(self):
+        """Returns frames with an additional WSS line, as expected lines and raw frames."""
+        ref = [make_frame(idx) + [(Zvbi.VBI_SLICED_WSS_625, 23, bytes([(idx * 37) & 0xFF, (idx * 11) & 0x3F]))]
+               for idx in range(self.frame_cnt)]
+        path = os.path.join(self.tmp_dir.name, "wss.dat")
+        with open(path, "wb") as f:
+            f.write(b"".join(encode_frame(lines) for lines in ref))
+        raw_enc = Zvbi.RawEncoder(self.par)
+        with Zvbi.SlicedReader(path) as rd:
+            raw_frames = [bytes(raw_enc.encode(sliced_buf, noise=10)) for sliced_buf in rd]
+        return ref, raw_frames
+
+    def test_fast_slicer(self):
+        services = Zvbi.VBI_SLICED_TELETEXT_B | Zvbi.VBI_SLICED_VPS | Zvbi.VBI_SLICED_WSS_625
+        ref, raw_frames = self.wss_frames()
+        for raw, lines in zip(raw_frames, ref):
+            raw_dec = Zvbi.RawDec(self.par)
+            raw_dec.add_services(services)
+            self.assertEqual(raw_dec.slicer, "libzvbi")
+            self.assertEqual(frame_lines(raw_dec.decode(raw)), lines)
+
+        raw_dec = Zvbi.RawDec(self.par, fast_slicer=True)
+        raw_dec.add_services(services)
+        self.assertNotEqual(raw_dec.slicer, "libzvbi")
+        self.assertEqual([frame_lines(raw_dec.decode(raw)) for raw in raw_frames], ref)
+        self.assertEqual([frame_lines(sliced_buf) for sliced_buf in raw_dec.decode_many(raw_frames)], ref)
+
+        for threads in (1, 3):
+            raw_dec = Zvbi.ParallelRawDec(self.par, threads=threads, fast_slicer=True)
+            raw_dec.add_services(services)
+            self.assertNotEqual(raw_dec.slicer, "libzvbi")
+            self.assertEqual([frame_lines(sliced_buf) for sliced_buf in raw_dec.decode_many(raw_frames)], ref)
+
+    def test_fast_slicer_fallback(self):
+        raw_dec = Zvbi.RawDec(self.par, fast_slicer=True)
+        raw_dec.add_services(Zvbi.VBI_SLICED_TELETEXT_B | Zvbi.VBI_SLICED_VPS)
+        self.assertNotEqual(raw_dec.slicer, "libzvbi")
+        # services not supported by the built-in slicer select the one of libzvbi
+        raw_dec.add_services(Zvbi.VBI_SLICED_CAPTION_625)
+        self.assertEqual(raw_dec.slicer, "libzvbi")
+        raw_buf = Zvbi.RawEncoder(self.par).encode(self.frames[0])
+        self.assertEqual(frame_lines(raw_dec.decode(raw_buf)), make_frame(0))
+        raw_dec.remove_services(Zvbi.VBI_SLICED_CAPTION_625)
+        self.assertNotEqual(raw_dec.slicer, "libzvbi")
+
+
+class PollEventsTest(SlicedFileFixture):
+    def setUp(self):
+        super().setUp()
+        with Zvbi.SlicedReader(self.path) as rd:
+            self.frames = list(rd)
+        # same events are delivered via handler to a second decoder for reference
+        self.vt_ref = Zvbi.ServiceDec()
+        self.ref = []
+        self.vt_ref.event_handler_register(Zvbi.VBI_EVENT_TTX_PAGE, lambda ev_type, ev: self.ref.append((ev_type, ev)))
+        self.vt = Zvbi.ServiceDec()
+        self.vt.event_poll_register(Zvbi.VBI_EVENT_TTX_PAGE)
+
+    def decode(self, sliced_buf, timestamp=None):
+        if timestamp is None:
+            timestamp = sliced_buf.timestamp
+        for vt in (self.vt_ref, self.vt):
+            vt.decode_bytes(bytes(sliced_buf), len(sliced_buf), timestamp)
+
+    @staticmethod
+    def compact(ev_type, ev):
+        flags = (1 if ev.roll_header else 0) | (2 if ev.header_update else 0) | (4 if ev.clock_update else 0)
+        return (ev_type, ev.pgno, ev.subno, flags)
+
+    def test_list(self):
+        events = []
+        for sliced_buf in self.frames:
+            self.decode(sliced_buf)
+            events += self.vt.poll_events()
+        self.assertNotEqual(self.ref, [])
+        self.assertEqual(events, self.ref)
+        self.assertEqual(self.vt.poll_events(), [])
+
+    def test_compact(self):
+        records = []
+        for sliced_buf in self.frames:
+            self.decode(sliced_buf)
+            view = self.vt.poll_events(compact=True)
+            self.assertEqual(view.format, "I")
+            records += [tuple(rec) for rec in view.tolist()]
+        self.assertEqual(records, [self.compact(*ev) for ev in self.ref])
+        self.assertEqual(len(self.vt.poll_events(compact=True)), 0)
+
+    def test_max(self):
+        for sliced_buf in self.frames:
+            self.decode(sliced_buf)
+        self.assertGreater(len(self.ref), 5)
+        self.assertEqual(self.vt.poll_events(max=0), [])
+        self.assertEqual(self.vt.poll_events(max=3), self.ref[:3])
+        view = self.vt.poll_events(max=2, compact=True)
+        self.assertEqual(view.tolist(), [list(self.compact(*ev)) for ev in self.ref[3:5]])
+        self.assertEqual(self.vt.poll_events(), self.ref[5:])
+        with self.assertRaises(ValueError):
+            self.vt.poll_events(max=-1)
+
+    def test_limit(self):
+        # without polling, events beyond the queue limit are lost
+        loop = 0
+        while len(self.ref) <= 4096 + 10:
+            for sliced_buf in self.frames:
+                self.decode(sliced_buf, sliced_buf.timestamp + loop * FRAME_CNT * 0.04)
+            loop += 1
+        with self.assertRaises(Zvbi.ServiceDecError):
+            self.vt.poll_events(max=10)
+        # the error is reported once, followed by the events kept in the queue
+        self.assertEqual(self.vt.poll_events(max=10), self.ref[:10])
+        self.assertEqual(self.vt.poll_events(), self.ref[10:4096])
+        self.assertEqual(self.vt.poll_events(), [])
+        # queue accepts events again after draining
+        ref_cnt = len(self.ref)
+        for sliced_buf in self.frames:
+            self.decode(sliced_buf, sliced_buf.timestamp + loop * FRAME_CNT * 0.04)
+        self.assertEqual(self.vt.poll_events(), self.ref[ref_cnt:])
+
+
+class PageFilterTest(SlicedFileFixture):
+    def setUp(self):
+        super().setUp()
+        with Zvbi.SlicedReader(self.path) as rd:
+            self.frames = list(rd)
+        self.ref = self.decode_all(None)
+
+    def decode_all(self, pages, poll=False):
+        vt = Zvbi.ServiceDec()
+        events = []
+        if poll:
+            vt.event_poll_register(Zvbi.VBI_EVENT_TTX_PAGE, pages=pages)
+        else:
+            vt.event_handler_register(Zvbi.VBI_EVENT_TTX_PAGE, lambda ev_type, ev: events.append(ev), pages=pages)
+        for sliced_buf in self.frames:
+            vt.decode(sliced_buf)
+            if poll:
+                events += [ev for ev_type, ev in vt.poll_events()]
+        return events
+
+    def ref_pages(self, pgnos):
+        return [ev for ev in self.ref if ev.pgno in pgnos]
+
+    def test_pgno(self):
+        self.assertEqual({ev.pgno for ev in self.ref}, set(range(0x100, 0x10A)))
+        self.assertEqual(self.decode_all({0x101, 0x105}), self.ref_pages({0x101, 0x105}))
+        self.assertEqual(self.decode_all([0x101, 0x105, 0x8FF]), self.ref_pages({0x101, 0x105}))
+        self.assertEqual(self.decode_all(range(0x102, 0x104)), self.ref_pages({0x102, 0x103}))
+        self.assertEqual(self.decode_all(set()), [])
+
+    def test_bitmap(self):
+        bitmap = bytearray(288)
+        for pgno in (0x100, 0x109):
+            bitmap[pgno >> 3] |= 1 << (pgno & 7)
+        ref = self.ref_pages({0x100, 0x109})
+        self.assertEqual(self.decode_all(bitmap), ref)
+        self.assertEqual(self.decode_all(bytes(bitmap)), ref)
+        self.assertEqual(self.decode_all(memoryview(bitmap)), ref)
+        self.assertEqual(self.decode_all(array.array("B", bitmap)), ref)
+        # shorter bitmaps do not enable higher pages
+        self.assertEqual(self.decode_all(bytes(bitmap[:0x109 >> 3])), self.ref_pages({0x100}))
+        # arrays of 16-bit integers are page numbers, not bitmaps
+        self.assertEqual(self.decode_all(array.array("H", [0x107, 0x108])), self.ref_pages({0x107, 0x108}))
+
+    def test_subno(self):
+        self.assertEqual({ev.subno for ev in self.ref}, {0})
+        self.assertEqual(self.decode_all({(0x103, 0), (0x104, 1)}), self.ref_pages({0x103}))
+        self.assertEqual(self.decode_all([0x101, (0x104, 0)]), self.ref_pages({0x101, 0x104}))
+
+    def test_errors(self):
+        vt = Zvbi.ServiceDec()
+        for pages in ({0xFF}, {0x900}, [(0x50, 0)], [-1], bytes(289)):
+            with self.assertRaises(ValueError):
+                vt.event_handler_register(Zvbi.VBI_EVENT_TTX_PAGE, lambda ev_type, ev: None, pages=pages)
+            with self.assertRaises(ValueError):
+                vt.event_poll_register(Zvbi.VBI_EVENT_TTX_PAGE, pages=pages)
+        for pages in (42, ["foo"], [(0x100,)]):
+            with self.assertRaises(TypeError):
+                vt.event_handler_register(Zvbi.VBI_EVENT_TTX_PAGE, lambda ev_type, ev: None, pages=pages)
+
+    def test_poll(self):
+        self.assertEqual(self.decode_all(None, poll=True), self.ref)
+        self.assertEqual(self.decode_all({0x101, (0x103, 0)}, poll=True), self.ref_pages({0x101, 0x103}))
+        bitmap = bytearray(288)
+        bitmap[0x106 >> 3] |= 1 << (0x106 & 7)
+        self.assertEqual(self.decode_all(bitmap, poll=True), self.ref_pages({0x106}))
+        self.assertEqual(self.decode_all(array.array("H", [0x107]), poll=True), self.ref_pages({0x107}))
+
+
+class RawDecManyTest(unittest.TestCase):
+    def setUp(self):
+        self.par = raw_params()
+        self.frame_size = self.par.bytes_per_line * (self.par.count_a + self.par.count_b)
+        rnd = random.Random(1)
+        self.frames = [bytes(rnd.randrange(256) for _ in range(self.frame_size)) for _ in range(8)]
+
+    def new_decoder(self):
+        raw_dec = Zvbi.RawDec(self.par)
+        raw_dec.add_services(Zvbi.VBI_SLICED_TELETEXT_B | Zvbi.VBI_SLICED_VPS)
+        return raw_dec
+
+    def reference(self):
+        raw_dec = self.new_decoder()
+        return [list(raw_dec.decode(frame)) for frame in self.frames]
+
+    def test_sequence(self):
+        ref = self.reference()
+        result = self.new_decoder().decode_many(self.frames)
+        self.assertIsInstance(result, tuple)
+        self.assertEqual([list(sliced_buf) for sliced_buf in result], ref)
+
+    def test_block(self):
+        ref = self.reference()
+        result = self.new_decoder().decode_many(b"".join(self.frames), timestamp=10.0)
+        self.assertEqual([list(sliced_buf) for sliced_buf in result], ref)
+        self.assertEqual([round(sliced_buf.timestamp, 3) for sliced_buf in result],
+                         [round(10.0 + idx * 0.04, 3) for idx in range(len(self.frames))])
+
+    def test_out(self):
+        ref = self.reference()
+        n_lines = self.par.count_a + self.par.count_b
+        out = Zvbi.CaptureSlicedBuf(n_lines * len(self.frames))
+        result = self.new_decoder().decode_many(self.frames, out=out)
+        self.assertEqual([list(sliced_buf) for sliced_buf in result], ref)
+        self.assertEqual(list(out), [line for lines in ref for line in lines])
+        # buffer cannot be refilled while views on the previous batch exist
+        with self.assertRaises(BufferError):
+            self.new_decoder().decode_many(self.frames, out=out)
+        del result
+        self.new_decoder().decode_many(self.frames, out=out)
+
+    def test_errors(self):
+        raw_dec = self.new_decoder()
+        with self.assertRaises(ValueError):
+            raw_dec.decode_many(b"".join(self.frames) + b"x")
+        with self.assertRaises(Zvbi.RawDecError):
+            raw_dec.decode_many([self.frames[0], self.frames[1][:-1]])
+        with self.assertRaises(ValueError):
+            raw_dec.decode_many(self.frames, out=Zvbi.CaptureSlicedBuf(16))
+
+    def test_parallel(self):
+        ref = self.reference()
+        for threads in (1, 3, 16):
+            raw_dec = Zvbi.ParallelRawDec(self.par, threads=threads)
+            raw_dec.add_services(Zvbi.VBI_SLICED_TELETEXT_B | Zvbi.VBI_SLICED_VPS)
+            # worker threads are reused across batches
+            for loop in range(3):
+                result = raw_dec.decode_many(self.frames)
+                self.assertEqual([list(sliced_buf) for sliced_buf in result], ref)
+            result = raw_dec.decode_many(b"".join(self.frames[:2]))
+            self.assertEqual([list(sliced_buf) for sliced_buf in result], ref[:2])
+            with self.assertRaises(Zvbi.RawDecError):
+                raw_dec.decode_many([self.frames[0], self.frames[1][:-1]])
+            del raw_dec
+
+
+class CaptureThreadTest(SlicedFileFixture):
+    def setUp(self):
+        super().setUp()
+        self.ref = [make_frame(idx) for idx in range(FRAME_CNT)]
+
+    def test_block(self):
+        # queue is much smaller than the file, so that the ring index wraps
+        thr = Zvbi.CaptureThread(Zvbi.Capture.Replay(self.path, "sliced"), slots=3, policy="block")
+        self.assertEqual([frame_lines(sliced_buf) for sliced_buf in thr], self.ref)
+        self.assertEqual(thr.frames, FRAME_CNT)
+        self.assertEqual(thr.dropped, 0)
+        self.assertEqual(thr.pending, 0)
+        self.assertFalse(thr.running)
+        with self.assertRaises(EOFError):
+            thr.get(timeout_ms=0)
+
+    def test_drop(self):
+        for policy, first in (("drop_newest", 0), ("drop_oldest", FRAME_CNT - 8)):
+            thr = Zvbi.CaptureThread(Zvbi.Capture.Replay(self.path, "sliced"), slots=5, policy=policy)
+            while thr.running:
+                time.sleep(0.01)
+            self.assertEqual(thr.frames, FRAME_CNT)
+            self.assertEqual(thr.pending, 8)
+            self.assertEqual(thr.dropped, FRAME_CNT - 8)
+            self.assertEqual([frame_lines(sliced_buf) for sliced_buf in thr], self.ref[first : first + 8])
+
+
+if __name__ == "__main__":
+    unittest.main()